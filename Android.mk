@@ -54,6 +54,7 @@ LOCAL_SRC_FILES := \
 	src/queue.c \
 	src/resample.c \
 	src/system.c \
+	src/task.c \
 	src/thread.c \
 	src/tlocal.c \
 	src/version.c \
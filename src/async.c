@@ -29,7 +29,8 @@ struct async_state {
 };
 
 static MTY_Atomic32 ASYNC_GLOCK;
-static MTY_ThreadPool *ASYNC_CTX;
+static MTY_AtomicPtr ASYNC_CTX;
+static MTY_Pool *ASYNC_STATES;
 
 static void http_async_free_state(void *opaque)
 {
@@ -47,16 +48,29 @@ static void http_async_free_state(void *opaque)
 
 		MTY_Free(s->req.method);
 		MTY_Free(s->res.body);
-		MTY_Free(s);
+		MTY_PoolFree(ASYNC_STATES, s);
 	}
 }
 
+static MTY_ThreadPool *http_async_pool(void)
+{
+	return MTY_AtomicPtrGet(&ASYNC_CTX, MTY_MEMORY_ORDER_ACQUIRE);
+}
+
 void MTY_HttpAsyncCreate(uint32_t maxThreads)
 {
+	// Only take the global lock the first time
+	if (http_async_pool())
+		return;
+
 	MTY_GlobalLock(&ASYNC_GLOCK);
 
-	if (!ASYNC_CTX)
-		ASYNC_CTX = MTY_ThreadPoolCreate(maxThreads);
+	if (!http_async_pool()) {
+		ASYNC_STATES = MTY_PoolCreate(sizeof(struct async_state));
+
+		MTY_AtomicPtrSet(&ASYNC_CTX, MTY_ThreadPoolCreateQueued(maxThreads, maxThreads),
+			MTY_MEMORY_ORDER_RELEASE);
+	}
 
 	MTY_GlobalUnlock(&ASYNC_GLOCK);
 }
@@ -65,7 +79,9 @@ void MTY_HttpAsyncDestroy(void)
 {
 	MTY_GlobalLock(&ASYNC_GLOCK);
 
-	MTY_ThreadPoolDestroy(&ASYNC_CTX, http_async_free_state);
+	MTY_ThreadPool *pool = MTY_AtomicPtrExchange(&ASYNC_CTX, NULL, MTY_MEMORY_ORDER_ACQ_REL);
+	MTY_ThreadPoolDestroy(&pool, http_async_free_state);
+	MTY_PoolDestroy(&ASYNC_STATES);
 
 	MTY_GlobalUnlock(&ASYNC_GLOCK);
 }
@@ -96,13 +112,14 @@ static void http_async_thread(void *opaque)
 void MTY_HttpAsyncRequest(uint32_t *index, const char *url, const char *method, const char *headers,
 	const void *body, size_t bodySize, const char *proxy, uint32_t timeout, bool image)
 {
-	if (!ASYNC_CTX)
+	MTY_ThreadPool *pool = http_async_pool();
+	if (!pool)
 		return;
 
 	if (*index != 0)
-		MTY_ThreadPoolDetach(ASYNC_CTX, *index, http_async_free_state);
+		MTY_ThreadPoolDetach(pool, *index, http_async_free_state);
 
-	struct async_state *s = MTY_Alloc(1, sizeof(struct async_state));
+	struct async_state *s = MTY_PoolAlloc(ASYNC_STATES);
 	s->timeout = timeout;
 	s->image = image;
 
@@ -113,7 +130,7 @@ void MTY_HttpAsyncRequest(uint32_t *index, const char *url, const char *method,
 	s->req.body = body ? MTY_Dup(body, bodySize) : NULL;
 	s->req.proxy = proxy ? MTY_Strdup(proxy) : NULL;
 
-	*index = MTY_ThreadPoolDispatch(ASYNC_CTX, http_async_thread, s);
+	*index = MTY_ThreadPoolDispatch(pool, http_async_thread, s);
 
 	if (*index == 0) {
 		MTY_Log("Failed to start %s", url);
@@ -123,7 +140,8 @@ void MTY_HttpAsyncRequest(uint32_t *index, const char *url, const char *method,
 
 MTY_Async MTY_HttpAsyncPoll(uint32_t index, void **response, size_t *size, uint16_t *status)
 {
-	if (!ASYNC_CTX)
+	MTY_ThreadPool *pool = http_async_pool();
+	if (!pool)
 		return MTY_ASYNC_ERROR;
 
 	if (index == 0)
@@ -131,7 +149,7 @@ MTY_Async MTY_HttpAsyncPoll(uint32_t index, void **response, size_t *size, uint1
 
 	struct async_state *s = NULL;
 	MTY_Async r = MTY_ASYNC_DONE;
-	MTY_Async pstatus = MTY_ThreadPoolPoll(ASYNC_CTX, index, (void **) &s);
+	MTY_Async pstatus = MTY_ThreadPoolPoll(pool, index, (void **) &s);
 
 	if (pstatus == MTY_ASYNC_OK) {
 		*response = s->res.body;
@@ -149,9 +167,10 @@ MTY_Async MTY_HttpAsyncPoll(uint32_t index, void **response, size_t *size, uint1
 
 void MTY_HttpAsyncClear(uint32_t *index)
 {
-	if (!ASYNC_CTX)
+	MTY_ThreadPool *pool = http_async_pool();
+	if (!pool)
 		return;
 
-	MTY_ThreadPoolDetach(ASYNC_CTX, *index, http_async_free_state);
+	MTY_ThreadPoolDetach(pool, *index, http_async_free_state);
 	*index = 0;
 }
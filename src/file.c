@@ -96,30 +96,38 @@ bool MTY_AppendTextToFile(const char *path, const char *fmt, ...)
 	return r;
 }
 
+// Names and paths of a file list live in one arena that is freed in one go
+
+MTY_FileDesc *mty_file_list_add(struct file_list *ctx)
+{
+	if (ctx->fl.len == ctx->cap) {
+		ctx->cap = ctx->cap > 0 ? ctx->cap * 2 : 32;
+		ctx->fl.files = MTY_Realloc(ctx->fl.files, ctx->cap, sizeof(MTY_FileDesc));
+	}
+
+	MTY_FileDesc *desc = &ctx->fl.files[ctx->fl.len++];
+	memset(desc, 0, sizeof(MTY_FileDesc));
+
+	return desc;
+}
+
 void MTY_FreeFileList(MTY_FileList **fileList)
 {
 	if (!fileList || !*fileList)
 		return;
 
-	for (uint32_t x = 0; x < (*fileList)->len; x++) {
-		MTY_Free((*fileList)->files[x].name);
-		MTY_Free((*fileList)->files[x].path);
-	}
+	struct file_list *ctx = (struct file_list *) *fileList;
 
-	MTY_Free((*fileList)->files);
+	MTY_ArenaDestroy(&ctx->arena);
+	MTY_Free(ctx->fl.files);
 
-	MTY_Free(*fileList);
+	MTY_Free(ctx);
 	*fileList = NULL;
 }
 
 const char *MTY_JoinPath(const char *path0, const char *path1)
 {
-	char *path = MTY_SprintfD("%s%c%s", path0, FSUTIL_DELIM, path1);
-	char *local = mty_tlocal_strcpy(path);
-
-	MTY_Free(path);
-
-	return local;
+	return MTY_SprintfDL("%s%c%s", path0, FSUTIL_DELIM, path1);
 }
 
 const char *MTY_GetFileName(const char *path, bool extension)
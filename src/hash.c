@@ -2,6 +2,8 @@
 // If a copy of the MIT License was not distributed with this file,
 // You can obtain one at https://spdx.org/licenses/MIT.html.
 
+#define _DEFAULT_SOURCE // pthread_rwlock_t
+
 #include "matoya.h"
 
 #include <stdlib.h>
@@ -9,29 +11,328 @@
 #include <string.h>
 #include <inttypes.h>
 
-#define HASH_DEFAULT_BUCKETS 100
+#include "rwlock.h"
+#include "tlocal.h"
+
+// Open addressing with Robin Hood linear probing. Each slot has a control byte
+// that is either empty, deleted, or 7 bits of the key's hash, so most mismatches
+// are rejected without touching the key. Within a cluster keys stay sorted by
+// probe distance, ties broken by hash, so as long as nothing has been removed the
+// iteration order only depends on the set of keys and the table size, not on the
+// order they were inserted.
+
+// Keys live in a 16 byte union whose last byte is the key kind. Integer keys and
+// strings up to 14 characters are stored inline and never allocate. Longer strings
+// are duplicated, or in interned mode shared through a process wide refcounted
+// pool so documents that repeat the same key names store each one once.
+
+#define HASH_MIN_SLOTS 16
+#define HASH_INLINE_MAX 14
+
+#define HASH_CTRL_EMPTY   0x80
+#define HASH_CTRL_DELETED 0xFE
+
+enum hash_kind {
+	HASH_KIND_NONE     = 0,
+	HASH_KIND_INT      = 1,
+	HASH_KIND_INLINE   = 2,
+	HASH_KIND_HEAP     = 3,
+	HASH_KIND_INTERNED = 4,
+};
 
-struct hash_node {
-	char *key;
+struct hash_slot {
+	uint64_t hash;
 	void *val;
-};
 
-struct hash_bucket {
-	uint32_t num_nodes;
-	struct hash_node *nodes;
+	union {
+		char *str;
+		int64_t i;
+		char buf[HASH_INLINE_MAX + 2];
+	} key;
 };
 
+#define HASH_KIND(s) ((s)->key.buf[HASH_INLINE_MAX + 1])
+
 struct MTY_Hash {
-	uint32_t num_buckets;
-	struct hash_bucket *buckets;
+	uint32_t mask;
+	uint32_t len;
+	uint32_t deleted;
+	bool interned;
+	uint8_t *ctrl;
+	struct hash_slot *slots;
 };
 
+static MTY_Atomic32 HASH_INTERN_LOCK;
+static MTY_Hash *HASH_INTERN;
+
+static uint64_t hash_string(const char *key)
+{
+	// FNV-1a followed by a finalizer so the low bits used for indexing are well mixed
+	uint64_t h = 0xCBF29CE484222325;
+
+	for (const uint8_t *c = (const uint8_t *) key; *c; c++)
+		h = (h ^ *c) * 0x100000001B3;
+
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCD;
+	h ^= h >> 33;
+
+	return h;
+}
+
+static uint64_t hash_int(int64_t key)
+{
+	// splitmix64 finalizer
+	uint64_t h = (uint64_t) key;
+
+	h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9;
+	h = (h ^ (h >> 27)) * 0x94D049BB133111EB;
+	h ^= h >> 31;
+
+	return h;
+}
+
+static uint8_t hash_h2(uint64_t hash)
+{
+	return (uint8_t) (hash >> 57);
+}
+
+static void hash_alloc(MTY_Hash *ctx, uint32_t num_slots)
+{
+	ctx->mask = num_slots - 1;
+	ctx->ctrl = MTY_Alloc(num_slots, 1);
+	ctx->slots = MTY_Alloc(num_slots, sizeof(struct hash_slot));
+
+	memset(ctx->ctrl, HASH_CTRL_EMPTY, num_slots);
+}
+
+static uint32_t hash_dist(MTY_Hash *ctx, uint64_t hash, uint32_t i)
+{
+	return (i - (uint32_t) hash) & ctx->mask;
+}
+
+static bool hash_richer(MTY_Hash *ctx, struct hash_slot *s, uint32_t i, uint64_t hash, uint32_t dist)
+{
+	// True if the key in slot i would have been displaced by a key with this hash
+	uint32_t sdist = hash_dist(ctx, s->hash, i);
+
+	return sdist < dist || (sdist == dist && s->hash > hash);
+}
+
+static void hash_insert(MTY_Hash *ctx, struct hash_slot *slot)
+{
+	struct hash_slot cur = *slot;
+	uint32_t i = (uint32_t) cur.hash & ctx->mask;
+
+	for (uint32_t dist = 0; ctx->ctrl[i] != HASH_CTRL_EMPTY; i = (i + 1) & ctx->mask, dist++) {
+		if (ctx->ctrl[i] == HASH_CTRL_DELETED)
+			continue;
+
+		if (hash_richer(ctx, &ctx->slots[i], i, cur.hash, dist)) {
+			struct hash_slot tmp = ctx->slots[i];
+			ctx->slots[i] = cur;
+			ctx->ctrl[i] = hash_h2(cur.hash);
+
+			cur = tmp;
+			dist = hash_dist(ctx, cur.hash, i);
+		}
+	}
+
+	ctx->slots[i] = cur;
+	ctx->ctrl[i] = hash_h2(cur.hash);
+}
+
+static void hash_resize(MTY_Hash *ctx, uint32_t num_slots)
+{
+	uint8_t *ctrl = ctx->ctrl;
+	struct hash_slot *slots = ctx->slots;
+	uint32_t old_slots = ctx->mask + 1;
+
+	hash_alloc(ctx, num_slots);
+
+	// Cached hashes mean the keys themselves are never touched while rehashing
+	for (uint32_t x = 0; x < old_slots; x++)
+		if (!(ctrl[x] & HASH_CTRL_EMPTY))
+			hash_insert(ctx, &slots[x]);
+
+	ctx->deleted = 0;
+
+	MTY_Free(slots);
+	MTY_Free(ctrl);
+}
+
+static void hash_reserve(MTY_Hash *ctx)
+{
+	uint32_t num_slots = ctx->mask + 1;
+
+	// Keep the load factor including deleted slots at or below 7/8
+	if ((uint64_t) (ctx->len + ctx->deleted + 1) * 8 <= (uint64_t) num_slots * 7)
+		return;
+
+	// Mostly tombstones, rehash in place instead of growing
+	hash_resize(ctx, ctx->len * 2 < num_slots ? num_slots : num_slots * 2);
+}
+
+static const char *hash_key_str(const struct hash_slot *s)
+{
+	switch (HASH_KIND(s)) {
+		case HASH_KIND_INLINE:
+			return s->key.buf;
+		case HASH_KIND_HEAP:
+		case HASH_KIND_INTERNED:
+			return s->key.str;
+	}
+
+	return NULL;
+}
+
+static bool hash_match(const struct hash_slot *s, const char *key, int64_t ikey)
+{
+	if (!key)
+		return HASH_KIND(s) == HASH_KIND_INT && s->key.i == ikey;
+
+	// Interned keys and keys returned by MTY_HashGetNextKey match by pointer
+	const char *skey = hash_key_str(s);
+
+	return skey && (skey == key || !strcmp(skey, key));
+}
+
+static int64_t hash_find(MTY_Hash *ctx, const char *key, int64_t ikey, uint64_t hash)
+{
+	uint8_t h2 = hash_h2(hash);
+	uint32_t i = (uint32_t) hash & ctx->mask;
+
+	for (uint32_t dist = 0; ctx->ctrl[i] != HASH_CTRL_EMPTY; i = (i + 1) & ctx->mask, dist++) {
+		if (ctx->ctrl[i] == HASH_CTRL_DELETED)
+			continue;
+
+		struct hash_slot *s = &ctx->slots[i];
+
+		if (ctx->ctrl[i] == h2 && s->hash == hash && hash_match(s, key, ikey))
+			return i;
+
+		// The key would have been stored here or earlier
+		if (hash_richer(ctx, s, i, hash, dist))
+			break;
+	}
+
+	return -1;
+}
+
+static void hash_alloc_slot(MTY_Hash *ctx, struct hash_slot *slot, uint64_t hash, void *val)
+{
+	hash_reserve(ctx);
+
+	slot->hash = hash;
+	slot->val = val;
+
+	hash_insert(ctx, slot);
+	ctx->len++;
+}
+
+static void hash_remove(MTY_Hash *ctx, int64_t i)
+{
+	memset(&ctx->slots[i], 0, sizeof(struct hash_slot));
+
+	// If the next slot is empty no probe sequence continues past this one,
+	// so it can be marked empty rather than deleted. Slots never move on
+	// removal, which keeps popping during iteration safe.
+	if (ctx->ctrl[(i + 1) & ctx->mask] == HASH_CTRL_EMPTY) {
+		ctx->ctrl[i] = HASH_CTRL_EMPTY;
+
+	} else {
+		ctx->ctrl[i] = HASH_CTRL_DELETED;
+		ctx->deleted++;
+	}
+
+	ctx->len--;
+}
+
+
+// Interning
+
+static const char *hash_intern(const char *key, uint64_t hash)
+{
+	MTY_GlobalLock(&HASH_INTERN_LOCK);
+
+	if (!HASH_INTERN)
+		HASH_INTERN = MTY_HashCreate(0);
+
+	// The pool is an ordinary hash keyed by the string with the refcount as its value
+	int64_t i = hash_find(HASH_INTERN, key, 0, hash);
+
+	if (i < 0) {
+		struct hash_slot slot = {0};
+		slot.key.str = MTY_Strdup(key);
+		HASH_KIND(&slot) = HASH_KIND_HEAP;
+
+		hash_alloc_slot(HASH_INTERN, &slot, hash, (void *) (uintptr_t) 1);
+		key = slot.key.str;
+
+	} else {
+		struct hash_slot *s = &HASH_INTERN->slots[i];
+		s->val = (void *) ((uintptr_t) s->val + 1);
+		key = s->key.str;
+	}
+
+	MTY_GlobalUnlock(&HASH_INTERN_LOCK);
+
+	return key;
+}
+
+static void hash_release(const char *key, uint64_t hash)
+{
+	MTY_GlobalLock(&HASH_INTERN_LOCK);
+
+	int64_t i = hash_find(HASH_INTERN, key, 0, hash);
+
+	if (i >= 0) {
+		struct hash_slot *s = &HASH_INTERN->slots[i];
+		s->val = (void *) ((uintptr_t) s->val - 1);
+
+		if (!s->val) {
+			MTY_Free(s->key.str);
+			hash_remove(HASH_INTERN, i);
+		}
+	}
+
+	MTY_GlobalUnlock(&HASH_INTERN_LOCK);
+}
+
+static void hash_free_key(struct hash_slot *s)
+{
+	switch (HASH_KIND(s)) {
+		case HASH_KIND_HEAP:
+			MTY_Free(s->key.str);
+			break;
+		case HASH_KIND_INTERNED:
+			hash_release(s->key.str, s->hash);
+			break;
+	}
+}
+
+
+// Public
+
 MTY_Hash *MTY_HashCreate(uint32_t numBuckets)
 {
 	MTY_Hash *ctx = MTY_Alloc(1, sizeof(MTY_Hash));
-	ctx->num_buckets = numBuckets == 0 ? HASH_DEFAULT_BUCKETS : numBuckets;
 
-	ctx->buckets = MTY_Alloc(ctx->num_buckets, sizeof(struct hash_bucket));
+	// numBuckets is treated as a hint for the number of keys
+	uint32_t num_slots = HASH_MIN_SLOTS;
+
+	while ((uint64_t) num_slots * 7 < (uint64_t) numBuckets * 8 && num_slots < 0x80000000)
+		num_slots *= 2;
+
+	hash_alloc(ctx, num_slots);
+
+	return ctx;
+}
+
+MTY_Hash *MTY_HashCreateInterned(uint32_t numBuckets)
+{
+	MTY_Hash *ctx = MTY_HashCreate(numBuckets);
+	ctx->interned = true;
 
 	return ctx;
 }
@@ -43,153 +344,282 @@ void MTY_HashDestroy(MTY_Hash **hash, MTY_FreeFunc freeFunc)
 
 	MTY_Hash *ctx = *hash;
 
-	for (uint32_t x = 0; x < ctx->num_buckets; x++) {
-		struct hash_bucket *b = &ctx->buckets[x];
+	for (uint32_t x = 0; x <= ctx->mask; x++) {
+		if (ctx->ctrl[x] & HASH_CTRL_EMPTY)
+			continue;
 
-		for (uint32_t y = 0; y < b->num_nodes; y++) {
-			struct hash_node *n = &b->nodes[y];
+		struct hash_slot *s = &ctx->slots[x];
 
-			MTY_Free(n->key);
+		hash_free_key(s);
 
-			if (freeFunc && n->val)
-				freeFunc((void *) n->val);
-		}
-
-		MTY_Free(b->nodes);
+		if (freeFunc && s->val)
+			freeFunc(s->val);
 	}
 
-	MTY_Free(ctx->buckets);
+	MTY_Free(ctx->slots);
+	MTY_Free(ctx->ctrl);
 
 	MTY_Free(ctx);
 	*hash = NULL;
 }
 
-static void *hash_get(MTY_Hash *ctx, const char *key, bool pop)
+static void *hash_lookup(MTY_Hash *ctx, const char *key, int64_t ikey, uint64_t hash, bool pop)
+{
+	int64_t i = hash_find(ctx, key, ikey, hash);
+
+	if (i < 0)
+		return NULL;
+
+	void *r = ctx->slots[i].val;
+
+	if (pop) {
+		hash_free_key(&ctx->slots[i]);
+		hash_remove(ctx, i);
+	}
+
+	return r;
+}
+
+static void *hash_set(MTY_Hash *ctx, const char *key, int64_t ikey, uint64_t hash, void *value)
 {
-	struct hash_bucket *b = &ctx->buckets[MTY_DJB2(key) % ctx->num_buckets];
+	int64_t i = hash_find(ctx, key, ikey, hash);
 
-	for (uint32_t x = 0; x < b->num_nodes; x++) {
-		struct hash_node *n = &b->nodes[x];
+	if (i >= 0) {
+		void *r = ctx->slots[i].val;
+		ctx->slots[i].val = value;
 
-		if (n->key && !strcmp(key, n->key)) {
-			void *r = n->val;
+		return r;
+	}
+
+	struct hash_slot slot = {0};
+
+	if (!key) {
+		slot.key.i = ikey;
+		HASH_KIND(&slot) = HASH_KIND_INT;
+
+	} else {
+		size_t len = strlen(key);
 
-			if (pop) {
-				MTY_Free(n->key);
-				n->key = NULL;
-				n->val = NULL;
-			}
+		if (len <= HASH_INLINE_MAX) {
+			memcpy(slot.key.buf, key, len + 1);
+			HASH_KIND(&slot) = HASH_KIND_INLINE;
 
-			return r;
+		} else if (ctx->interned) {
+			slot.key.str = (char *) hash_intern(key, hash);
+			HASH_KIND(&slot) = HASH_KIND_INTERNED;
+
+		} else {
+			slot.key.str = MTY_Strdup(key);
+			HASH_KIND(&slot) = HASH_KIND_HEAP;
 		}
 	}
 
+	hash_alloc_slot(ctx, &slot, hash, value);
+
 	return NULL;
 }
 
 void *MTY_HashGet(MTY_Hash *ctx, const char *key)
 {
-	return hash_get(ctx, key, false);
+	return hash_lookup(ctx, key, 0, hash_string(key), false);
 }
 
 void *MTY_HashGetInt(MTY_Hash *ctx, int64_t key)
 {
-	char key_str[32];
-	snprintf(key_str, 32, "#%" PRIx64, key);
-
-	return hash_get(ctx, key_str, false);
+	return hash_lookup(ctx, NULL, key, hash_int(key), false);
 }
 
 void *MTY_HashSet(MTY_Hash *ctx, const char *key, void *value)
 {
-	struct hash_bucket *b = &ctx->buckets[MTY_DJB2(key) % ctx->num_buckets];
-	struct hash_node *n = NULL;
+	return hash_set(ctx, key, 0, hash_string(key), value);
+}
 
-	for (uint32_t x = 0; x < b->num_nodes; x++) {
-		struct hash_node *this_n = &b->nodes[x];
+void *MTY_HashSetInt(MTY_Hash *ctx, int64_t key, void *value)
+{
+	return hash_set(ctx, NULL, key, hash_int(key), value);
+}
 
-		if (!this_n->key) {
-			n = this_n;
+void *MTY_HashPop(MTY_Hash *ctx, const char *key)
+{
+	return hash_lookup(ctx, key, 0, hash_string(key), true);
+}
 
-		} else if (this_n->key && !strcmp(this_n->key, key)) {
-			void *r = this_n->val;
-			this_n->val = value;
+void *MTY_HashPopInt(MTY_Hash *ctx, int64_t key)
+{
+	return hash_lookup(ctx, NULL, key, hash_int(key), true);
+}
 
-			return r;
-		}
-	}
+static struct hash_slot *hash_next(MTY_Hash *ctx, uint64_t *iter)
+{
+	for (; *iter <= ctx->mask; (*iter)++)
+		if (!(ctx->ctrl[*iter] & HASH_CTRL_EMPTY))
+			return &ctx->slots[(*iter)++];
 
-	if (!n) {
-		b->nodes = MTY_Realloc(b->nodes, ++b->num_nodes, sizeof(struct hash_node));
-		n = &b->nodes[b->num_nodes - 1];
-	}
+	return NULL;
+}
 
-	n->key = MTY_Strdup(key);
-	n->val = value;
+bool MTY_HashGetNextKey(MTY_Hash *ctx, uint64_t *iter, const char **key)
+{
+	struct hash_slot *s = hash_next(ctx, iter);
 
-	return NULL;
+	*key = NULL;
+
+	if (s) {
+		*key = hash_key_str(s);
+
+		if (!*key) {
+			// Integer keys keep their historical string form when iterated as strings
+			char *key_str = mty_tlocal(32);
+			snprintf(key_str, 32, "#%" PRIx64, s->key.i);
+
+			*key = key_str;
+		}
+	}
+
+	return *key != NULL;
 }
 
-void *MTY_HashSetInt(MTY_Hash *ctx, int64_t key, void *value)
+bool MTY_HashGetNextKeyInt(MTY_Hash *ctx, uint64_t *iter, int64_t *key)
 {
-	char key_str[32];
-	snprintf(key_str, 32, "#%" PRIx64, key);
+	struct hash_slot *s = hash_next(ctx, iter);
+
+	if (!s || HASH_KIND(s) != HASH_KIND_INT)
+		return false;
 
-	return MTY_HashSet(ctx, key_str, value);
+	*key = s->key.i;
+
+	return true;
 }
 
-void *MTY_HashPop(MTY_Hash *ctx, const char *key)
+
+// Concurrent
+
+// Keys are spread over independently locked MTY_Hash shards. Values are only handed
+// out to callbacks while the shard's read lock is held, so once Set or Pop returns a
+// previous value no reader can still be using it and the caller may free it.
+
+#define CHASH_SHARDS_MIN 16
+#define CHASH_SHARDS_MAX 256
+
+struct chash_shard {
+	mty_rwlock rwlock;
+	MTY_Hash *hash;
+
+	// Keep neighboring locks off of each other's cache lines
+	uint8_t pad[64];
+};
+
+struct MTY_ConcurrentHash {
+	uint32_t mask;
+	struct chash_shard *shards;
+};
+
+static struct chash_shard *chash_shard(MTY_ConcurrentHash *ctx, uint64_t hash)
 {
-	return hash_get(ctx, key, true);
+	// The low bits index within the shard and the top bits fill the control bytes,
+	// so pick the shard from the middle
+	return &ctx->shards[(hash >> 32) & ctx->mask];
 }
 
-void *MTY_HashPopInt(MTY_Hash *ctx, int64_t key)
+MTY_ConcurrentHash *MTY_ConcurrentHashCreate(uint32_t numBuckets)
 {
-	char key_str[32];
-	snprintf(key_str, 32, "#%" PRIx64, key);
+	MTY_ConcurrentHash *ctx = MTY_Alloc(1, sizeof(MTY_ConcurrentHash));
 
-	return hash_get(ctx, key_str, true);
+	uint32_t num_shards = CHASH_SHARDS_MIN;
+	uint32_t target = MTY_GetNumProcessors() * 4;
+
+	while (num_shards < target && num_shards < CHASH_SHARDS_MAX)
+		num_shards *= 2;
+
+	ctx->mask = num_shards - 1;
+	ctx->shards = MTY_Alloc(num_shards, sizeof(struct chash_shard));
+
+	for (uint32_t x = 0; x < num_shards; x++) {
+		mty_rwlock_create(&ctx->shards[x].rwlock);
+		ctx->shards[x].hash = MTY_HashCreate(numBuckets / num_shards);
+	}
+
+	return ctx;
 }
 
-bool MTY_HashGetNextKey(MTY_Hash *ctx, uint64_t *iter, const char **key)
+void MTY_ConcurrentHashDestroy(MTY_ConcurrentHash **hash, MTY_FreeFunc freeFunc)
 {
-	*key = NULL;
+	if (!hash || !*hash)
+		return;
 
-	uint32_t *bucket = (uint32_t *) iter;
-	uint32_t *node = (uint32_t *) iter + 1;
+	MTY_ConcurrentHash *ctx = *hash;
 
-	for (; *bucket < ctx->num_buckets; (*bucket)++) {
-		struct hash_bucket *b = &ctx->buckets[*bucket];
+	for (uint32_t x = 0; x <= ctx->mask; x++) {
+		MTY_HashDestroy(&ctx->shards[x].hash, freeFunc);
+		mty_rwlock_destroy(&ctx->shards[x].rwlock);
+	}
 
-		for (; *node < b->num_nodes; (*node)++) {
-			struct hash_node *n = &b->nodes[*node];
+	MTY_Free(ctx->shards);
 
-			if (n->key) {
-				*key = n->key;
-				(*node)++;
-				break;
-			}
-		}
+	MTY_Free(ctx);
+	*hash = NULL;
+}
 
-		if (*key)
-			break;
+static bool chash_read(MTY_ConcurrentHash *ctx, const char *key, int64_t ikey, uint64_t hash,
+	MTY_HashReadFunc func, void *opaque)
+{
+	struct chash_shard *shard = chash_shard(ctx, hash);
 
-		if (*node == b->num_nodes)
-			*node = 0;
-	}
+	mty_rwlock_reader(&shard->rwlock);
 
-	return *key != NULL;
+	int64_t i = hash_find(shard->hash, key, ikey, hash);
+
+	if (i >= 0 && func)
+		func(shard->hash->slots[i].val, opaque);
+
+	mty_rwlock_unlock_reader(&shard->rwlock);
+
+	return i >= 0;
 }
 
-bool MTY_HashGetNextKeyInt(MTY_Hash *ctx, uint64_t *iter, int64_t *key)
+static void *chash_write(MTY_ConcurrentHash *ctx, const char *key, int64_t ikey, uint64_t hash,
+	void *value, bool pop)
 {
-	const char *key_str;
-	bool r = MTY_HashGetNextKey(ctx, iter, &key_str);
+	struct chash_shard *shard = chash_shard(ctx, hash);
 
-	r = r && key_str[0] == '#';
+	mty_rwlock_writer(&shard->rwlock);
 
-	if (r)
-		*key = strtoll(key_str + 1, NULL, 16);
+	void *r = pop ? hash_lookup(shard->hash, key, ikey, hash, true) :
+		hash_set(shard->hash, key, ikey, hash, value);
+
+	mty_rwlock_unlock_writer(&shard->rwlock);
 
 	return r;
 }
+
+bool MTY_ConcurrentHashRead(MTY_ConcurrentHash *ctx, const char *key, MTY_HashReadFunc func,
+	void *opaque)
+{
+	return chash_read(ctx, key, 0, hash_string(key), func, opaque);
+}
+
+bool MTY_ConcurrentHashReadInt(MTY_ConcurrentHash *ctx, int64_t key, MTY_HashReadFunc func,
+	void *opaque)
+{
+	return chash_read(ctx, NULL, key, hash_int(key), func, opaque);
+}
+
+void *MTY_ConcurrentHashSet(MTY_ConcurrentHash *ctx, const char *key, void *value)
+{
+	return chash_write(ctx, key, 0, hash_string(key), value, false);
+}
+
+void *MTY_ConcurrentHashSetInt(MTY_ConcurrentHash *ctx, int64_t key, void *value)
+{
+	return chash_write(ctx, NULL, key, hash_int(key), value, false);
+}
+
+void *MTY_ConcurrentHashPop(MTY_ConcurrentHash *ctx, const char *key)
+{
+	return chash_write(ctx, key, 0, hash_string(key), NULL, true);
+}
+
+void *MTY_ConcurrentHashPopInt(MTY_ConcurrentHash *ctx, int64_t key)
+{
+	return chash_write(ctx, NULL, key, hash_int(key), NULL, true);
+}
@@ -36,6 +36,34 @@ struct MTY_JSON {
 };
 
 
+// Nodes
+
+// Every node comes from one process wide pool, created the first time it's needed
+
+static MTY_Once JSON_ONCE;
+static MTY_Pool *JSON_POOL;
+
+static void json_pool_init(void *opaque)
+{
+	JSON_POOL = MTY_PoolCreate(sizeof(MTY_JSON));
+}
+
+static MTY_Pool *json_pool(void)
+{
+	MTY_CallOnce(&JSON_ONCE, json_pool_init, NULL);
+
+	return JSON_POOL;
+}
+
+static MTY_JSON *json_alloc(MTY_JSONType type)
+{
+	MTY_JSON *j = MTY_PoolAlloc(json_pool());
+	j->type = type;
+
+	return j;
+}
+
+
 // Parse
 
 #define JSON_ARRAY_PAD  64
@@ -348,6 +376,8 @@ MTY_JSON *MTY_JSONParse(const char *input)
 
 	uint32_t p = 0;
 
+	const char *tag = MTY_SetMemoryTag("json");
+
 	for (; p < len; p++) {
 		char c = input[p];
 
@@ -397,8 +427,7 @@ MTY_JSON *MTY_JSONParse(const char *input)
 					parent->stage = JSON_KEY;
 
 				} else {
-					MTY_JSON *j = MTY_Alloc(1, sizeof(MTY_JSON));
-					j->type = MTY_JSON_STRING;
+					MTY_JSON *j = json_alloc(MTY_JSON_STRING);
 					j->string = str;
 
 					if (!json_attach_item(&root, parent, &key, j))
@@ -434,6 +463,8 @@ MTY_JSON *MTY_JSONParse(const char *input)
 
 	MTY_Free(key);
 
+	MTY_SetMemoryTag(tag);
+
 	return root;
 }
 
@@ -516,7 +547,7 @@ static void json_delete_item(MTY_JSON *j)
 			}
 		}
 
-		MTY_Free(j);
+		MTY_PoolFree(json_pool(), j);
 		j = parent;
 	}
 }
@@ -736,10 +767,7 @@ bool MTY_JSONWriteFile(const char *path, const MTY_JSON *json)
 
 MTY_JSON *MTY_JSONNullCreate(void)
 {
-	MTY_JSON *j = MTY_Alloc(1, sizeof(MTY_JSON));
-	j->type = MTY_JSON_NULL;
-
-	return j;
+	return json_alloc(MTY_JSON_NULL);
 }
 
 
@@ -747,8 +775,7 @@ MTY_JSON *MTY_JSONNullCreate(void)
 
 MTY_JSON *MTY_JSONBoolCreate(bool value)
 {
-	MTY_JSON *j = MTY_Alloc(1, sizeof(MTY_JSON));
-	j->type = MTY_JSON_BOOL;
+	MTY_JSON *j = json_alloc(MTY_JSON_BOOL);
 	j->boolean = value;
 
 	return j;
@@ -769,8 +796,7 @@ bool MTY_JSONBool(const MTY_JSON *json, bool *value)
 
 MTY_JSON *MTY_JSONNumberCreate(double value)
 {
-	MTY_JSON *j = MTY_Alloc(1, sizeof(MTY_JSON));
-	j->type = MTY_JSON_NUMBER;
+	MTY_JSON *j = json_alloc(MTY_JSON_NUMBER);
 
 	if (!isnan(value) && !isinf(value))
 		j->number.value = value;
@@ -841,8 +867,7 @@ bool MTY_JSONFloat(const MTY_JSON *json, float *value)
 
 MTY_JSON *MTY_JSONStringCreate(const char *value)
 {
-	MTY_JSON *j = MTY_Alloc(1, sizeof(MTY_JSON));
-	j->type = MTY_JSON_STRING;
+	MTY_JSON *j = json_alloc(MTY_JSON_STRING);
 	j->string = MTY_Strdup(value);
 
 	return j;
@@ -871,8 +896,7 @@ const char *MTY_JSONStringPtr(const MTY_JSON *json)
 
 MTY_JSON *MTY_JSONArrayCreate(uint32_t len)
 {
-	MTY_JSON *j = MTY_Alloc(1, sizeof(MTY_JSON));
-	j->type = MTY_JSON_ARRAY;
+	MTY_JSON *j = json_alloc(MTY_JSON_ARRAY);
 	j->array.values = MTY_Alloc(len, sizeof(MTY_JSON *));
 	j->array.len = j->array.size = len;
 
@@ -923,9 +947,8 @@ bool MTY_JSONArraySetItem(MTY_JSON *json, uint32_t index, MTY_JSON *value)
 
 MTY_JSON *MTY_JSONObjCreate(void)
 {
-	MTY_JSON *j = MTY_Alloc(1, sizeof(MTY_JSON));
-	j->type = MTY_JSON_OBJECT;
-	j->object.hash = MTY_HashCreate(64);
+	MTY_JSON *j = json_alloc(MTY_JSON_OBJECT);
+	j->object.hash = MTY_HashCreate(0);
 
 	return j;
 }
@@ -4,9 +4,29 @@
 
 #include "matoya.h"
 
+// Nodes are carved out of chunks owned by the list and recycled through a free
+// list, so appending and removing doesn't touch the allocator once the list has
+// reached its working size. Chunks double in size up to LIST_CHUNK_MAX nodes
+
+#define LIST_CHUNK_MIN 8
+#define LIST_CHUNK_MAX 1024
+
+struct list_chunk {
+	struct list_chunk *next;
+	uint32_t len;
+	MTY_ListNode *nodes;
+};
+
 struct MTY_List {
 	MTY_ListNode *first;
 	MTY_ListNode *last;
+
+	// The tails are kept so that MTY_ListSplice can take over another pool in O(1)
+	struct list_chunk *chunks;
+	struct list_chunk *chunks_last;
+	MTY_ListNode *free;
+	MTY_ListNode *free_last;
+	uint32_t chunk_len;
 };
 
 MTY_List *MTY_ListCreate(void)
@@ -21,14 +41,15 @@ void MTY_ListDestroy(MTY_List **list, MTY_FreeFunc freeFunc)
 
 	MTY_List *ctx = *list;
 
-	for (MTY_ListNode *n = ctx->first; n;) {
-		MTY_ListNode *next = n->next;
-
-		if (freeFunc)
+	if (freeFunc)
+		for (MTY_ListNode *n = ctx->first; n; n = n->next)
 			freeFunc(n->value);
 
-		MTY_Free(n);
-		n = next;
+	for (struct list_chunk *c = ctx->chunks; c;) {
+		struct list_chunk *next = c->next;
+
+		MTY_Free(c);
+		c = next;
 	}
 
 	MTY_Free(ctx);
@@ -40,22 +61,85 @@ MTY_ListNode *MTY_ListGetFirst(MTY_List *ctx)
 	return ctx->first;
 }
 
-void MTY_ListAppend(MTY_List *ctx, void *value)
+MTY_ListNode *MTY_ListGetLast(MTY_List *ctx)
 {
-	MTY_ListNode *node = MTY_Alloc(1, sizeof(MTY_ListNode));
+	return ctx->last;
+}
+
+
+// Node pool
+
+static MTY_ListNode *list_alloc_node(MTY_List *ctx, void *value)
+{
+	if (!ctx->free) {
+		ctx->chunk_len = ctx->chunk_len == 0 ? LIST_CHUNK_MIN :
+			ctx->chunk_len < LIST_CHUNK_MAX ? ctx->chunk_len * 2 : LIST_CHUNK_MAX;
+
+		struct list_chunk *c = MTY_Alloc(1, sizeof(struct list_chunk) + ctx->chunk_len * sizeof(MTY_ListNode));
+		c->len = ctx->chunk_len;
+		c->nodes = (MTY_ListNode *) (c + 1);
+		c->next = ctx->chunks;
+		ctx->chunks = c;
+
+		if (!ctx->chunks_last)
+			ctx->chunks_last = c;
+
+		// Hand nodes out in address order
+		ctx->free_last = &c->nodes[c->len - 1];
+
+		for (uint32_t x = c->len; x > 0; x--) {
+			c->nodes[x - 1].next = ctx->free;
+			ctx->free = &c->nodes[x - 1];
+		}
+	}
+
+	MTY_ListNode *node = ctx->free;
+	ctx->free = node->next;
+
+	if (!ctx->free)
+		ctx->free_last = NULL;
+
+	node->prev = node->next = NULL;
 	node->value = value;
 
-	if (!ctx->first) {
-		ctx->first = ctx->last = node;
+	return node;
+}
+
+static void list_free_node(MTY_List *ctx, MTY_ListNode *node)
+{
+	node->prev = NULL;
+	node->value = NULL;
+	node->next = ctx->free;
+	ctx->free = node;
+
+	if (!ctx->free_last)
+		ctx->free_last = node;
+}
+
+
+// Linking
+
+static void list_link(MTY_List *ctx, MTY_ListNode *node, MTY_ListNode *before)
+{
+	node->next = before;
+	node->prev = before ? before->prev : ctx->last;
+
+	if (node->prev) {
+		node->prev->next = node;
+
+	} else {
+		ctx->first = node;
+	}
+
+	if (before) {
+		before->prev = node;
 
 	} else {
-		node->prev = ctx->last;
-		ctx->last->next = node;
 		ctx->last = node;
 	}
 }
 
-void *MTY_ListRemove(MTY_List *ctx, MTY_ListNode *node)
+static void list_unlink(MTY_List *ctx, MTY_ListNode *node)
 {
 	if (node->prev) {
 		node->prev->next = node->next;
@@ -67,13 +151,109 @@ void *MTY_ListRemove(MTY_List *ctx, MTY_ListNode *node)
 	if (node->next) {
 		node->next->prev = node->prev;
 
-	}  else {
+	} else {
 		ctx->last = node->prev;
 	}
 
+	node->prev = node->next = NULL;
+}
+
+MTY_ListNode *MTY_ListAppend(MTY_List *ctx, void *value)
+{
+	MTY_ListNode *node = list_alloc_node(ctx, value);
+	list_link(ctx, node, NULL);
+
+	return node;
+}
+
+MTY_ListNode *MTY_ListPrepend(MTY_List *ctx, void *value)
+{
+	MTY_ListNode *node = list_alloc_node(ctx, value);
+	list_link(ctx, node, ctx->first);
+
+	return node;
+}
+
+MTY_ListNode *MTY_ListInsertBefore(MTY_List *ctx, MTY_ListNode *before, void *value)
+{
+	MTY_ListNode *node = list_alloc_node(ctx, value);
+	list_link(ctx, node, before);
+
+	return node;
+}
+
+MTY_ListNode *MTY_ListInsertAfter(MTY_List *ctx, MTY_ListNode *after, void *value)
+{
+	MTY_ListNode *node = list_alloc_node(ctx, value);
+	list_link(ctx, node, after ? after->next : ctx->first);
+
+	return node;
+}
+
+void MTY_ListMove(MTY_List *ctx, MTY_ListNode *node, MTY_ListNode *before)
+{
+	if (node == before)
+		return;
+
+	list_unlink(ctx, node);
+	list_link(ctx, node, before);
+}
+
+void MTY_ListSplice(MTY_List *ctx, MTY_ListNode *before, MTY_List *other)
+{
+	if (other == ctx)
+		return;
+
+	if (other->first) {
+		MTY_ListNode *prev = before ? before->prev : ctx->last;
+
+		other->first->prev = prev;
+		other->last->next = before;
+
+		if (prev) {
+			prev->next = other->first;
+
+		} else {
+			ctx->first = other->first;
+		}
+
+		if (before) {
+			before->prev = other->last;
+
+		} else {
+			ctx->last = other->last;
+		}
+	}
+
+	// The moved nodes live in `other`'s chunks, so the chunks move along with them
+	if (other->chunks) {
+		other->chunks_last->next = ctx->chunks;
+		ctx->chunks = other->chunks;
+
+		if (!ctx->chunks_last)
+			ctx->chunks_last = other->chunks_last;
+	}
+
+	if (other->free) {
+		other->free_last->next = ctx->free;
+		ctx->free = other->free;
+
+		if (!ctx->free_last)
+			ctx->free_last = other->free_last;
+	}
+
+	other->first = other->last = NULL;
+	other->chunks = other->chunks_last = NULL;
+	other->free = other->free_last = NULL;
+}
+
+void *MTY_ListRemove(MTY_List *ctx, MTY_ListNode *node)
+{
+	list_unlink(ctx, node);
+
 	void *r = node->value;
 
-	MTY_Free(node);
+	list_free_node(ctx, node);
 
 	return r;
 }
@@ -2284,6 +2284,39 @@ MTY_LogFatalParams(const char *func, const char *fmt, ...) MTY_FMT(2, 3);
 #define MTY_ALIGN32(v) \
 	((v) + 0x1F & ~((uintptr_t) 0x1F))
 
+typedef struct MTY_Arena MTY_Arena;
+typedef struct MTY_Pool MTY_Pool;
+
+/// @brief A position in an MTY_Arena to return to with MTY_ArenaReset.
+typedef struct {
+	void *chunk; ///< Internal, do not modify.
+	size_t used; ///< Internal, do not modify.
+} MTY_ArenaMark;
+
+/// @brief A position in thread local storage to return to with MTY_ThreadLocalPop.
+typedef struct {
+	void *page;     ///< Internal, do not modify.
+	size_t used;    ///< Internal, do not modify.
+	uint32_t depth; ///< Internal, do not modify.
+} MTY_ThreadLocalMark;
+
+#define MTY_MEMORY_HISTOGRAM 16 ///< Number of size buckets in MTY_MemoryStats.
+
+/// @brief Allocation statistics collected after MTY_EnableMemoryStats.
+/// @details Byte counts are the sizes requested, not including allocator overhead.
+typedef struct {
+	uint64_t liveBytes;  ///< Bytes currently allocated.
+	uint64_t liveCount;  ///< Number of allocations not yet freed.
+	uint64_t peakBytes;  ///< The highest value `liveBytes` has reached.
+	uint64_t allocCount; ///< Number of allocations made.
+	uint64_t freeCount;  ///< Number of allocations freed.
+	uint64_t totalBytes; ///< Bytes allocated over the lifetime of the process.
+	uint64_t histogram[MTY_MEMORY_HISTOGRAM]; ///< Allocations by size. Bucket `n` counts
+	                                          ///<   sizes up to `16 << n` bytes that
+	                                          ///<   don't fit the previous bucket, the
+	                                          ///<   last bucket counts everything larger.
+} MTY_MemoryStats;
+
 /// @brief Function called while running MTY_Sort.
 /// @param e0 An element evaluated during MTY_Sort.
 /// @param e1 An element evaluated during MTY_Sort.
@@ -2291,6 +2324,43 @@ MTY_LogFatalParams(const char *func, const char *fmt, ...) MTY_FMT(2, 3);
 ///   before `e0`. Otherwise, the position is unchanged.
 typedef int32_t (*MTY_CompareFunc)(const void *e0, const void *e1);
 
+/// @brief Function called to allocate memory for an MTY_Allocator.
+/// @param size Size in bytes of the requested buffer.
+/// @param zero The buffer must be zeroed.
+/// @param opaque The `opaque` member of the MTY_Allocator.
+/// @returns The buffer, or NULL on failure.
+typedef void *(*MTY_AllocFunc)(size_t size, bool zero, void *opaque);
+
+/// @brief Function called to resize memory for an MTY_Allocator.
+/// @param mem Buffer returned by the allocator, or NULL.
+/// @param size Size in bytes of the new buffer.
+/// @param opaque The `opaque` member of the MTY_Allocator.
+/// @returns The resized buffer, or NULL on failure.
+typedef void *(*MTY_ReallocFunc)(void *mem, size_t size, void *opaque);
+
+/// @brief Function called to free memory for an MTY_Allocator.
+/// @param mem Buffer returned by the allocator, or NULL.
+/// @param opaque The `opaque` member of the MTY_Allocator.
+typedef void (*MTY_DeallocFunc)(void *mem, void *opaque);
+
+/// @brief Function called to allocate zeroed aligned memory for an MTY_Allocator.
+/// @param size Size in bytes of the requested buffer.
+/// @param align Alignment required in bytes, a power of two.
+/// @param opaque The `opaque` member of the MTY_Allocator.
+/// @returns The zeroed and aligned buffer, or NULL on failure.
+typedef void *(*MTY_AllocAlignedFunc)(size_t size, size_t align, void *opaque);
+
+/// @brief Memory allocation hooks set via MTY_SetAllocator.
+typedef struct {
+	MTY_AllocFunc alloc;               ///< Used by MTY_Alloc and MTY_AllocUninit.
+	MTY_ReallocFunc realloc;           ///< Used by MTY_Realloc.
+	MTY_DeallocFunc free;              ///< Used by MTY_Free.
+	MTY_AllocAlignedFunc allocAligned; ///< Used by MTY_AllocAligned. May be NULL.
+	MTY_DeallocFunc freeAligned;       ///< Used by MTY_FreeAligned. May be NULL only if
+	                                   ///<   `allocAligned` is NULL.
+	void *opaque;                      ///< Passed to each function.
+} MTY_Allocator;
+
 /// @brief Guarantee memory is zeroed without compiler interference.
 /// @param mem Buffer to zero.
 /// @param size Size in bytes of `mem`.
@@ -2307,6 +2377,17 @@ MTY_SecureZero(void *mem, size_t size);
 MTY_EXPORT void *
 MTY_Alloc(size_t len, size_t size);
 
+/// @brief Allocate memory without zeroing it.
+/// @details Prefer this over MTY_Alloc for large buffers that are completely written
+///   before being read, where zeroing has a real cost.
+/// @param len Number of elements requested.
+/// @param size Size in bytes of each element.
+/// @returns The buffer with undefined contents.\n\n
+///   This function can not return NULL. It will call `abort()` on failure.\n\n
+///   The returned buffer must be destroyed with MTY_Free.
+MTY_EXPORT void *
+MTY_AllocUninit(size_t len, size_t size);
+
 /// @brief Allocate zeroed aligned memory.
 /// @details For more information, see `_aligned_malloc` on Windows and
 ///   `posix_memalign` on Unix.
@@ -2330,6 +2411,73 @@ MTY_Free(void *mem);
 MTY_EXPORT void
 MTY_FreeAligned(void *mem);
 
+/// @brief Route all libmatoya memory allocation through your own functions.
+/// @details This must be called before any other libmatoya function, since memory
+///   can only be freed by the allocator that allocated it. It is not thread safe.
+/// @param allocator Allocation hooks, copied internally. If NULL, the C standard
+///   library is used, which is the default.
+MTY_EXPORT void
+MTY_SetAllocator(const MTY_Allocator *allocator);
+
+/// @brief Get the allocation hooks set via MTY_SetAllocator.
+/// @details This allows a new allocator to wrap the previous one.
+/// @returns The current hooks, or NULL if the C standard library is in use.
+MTY_EXPORT const MTY_Allocator *
+MTY_GetAllocator(void);
+
+/// @brief Get the built-in thread caching allocator.
+/// @details Pass the result to MTY_SetAllocator. Small allocations are served from
+///   per-thread free lists bucketed by size, so allocating and freeing them on a
+///   busy thread rarely reaches the C standard library. Each thread caches a bounded
+///   amount of memory, released by MTY_ReleaseThreadCache.
+/// @returns Allocation hooks to pass to MTY_SetAllocator.
+MTY_EXPORT const MTY_Allocator *
+MTY_GetThreadCacheAllocator(void);
+
+/// @brief Free the memory cached by the calling thread.
+/// @details This covers MTY_GetThreadCacheAllocator, the per-thread free lists
+///   of every MTY_Pool, and thread local storage pages beyond the first. Threads
+///   created with MTY_ThreadCreate call this automatically when they exit, other
+///   threads should call it before exiting.
+MTY_EXPORT void
+MTY_ReleaseThreadCache(void);
+
+/// @brief Start collecting allocation statistics.
+/// @details The current allocator is wrapped with one that records the size and tag
+///   of each allocation made through MTY_Alloc, MTY_AllocUninit and MTY_Realloc.
+///   Memory allocated with MTY_AllocAligned is not counted. Until this is called,
+///   statistics cost nothing. Like MTY_SetAllocator, this must be called before any
+///   other libmatoya function except MTY_SetAllocator, and MTY_SetAllocator must not
+///   be called afterwards since every block carries a header only this layer knows.
+MTY_EXPORT void
+MTY_EnableMemoryStats(void);
+
+/// @brief Set the tag that allocations on the calling thread are counted under.
+/// @details Tags can name a module, a subsystem, or a single call site. Up to 63
+///   distinct tags are tracked, further tags are counted as untagged. Some libmatoya
+///   modules tag their own allocations and restore the previous tag afterwards.
+/// @param tag Name of the tag, or NULL to stop tagging. The string must remain valid
+///   for the lifetime of the process, typically a string literal.
+/// @returns The previous tag, or NULL if there was none or statistics are not enabled.
+MTY_EXPORT const char *
+MTY_SetMemoryTag(const char *tag);
+
+/// @brief Read allocation statistics.
+/// @param tag Tag set via MTY_SetMemoryTag, or NULL for all allocations.
+/// @param stats Set to the current statistics.
+/// @returns Returns true on success, false if statistics are not enabled or `tag`
+///   has never been set.
+MTY_EXPORT bool
+MTY_GetMemoryStats(const char *tag, MTY_MemoryStats *stats);
+
+/// @brief Dump allocation statistics as JSON.
+/// @details The object has a `total` member for all allocations and a `tags` object
+///   with a member per tag, each laid out like MTY_MemoryStats.
+/// @returns If statistics are not enabled, NULL is returned.\n\n
+///   The returned MTY_JSON item must be destroyed with MTY_JSONDestroy.
+MTY_EXPORT MTY_JSON *
+MTY_GetMemoryStatsJSON(void);
+
 /// @brief Guarantee allocated memory is zeroed before it is freed.
 /// @param mem Dynamically allocated memory.
 /// @param size Size in bytes of `mem`.
@@ -2401,6 +2549,24 @@ MTY_SprintfD(const char *fmt, ...) MTY_FMT(1, 2);
 MTY_EXPORT const char *
 MTY_SprintfDL(const char *fmt, ...) MTY_FMT(1, 2);
 
+/// @brief Begin a thread local storage scope.
+/// @details Functions returning buffers in thread local storage, such as MTY_SprintfDL
+///   and MTY_JoinPath, take them from a per-thread stack. Outside of any scope the
+///   stack wraps around, so a result may be overwritten by a later call. Within a
+///   scope the stack grows as needed instead, and every result stays valid until
+///   the scope ends with MTY_ThreadLocalPop. Results obtained before the scope
+///   began are not affected by anything done within it. Scopes may be nested.
+/// @returns A mark to pass to MTY_ThreadLocalPop.
+MTY_EXPORT MTY_ThreadLocalMark
+MTY_ThreadLocalPush(void);
+
+/// @brief End a thread local storage scope.
+/// @details Everything allocated in thread local storage since `mark` was taken is
+///   released, including any scopes nested within it.
+/// @param mark A mark from MTY_ThreadLocalPush on the calling thread.
+MTY_EXPORT void
+MTY_ThreadLocalPop(const MTY_ThreadLocalMark *mark);
+
 /// @brief Search a string for a list of substrings.
 /// @param a String to be searched.
 /// @param b List of substrings delimited by `delim`.
@@ -2451,6 +2617,103 @@ MTY_Strtok(char *str, const char *delim, char **saveptr);
 MTY_EXPORT void
 MTY_Sort(void *buf, size_t len, size_t size, MTY_CompareFunc func);
 
+/// @brief Create an MTY_Arena region allocator.
+/// @details An arena hands out memory by bumping a pointer through large chunks,
+///   and everything it hands out is released at once with MTY_ArenaReset or
+///   MTY_ArenaDestroy. Building and tearing down a structure made of many small
+///   pieces then costs a handful of allocations instead of one per piece. An arena
+///   is not thread safe.
+/// @param chunkSize Size in bytes of each chunk the arena allocates. If 0, a default
+///   of 64 KB is used. Allocations larger than this get a chunk of their own.
+/// @returns The returned MTY_Arena must be destroyed with MTY_ArenaDestroy.
+MTY_EXPORT MTY_Arena *
+MTY_ArenaCreate(size_t chunkSize);
+
+/// @brief Destroy an MTY_Arena and all memory allocated from it.
+/// @param arena Passed by reference and set to NULL after being destroyed.
+MTY_EXPORT void
+MTY_ArenaDestroy(MTY_Arena **arena);
+
+/// @brief Allocate zeroed memory from an arena.
+/// @param ctx An MTY_Arena.
+/// @param len Number of elements requested.
+/// @param size Size in bytes of each element.
+/// @returns The zeroed buffer, aligned to 16 bytes.\n\n
+///   This function can not return NULL. It will call `abort()` on failure.\n\n
+///   The returned buffer must not be freed, it remains valid until the arena is
+///   reset past it or destroyed.
+MTY_EXPORT void *
+MTY_ArenaAlloc(MTY_Arena *ctx, size_t len, size_t size);
+
+/// @brief Allocate zeroed aligned memory from an arena.
+/// @param ctx An MTY_Arena.
+/// @param size Size in bytes of the requested buffer.
+/// @param align Alignment required in bytes. This value must be a power of two.
+/// @returns The zeroed and aligned buffer.\n\n
+///   This function can not return NULL. It will call `abort()` on failure.\n\n
+///   The returned buffer must not be freed, it remains valid until the arena is
+///   reset past it or destroyed.
+MTY_EXPORT void *
+MTY_ArenaAllocAligned(MTY_Arena *ctx, size_t size, size_t align);
+
+/// @brief Duplicate a string into an arena.
+/// @param ctx An MTY_Arena.
+/// @param str String to duplicate.
+/// @returns The returned string must not be freed, it remains valid until the
+///   arena is reset past it or destroyed.
+MTY_EXPORT char *
+MTY_ArenaStrdup(MTY_Arena *ctx, const char *str);
+
+/// @brief Get the current position of an arena.
+/// @param ctx An MTY_Arena.
+/// @returns A mark that can be passed to MTY_ArenaReset to release everything
+///   allocated after this call.
+MTY_EXPORT MTY_ArenaMark
+MTY_ArenaGetMark(MTY_Arena *ctx);
+
+/// @brief Release memory allocated from an arena.
+/// @details The arena keeps its chunks and reuses them for later allocations.
+/// @param ctx An MTY_Arena.
+/// @param mark A mark from MTY_ArenaGetMark, everything allocated after it is
+///   released. If NULL, everything allocated from the arena is released.
+MTY_EXPORT void
+MTY_ArenaReset(MTY_Arena *ctx, const MTY_ArenaMark *mark);
+
+/// @brief Create an MTY_Pool of fixed size objects.
+/// @details Objects are carved out of slabs so many objects of the same size don't
+///   fragment the heap. A slab is returned to the system once every object in it
+///   has been freed, apart from one kept for reuse. Each thread keeps a few dozen
+///   free objects for the pool, only taking the pool's lock to move a batch of
+///   objects at a time, until MTY_ReleaseThreadCache. The pool may be used from
+///   any number of threads, and an object may be freed by a different thread than
+///   the one that allocated it.
+/// @param size Size in bytes of each object.
+/// @returns The returned MTY_Pool must be destroyed with MTY_PoolDestroy.
+MTY_EXPORT MTY_Pool *
+MTY_PoolCreate(size_t size);
+
+/// @brief Destroy an MTY_Pool, releasing every object allocated from it at once.
+/// @details No thread may use the pool during or after this call. Objects still
+///   allocated do not need to be freed first.
+/// @param pool Passed by reference and set to NULL after being destroyed.
+MTY_EXPORT void
+MTY_PoolDestroy(MTY_Pool **pool);
+
+/// @brief Allocate a zeroed object from an MTY_Pool.
+/// @param ctx An MTY_Pool.
+/// @returns The zeroed object, aligned to 16 bytes.\n\n
+///   This function can not return NULL. It will call `abort()` on failure.\n\n
+///   The returned object must be freed with MTY_PoolFree or released by
+///   MTY_PoolDestroy.
+MTY_EXPORT void *
+MTY_PoolAlloc(MTY_Pool *ctx);
+
+/// @brief Return an object to an MTY_Pool.
+/// @param ctx The MTY_Pool that `obj` was allocated from.
+/// @param obj Object returned by MTY_PoolAlloc, or NULL.
+MTY_EXPORT void
+MTY_PoolFree(MTY_Pool *ctx, void *obj);
+
 /// @brief Convert a wide character string to its UTF-8 equivalent.
 /// @param src Source wide character string.
 /// @param dst Destination UTF-8 string.
@@ -2555,11 +2818,18 @@ typedef struct MTY_Cond MTY_Cond;
 typedef struct MTY_RWLock MTY_RWLock;
 typedef struct MTY_Waitable MTY_Waitable;
 typedef struct MTY_ThreadPool MTY_ThreadPool;
+typedef struct MTY_TaskGroup MTY_TaskGroup;
 
 /// @brief Function that takes a single opaque argument.
 /// @param opaque Pointer set via various MTY_ThreadPool related functions.
 typedef void (*MTY_AnonFunc)(void *opaque);
 
+/// @brief Function that processes a range of a larger parallel loop.
+/// @param begin First index of the range, inclusive.
+/// @param end Last index of the range, exclusive.
+/// @param opaque Pointer set via MTY_ParallelFor.
+typedef void (*MTY_ParallelForFunc)(int64_t begin, int64_t end, void *opaque);
+
 /// @brief Function that is executed on a thread.
 /// @param opaque Pointer set via MTY_ThreadCreate or MTY_ThreadDetach.
 /// @returns An opaque pointer that gets returned by MTY_ThreadDestroy if the thread
@@ -2585,6 +2855,39 @@ typedef struct {
 	volatile int64_t value; ///< 64-bit integer wrapped in a struct for alignment.
 } MTY_Atomic64;
 
+/// @brief Pointer sized integer used for atomic operations.
+typedef struct {
+	volatile uintptr_t value; ///< Pointer sized integer wrapped in a struct for alignment.
+} MTY_AtomicPtr;
+
+/// @brief Memory ordering constraint of an atomic operation.
+/// @details These follow the C11 memory model. An order that is not meaningful
+///   for an operation, such as MTY_MEMORY_ORDER_RELEASE on a load, is promoted to
+///   MTY_MEMORY_ORDER_SEQ_CST. Platforms may implement any order with a stronger one.
+typedef enum {
+	MTY_MEMORY_ORDER_RELAXED  = 0, ///< Atomicity only, no ordering with other memory operations.
+	MTY_MEMORY_ORDER_ACQUIRE  = 1, ///< Later reads and writes can not move before this load.
+	MTY_MEMORY_ORDER_RELEASE  = 2, ///< Earlier reads and writes can not move after this store.
+	MTY_MEMORY_ORDER_ACQ_REL  = 3, ///< Both acquire and release, for read-modify-write operations.
+	MTY_MEMORY_ORDER_SEQ_CST  = 4, ///< Full memory barrier with a single total order.
+	MTY_MEMORY_ORDER_MAKE_32  = INT32_MAX,
+} MTY_MemoryOrder;
+
+/// @brief One-time initialization flag used with MTY_CallOnce.
+/// @details Must be statically initialized to zero.
+typedef struct {
+	MTY_Atomic32 state; ///< Internal state, do not modify.
+} MTY_Once;
+
+/// @brief Scheduling priority of a thread.
+typedef enum {
+	MTY_THREAD_PRIORITY_LOW      = 0, ///< Background work that should yield to everything else.
+	MTY_THREAD_PRIORITY_NORMAL   = 1, ///< Default priority of new threads.
+	MTY_THREAD_PRIORITY_HIGH     = 2, ///< Latency sensitive work such as rendering.
+	MTY_THREAD_PRIORITY_REALTIME = 3, ///< Realtime scheduling for audio and similar deadlines.
+	MTY_THREAD_PRIORITY_MAKE_32  = INT32_MAX,
+} MTY_ThreadPriority;
+
 /// @brief Create an MTY_Thread that executes asynchronously.
 /// @param func Function that executes on its own thread.
 /// @param opaque Passed to `func` when it is called.
@@ -2611,6 +2914,41 @@ MTY_ThreadDetach(MTY_ThreadFunc func, void *opaque);
 MTY_EXPORT int64_t
 MTY_ThreadGetID(MTY_Thread *ctx);
 
+/// @brief Set the scheduling priority of a thread.
+/// @details On Linux, MTY_THREAD_PRIORITY_REALTIME uses `SCHED_FIFO` or `SCHED_RR`
+///   within the limits of `RLIMIT_RTPRIO`, and the other priorities adjust the
+///   thread's nice value within the limits of `RLIMIT_NICE`. If realtime scheduling
+///   is not permitted, MTY_THREAD_PRIORITY_HIGH is attempted instead. On Windows
+///   this maps to `SetThreadPriority`.
+/// @param ctx An MTY_Thread, or NULL for the calling thread.
+/// @param priority The new scheduling priority.
+/// @returns Returns true on success, false if the priority could not be changed or
+///   the thread has already finished.
+MTY_EXPORT bool
+MTY_ThreadSetPriority(MTY_Thread *ctx, MTY_ThreadPriority priority);
+
+/// @brief Restrict a thread to a set of logical processors.
+/// @details This is not supported on Apple platforms or the web.
+/// @param ctx An MTY_Thread, or NULL for the calling thread.
+/// @param mask Bitmask of the processors the thread may run on, where bit 0 is the
+///   first processor.
+/// @returns Returns true on success, false on failure or if unsupported.
+MTY_EXPORT bool
+MTY_ThreadSetAffinity(MTY_Thread *ctx, uint64_t mask);
+
+/// @brief Set the name of a thread as shown by debuggers and profilers.
+/// @details Linux truncates names to 15 characters. Apple platforms can only name
+///   the calling thread.
+/// @param ctx An MTY_Thread, or NULL for the calling thread.
+/// @param name The new name of the thread.
+/// @returns Returns true on success, false on failure or if unsupported.
+MTY_EXPORT bool
+MTY_ThreadSetName(MTY_Thread *ctx, const char *name);
+
+/// @brief Get the number of logical processors available to the process.
+MTY_EXPORT uint32_t
+MTY_GetNumProcessors(void);
+
 /// @brief Create an MTY_Mutex for synchronization.
 /// @details A mutex can be locked by only one thread at a time. Other threads trying
 ///   to take the same mutex will block until it becomes unlocked.
@@ -2680,6 +3018,18 @@ MTY_CondSignalAll(MTY_Cond *ctx);
 MTY_EXPORT MTY_RWLock *
 MTY_RWLockCreate(void);
 
+/// @brief Create a reader biased MTY_RWLock for read mostly data.
+/// @details While the bias is on, readers only publish themselves in a process wide
+///   table of slots instead of writing to the lock itself, so concurrent readers on
+///   different processors do not contend on a shared cache line. A writer turns the
+///   bias off and waits for biased readers to drain, which makes writes considerably
+///   more expensive. The bias is restored by a later reader once enough time has
+///   passed relative to the cost of the last revocation.
+/// @returns This function can not return NULL. It will call `abort()` on failure.\n\n
+///   The returned MTY_RWLock must be destroyed with MTY_RWLockDestroy.
+MTY_EXPORT MTY_RWLock *
+MTY_RWLockCreateBiased(void);
+
 /// @brief Destroy an MTY_RWLock.
 /// @param rwlock Passed by reference and set to NULL after being destroyed.
 MTY_EXPORT void
@@ -2712,6 +3062,17 @@ MTY_RWLockUnlock(MTY_RWLock *ctx);
 MTY_EXPORT MTY_Waitable *
 MTY_WaitableCreate(void);
 
+/// @brief Create an MTY_Waitable object that can be watched with `poll`.
+/// @details On Linux and Android the waitable is backed by an `eventfd` that becomes
+///   readable while the waitable is signaled, so it can be added to the same
+///   `poll` or `epoll` set as sockets and input devices. When `poll` reports the
+///   descriptor as readable, call MTY_WaitableWait with a timeout of 0 to consume the
+///   signal. On other platforms this behaves like MTY_WaitableCreate.
+/// @returns This function can not return NULL. It will call `abort()` on failure.\n\n
+///   The returned MTY_Waitable object must be destroyed with MTY_WaitableDestroy.
+MTY_EXPORT MTY_Waitable *
+MTY_WaitableCreatePollable(void);
+
 /// @brief Destroy an MTY_Waitable.
 /// @param waitable Passed by reference and set to NULL after being destroyed.
 MTY_EXPORT void
@@ -2737,13 +3098,36 @@ MTY_WaitableWait(MTY_Waitable *ctx, int32_t timeout);
 MTY_EXPORT void
 MTY_WaitableSignal(MTY_Waitable *ctx);
 
+/// @brief Get the file descriptor of a pollable waitable object.
+/// @details The descriptor is owned by the waitable and must not be read, written,
+///   or closed directly.
+/// @param ctx An MTY_Waitable object.
+/// @returns The descriptor of a waitable created with MTY_WaitableCreatePollable, or
+///   -1 if the waitable is not pollable or the platform does not support it.
+MTY_EXPORT int32_t
+MTY_WaitableGetFD(MTY_Waitable *ctx);
+
 /// @brief Create an MTY_ThreadPool for asynchronously executing tasks.
+/// @details Worker threads are created on demand and persist until the pool is
+///   destroyed, so dispatching a task does not create a new thread once the pool
+///   has warmed up.
 /// @param maxThreads Maximum number of threads that can be simultaneously executing.
 /// @returns This function can not return NULL. It will call `abort()` on failure.\n\n
 ///   The returned MTY_ThreadPool object must be destroyed with MTY_ThreadPoolDestroy.
 MTY_EXPORT MTY_ThreadPool *
 MTY_ThreadPoolCreate(uint32_t maxThreads);
 
+/// @brief Create an MTY_ThreadPool that queues tasks while all of its threads are busy.
+/// @details Tasks dispatched while every worker is busy wait in a bounded FIFO queue
+///   and run as soon as a worker becomes available. Once both the workers and the
+///   queue are full, MTY_ThreadPoolDispatch fails and the caller should retry later.
+/// @param maxThreads Maximum number of threads that can be simultaneously executing.
+/// @param maxQueued Maximum number of tasks that can be waiting for a thread.
+/// @returns This function can not return NULL. It will call `abort()` on failure.\n\n
+///   The returned MTY_ThreadPool object must be destroyed with MTY_ThreadPoolDestroy.
+MTY_EXPORT MTY_ThreadPool *
+MTY_ThreadPoolCreateQueued(uint32_t maxThreads, uint32_t maxQueued);
+
 /// @brief Destroy an MTY_ThreadPool.
 /// @param pool Passed by reference and set to NULL after being destroyed.
 /// @param detach Function called to clean up `opaque` thread state set via
@@ -2756,7 +3140,7 @@ MTY_ThreadPoolDestroy(MTY_ThreadPool **pool, MTY_AnonFunc detach);
 /// @param ctx An MTY_ThreadPool.
 /// @param func Function executed on a thread in the pool.
 /// @param opaque Passed to `func` when it is called.
-/// @returns On success, the index of the scheduled thread which must be greater than 0.
+/// @returns On success, the index of the scheduled task which must be greater than 0.
 ///   If there is no room left in the pool, 0 is returned. Call MTY_GetLog for details.
 MTY_EXPORT uint32_t
 MTY_ThreadPoolDispatch(MTY_ThreadPool *ctx, MTY_AnonFunc func, void *opaque);
@@ -2784,34 +3168,93 @@ MTY_ThreadPoolDetach(MTY_ThreadPool *ctx, uint32_t index, MTY_AnonFunc detach);
 MTY_EXPORT MTY_Async
 MTY_ThreadPoolPoll(MTY_ThreadPool *ctx, uint32_t index, void **opaque);
 
+/// @brief Restrict the worker threads of an MTY_ThreadPool to a set of logical
+///   processors.
+/// @details Applies to running workers and to workers created later. Pass a `mask`
+///   of 0 to stop pinning new workers. See MTY_ThreadSetAffinity for platform support.
+/// @param ctx An MTY_ThreadPool.
+/// @param mask Bitmask of the processors the workers may run on, where bit 0 is the
+///   first processor.
+MTY_EXPORT void
+MTY_ThreadPoolSetAffinity(MTY_ThreadPool *ctx, uint64_t mask);
+
+/// @brief Create an MTY_TaskGroup for running tasks on the shared work stealing
+///   scheduler.
+/// @details The scheduler is created the first time it is needed and keeps one worker
+///   thread per logical processor, minus the thread that waits on the group. Each
+///   worker owns a deque of tasks and steals from the others when its own runs dry.
+/// @returns This function can not return NULL. It will call `abort()` on failure.\n\n
+///   The returned MTY_TaskGroup must be destroyed with MTY_TaskGroupDestroy.
+MTY_EXPORT MTY_TaskGroup *
+MTY_TaskGroupCreate(void);
+
+/// @brief Wait for all tasks in an MTY_TaskGroup to finish then destroy it.
+/// @param group Passed by reference and set to NULL after being destroyed.
+MTY_EXPORT void
+MTY_TaskGroupDestroy(MTY_TaskGroup **group);
+
+/// @brief Run a task as part of an MTY_TaskGroup.
+/// @details Tasks may themselves run more tasks or call MTY_ParallelFor.
+/// @param ctx An MTY_TaskGroup.
+/// @param func Function executed on one of the scheduler's threads.
+/// @param opaque Passed to `func` when it is called.
+MTY_EXPORT void
+MTY_TaskGroupRun(MTY_TaskGroup *ctx, MTY_AnonFunc func, void *opaque);
+
+/// @brief Wait for all tasks in an MTY_TaskGroup to finish.
+/// @details While waiting, the calling thread executes pending tasks instead of
+///   blocking.
+/// @param ctx An MTY_TaskGroup.
+MTY_EXPORT void
+MTY_TaskGroupWait(MTY_TaskGroup *ctx);
+
+/// @brief Split a loop across all processors and wait for it to finish.
+/// @details The range is recursively halved, with one half left for other threads
+///   to steal, until each piece is at most `grain` long. The calling thread takes
+///   part in the work.
+/// @param begin First index of the loop, inclusive.
+/// @param end Last index of the loop, exclusive.
+/// @param grain Maximum number of indices handled by a single call to `func`. Values
+///   less than 1 are treated as 1.
+/// @param func Function called with each piece of the range.
+/// @param opaque Passed to `func` when it is called.
+MTY_EXPORT void
+MTY_ParallelFor(int64_t begin, int64_t end, int64_t grain, MTY_ParallelForFunc func,
+	void *opaque);
+
 /// @brief Set a 32-bit integer atomically.
-/// @details All atomic operations in libmatoya create a full memory barrier.
+/// @details All atomic operations without an explicit MTY_MemoryOrder create a full
+///   memory barrier.
 /// @param atomic An MTY_Atomic32.
 /// @param value Value to atomically set.
 MTY_EXPORT void
 MTY_Atomic32Set(MTY_Atomic32 *atomic, int32_t value);
 
 /// @brief Set a 64-bit integer atomically.
-/// @details All atomic operations in libmatoya create a full memory barrier.
+/// @details All atomic operations without an explicit MTY_MemoryOrder create a full
+///   memory barrier.
 /// @param atomic An MTY_Atomic64.
 /// @param value Value to atomically set.
 MTY_EXPORT void
 MTY_Atomic64Set(MTY_Atomic64 *atomic, int64_t value);
 
 /// @brief Get a 32-bit integer atomically.
-/// @details All atomic operations in libmatoya create a full memory barrier.
+/// @details All atomic operations without an explicit MTY_MemoryOrder create a full
+///   memory barrier.
 /// @param atomic An MTY_Atomic32.
 MTY_EXPORT int32_t
 MTY_Atomic32Get(MTY_Atomic32 *atomic);
 
 /// @brief Get a 64-bit integer atomically.
-/// @details All atomic operations in libmatoya create a full memory barrier.
+/// @details All atomic operations without an explicit MTY_MemoryOrder create a full
+///   memory barrier.
 /// @param atomic An MTY_Atomic64.
 MTY_EXPORT int64_t
 MTY_Atomic64Get(MTY_Atomic64 *atomic);
 
 /// @brief Add to a 32-bit integer atomically.
-/// @details All atomic operations in libmatoya create a full memory barrier.
+/// @details All atomic operations without an explicit MTY_MemoryOrder create a full
+///   memory barrier.
 /// @param atomic An MTY_Atomic32.
 /// @param value Value to atomically add. This value can be negative, effectively
 ///   performing subtraction.
@@ -2820,7 +3263,8 @@ MTY_EXPORT int32_t
 MTY_Atomic32Add(MTY_Atomic32 *atomic, int32_t value);
 
 /// @brief Add to a 64-bit integer atomically.
-/// @details All atomic operations in libmatoya create a full memory barrier.
+/// @details All atomic operations without an explicit MTY_MemoryOrder create a full
+///   memory barrier.
 /// @param atomic An MTY_Atomic64.
 /// @param value Value to atomically add. This value can be negative, effectively
 ///   performing subtraction.
@@ -2829,7 +3273,8 @@ MTY_EXPORT int64_t
 MTY_Atomic64Add(MTY_Atomic64 *atomic, int64_t value);
 
 /// @brief Compare two 32-bit values and if the same, atomically set to a new value.
-/// @details All atomic operations in libmatoya create a full memory barrier.
+/// @details All atomic operations without an explicit MTY_MemoryOrder create a full
+///   memory barrier.
 /// @param atomic An MTY_Atomic32.
 /// @param oldValue Value to compare against the atomic.
 /// @param newValue Value the atomic is set to if `oldValue` matches the atomic.
@@ -2838,7 +3283,8 @@ MTY_EXPORT bool
 MTY_Atomic32CAS(MTY_Atomic32 *atomic, int32_t oldValue, int32_t newValue);
 
 /// @brief Compare two 64-bit values and if the same, atomically set to a new value.
-/// @details All atomic operations in libmatoya create a full memory barrier.
+/// @details All atomic operations without an explicit MTY_MemoryOrder create a full
+///   memory barrier.
 /// @param atomic An MTY_Atomic64.
 /// @param oldValue Value to compare against the atomic.
 /// @param newValue Value the atomic is set to if `oldValue` matches the atomic.
@@ -2846,16 +3292,152 @@ MTY_Atomic32CAS(MTY_Atomic32 *atomic, int32_t oldValue, int32_t newValue);
 MTY_EXPORT bool
 MTY_Atomic64CAS(MTY_Atomic64 *atomic, int64_t oldValue, int64_t newValue);
 
+/// @brief Set a 32-bit integer atomically with an explicit memory order.
+/// @param atomic An MTY_Atomic32.
+/// @param value Value to atomically set.
+/// @param order Memory order of the store, typically MTY_MEMORY_ORDER_RELEASE or
+///   MTY_MEMORY_ORDER_RELAXED.
+MTY_EXPORT void
+MTY_Atomic32SetEx(MTY_Atomic32 *atomic, int32_t value, MTY_MemoryOrder order);
+
+/// @brief Set a 64-bit integer atomically with an explicit memory order.
+/// @param atomic An MTY_Atomic64.
+/// @param value Value to atomically set.
+/// @param order Memory order of the store, typically MTY_MEMORY_ORDER_RELEASE or
+///   MTY_MEMORY_ORDER_RELAXED.
+MTY_EXPORT void
+MTY_Atomic64SetEx(MTY_Atomic64 *atomic, int64_t value, MTY_MemoryOrder order);
+
+/// @brief Get a 32-bit integer atomically with an explicit memory order.
+/// @param atomic An MTY_Atomic32.
+/// @param order Memory order of the load, typically MTY_MEMORY_ORDER_ACQUIRE or
+///   MTY_MEMORY_ORDER_RELAXED.
+MTY_EXPORT int32_t
+MTY_Atomic32GetEx(MTY_Atomic32 *atomic, MTY_MemoryOrder order);
+
+/// @brief Get a 64-bit integer atomically with an explicit memory order.
+/// @param atomic An MTY_Atomic64.
+/// @param order Memory order of the load, typically MTY_MEMORY_ORDER_ACQUIRE or
+///   MTY_MEMORY_ORDER_RELAXED.
+MTY_EXPORT int64_t
+MTY_Atomic64GetEx(MTY_Atomic64 *atomic, MTY_MemoryOrder order);
+
+/// @brief Add to a 32-bit integer atomically with an explicit memory order.
+/// @param atomic An MTY_Atomic32.
+/// @param value Value to atomically add. This value can be negative, effectively
+///   performing subtraction.
+/// @param order Memory order of the operation.
+/// @returns The result of the addition.
+MTY_EXPORT int32_t
+MTY_Atomic32AddEx(MTY_Atomic32 *atomic, int32_t value, MTY_MemoryOrder order);
+
+/// @brief Add to a 64-bit integer atomically with an explicit memory order.
+/// @param atomic An MTY_Atomic64.
+/// @param value Value to atomically add. This value can be negative, effectively
+///   performing subtraction.
+/// @param order Memory order of the operation.
+/// @returns The result of the addition.
+MTY_EXPORT int64_t
+MTY_Atomic64AddEx(MTY_Atomic64 *atomic, int64_t value, MTY_MemoryOrder order);
+
+/// @brief Compare two 32-bit values and if the same, atomically set to a new value
+///   with an explicit memory order.
+/// @param atomic An MTY_Atomic32.
+/// @param oldValue Value to compare against the atomic.
+/// @param newValue Value the atomic is set to if `oldValue` matches the atomic.
+/// @param order Memory order if the exchange succeeds. A failed comparison is a load
+///   with the acquire part of `order` only.
+/// @returns If the atomic is set to `newValue`, returns true, otherwise false.
+MTY_EXPORT bool
+MTY_Atomic32CASEx(MTY_Atomic32 *atomic, int32_t oldValue, int32_t newValue,
+	MTY_MemoryOrder order);
+
+/// @brief Compare two 64-bit values and if the same, atomically set to a new value
+///   with an explicit memory order.
+/// @param atomic An MTY_Atomic64.
+/// @param oldValue Value to compare against the atomic.
+/// @param newValue Value the atomic is set to if `oldValue` matches the atomic.
+/// @param order Memory order if the exchange succeeds. A failed comparison is a load
+///   with the acquire part of `order` only.
+/// @returns If the atomic is set to `newValue`, returns true, otherwise false.
+MTY_EXPORT bool
+MTY_Atomic64CASEx(MTY_Atomic64 *atomic, int64_t oldValue, int64_t newValue,
+	MTY_MemoryOrder order);
+
+/// @brief Set a pointer atomically.
+/// @param atomic An MTY_AtomicPtr.
+/// @param value Pointer to atomically set.
+/// @param order Memory order of the store.
+MTY_EXPORT void
+MTY_AtomicPtrSet(MTY_AtomicPtr *atomic, void *value, MTY_MemoryOrder order);
+
+/// @brief Get a pointer atomically.
+/// @param atomic An MTY_AtomicPtr.
+/// @param order Memory order of the load.
+MTY_EXPORT void *
+MTY_AtomicPtrGet(MTY_AtomicPtr *atomic, MTY_MemoryOrder order);
+
+/// @brief Exchange a pointer atomically.
+/// @param atomic An MTY_AtomicPtr.
+/// @param value Pointer to atomically set.
+/// @param order Memory order of the operation.
+/// @returns The previous value of the atomic.
+MTY_EXPORT void *
+MTY_AtomicPtrExchange(MTY_AtomicPtr *atomic, void *value, MTY_MemoryOrder order);
+
+/// @brief Compare two pointers and if the same, atomically set to a new pointer.
+/// @param atomic An MTY_AtomicPtr.
+/// @param oldValue Pointer to compare against the atomic.
+/// @param newValue Pointer the atomic is set to if `oldValue` matches the atomic.
+/// @param order Memory order if the exchange succeeds. A failed comparison is a load
+///   with the acquire part of `order` only.
+/// @returns If the atomic is set to `newValue`, returns true, otherwise false.
+MTY_EXPORT bool
+MTY_AtomicPtrCAS(MTY_AtomicPtr *atomic, void *oldValue, void *newValue,
+	MTY_MemoryOrder order);
+
+/// @brief Bitwise OR a pointer atomically.
+/// @details Useful for setting flags in the low bits of an aligned pointer.
+/// @param atomic An MTY_AtomicPtr.
+/// @param mask Bits to set.
+/// @param order Memory order of the operation.
+/// @returns The previous value of the atomic.
+MTY_EXPORT void *
+MTY_AtomicPtrOr(MTY_AtomicPtr *atomic, uintptr_t mask, MTY_MemoryOrder order);
+
+/// @brief Bitwise AND a pointer atomically.
+/// @details Useful for clearing flags in the low bits of an aligned pointer.
+/// @param atomic An MTY_AtomicPtr.
+/// @param mask Bits to keep.
+/// @param order Memory order of the operation.
+/// @returns The previous value of the atomic.
+MTY_EXPORT void *
+MTY_AtomicPtrAnd(MTY_AtomicPtr *atomic, uintptr_t mask, MTY_MemoryOrder order);
+
+/// @brief Run a function exactly once per MTY_Once flag.
+/// @details The first thread to call this function runs `func`, and any other thread
+///   calling it at the same time blocks until `func` returns. Everything written by
+///   `func` is visible to callers once this function returns. After initialization
+///   has finished, this function is a single atomic load.\n\n
+///   Unlike MTY_GlobalLock, this does not consume one of the process wide global locks.
+/// @param once An MTY_Once flag, statically initialized to zero.
+/// @param func Function to run once.
+/// @param opaque Passed to `func` when it is called.
+MTY_EXPORT void
+MTY_CallOnce(MTY_Once *once, MTY_AnonFunc func, void *opaque);
+
 /// @brief Globally lock via an atomic.
-/// @details All atomic operations in libmatoya create a full memory barrier.\n\n
-///   Warning: There is a process wide maximum of UINT8_MAX global locks.\n\n
+/// @details All atomic operations without an explicit MTY_MemoryOrder create a full
+///   memory barrier.\n\n
+///   Warning: There is a process wide maximum of 65536 global locks.\n\n
 ///   The global lock should be statically initialized to zero.
 /// @param lock An MTY_Atomic32.
 MTY_EXPORT void
 MTY_GlobalLock(MTY_Atomic32 *lock);
 
 /// @brief Globally unlock via an atomic.
-/// @details All atomic operations in libmatoya create a full memory barrier.
+/// @details All atomic operations without an explicit MTY_MemoryOrder create a full
+///   memory barrier.
 /// @param lock An MTY_Atomic32.
 MTY_EXPORT void
 MTY_GlobalUnlock(MTY_Atomic32 *lock);
@@ -2894,6 +3476,8 @@ MTY_HttpRequest(const char *url, const char *method, const char *headers,
 	void **response, size_t *responseSize, uint16_t *status);
 
 /// @brief Create a global asynchronous HTTP thread pool.
+/// @details While all threads are busy, up to `maxThreads` additional requests are
+///   queued and started as soon as a thread becomes available.
 /// @param maxThreads Maximum number of threads that can be simultaneously making
 ///   requests.
 MTY_EXPORT void
@@ -2998,13 +3582,22 @@ MTY_WebSocketGetCloseCode(MTY_WebSocket *ctx);
 //- #mbrief Simple data structures.
 
 typedef struct MTY_Hash MTY_Hash;
+typedef struct MTY_ConcurrentHash MTY_ConcurrentHash;
 typedef struct MTY_Queue MTY_Queue;
+typedef struct MTY_ConcurrentQueue MTY_ConcurrentQueue;
+typedef struct MTY_TripleBuffer MTY_TripleBuffer;
 typedef struct MTY_List MTY_List;
 
 /// @brief Function that frees resources you allocated within a data structure.
 /// @param ptr Pointer set via MTY_HashSet et al.
 typedef void (*MTY_FreeFunc)(void *ptr);
 
+/// @brief Function called with a value found in an MTY_ConcurrentHash.
+/// @param value The value associated with the key. It is only guaranteed to remain
+///   valid until this function returns.
+/// @param opaque Pointer passed to MTY_ConcurrentHashRead et al.
+typedef void (*MTY_HashReadFunc)(void *value, void *opaque);
+
 /// @brief Node in a linked list.
 typedef struct MTY_ListNode {
 	struct MTY_ListNode *prev; ///< The previous node in the list.
@@ -3013,13 +3606,26 @@ typedef struct MTY_ListNode {
 } MTY_ListNode;
 
 /// @brief Create an MTY_Hash for key/value lookup.
-/// @param numBuckets The number of buckets to use. The more buckets, the larger
-///   the memory usage but less chance of collision. Specifying 0 chooses a reasonable
-///   default.
+/// @details The hash grows automatically as keys are added.
+/// @param numBuckets The number of keys to preallocate space for. Specifying 0
+///   chooses a small default.
 /// @returns The returned MTY_Hash must be destroyed with MTY_HashDestroy.
 MTY_EXPORT MTY_Hash *
 MTY_HashCreate(uint32_t numBuckets);
 
+/// @brief Create an MTY_Hash that interns its string keys.
+/// @details String keys longer than 14 characters are stored once in a process wide,
+///   reference counted pool shared by all interned hashes, rather than being copied
+///   into each hash. Shorter keys are always stored inline. This saves memory when
+///   many long lived hashes share the same key names, at the cost of a global lock
+///   when long keys are added or removed. Avoid it for hashes that are created and
+///   destroyed on several threads at once.
+/// @param numBuckets The number of keys to preallocate space for. Specifying 0
+///   chooses a small default.
+/// @returns The returned MTY_Hash must be destroyed with MTY_HashDestroy.
+MTY_EXPORT MTY_Hash *
+MTY_HashCreateInterned(uint32_t numBuckets);
+
 /// @brief Destroy an MTY_Hash.
 /// @param hash Passed by reference and set to NULL after being destroyed.
 /// @param freeFunc Function called on each remaining value in the hash to give you
@@ -3051,6 +3657,8 @@ MTY_EXPORT void *
 MTY_HashSet(MTY_Hash *ctx, const char *key, void *value);
 
 /// @brief Set a value in a hash by integer key.
+/// @details Integer keys are stored separately from string keys and never
+///   collide with them.
 /// @param ctx An MTY_Hash.
 /// @param key Integer key to set.
 /// @param value Value to set associated with `key`.
@@ -3074,10 +3682,13 @@ MTY_EXPORT void *
 MTY_HashPopInt(MTY_Hash *ctx, int64_t key);
 
 /// @brief Iterate through string key/value pairs in a hash.
+/// @details Keys may be popped while iterating, but setting a new key invalidates
+///   the iterator.
 /// @param ctx An MTY_Hash.
 /// @param iter Iterator that keeps track of the position in the hash. Set this to
 ///   0 before the fist call to this function.
-/// @param key Reference to the next string key in the hash.
+/// @param key Reference to the next string key in the hash. Integer keys are
+///   returned as '#' followed by their hex value in thread local memory.
 /// @returns Returns true if there are more keys available, otherwise false.
 MTY_EXPORT bool
 MTY_HashGetNextKey(MTY_Hash *ctx, uint64_t *iter, const char **key);
@@ -3087,10 +3698,91 @@ MTY_HashGetNextKey(MTY_Hash *ctx, uint64_t *iter, const char **key);
 /// @param iter Iterator that keeps track of the position in the hash. Set this to
 ///   0 before the fist call to this function.
 /// @param key Reference to the next integer key in the hash.
-/// @returns Returns true if there are more keys available, otherwise false.
+/// @returns Returns true if there are more keys available, otherwise false. Also
+///   returns false if the next key is a string key.
 MTY_EXPORT bool
 MTY_HashGetNextKeyInt(MTY_Hash *ctx, uint64_t *iter, int64_t *key);
 
+/// @brief Create an MTY_ConcurrentHash for key/value lookup from multiple threads.
+/// @details Keys are divided between a number of independently locked shards, so
+///   threads touching different keys rarely contend, and reads of the same shard
+///   proceed in parallel. Values are only exposed through callbacks while the
+///   shard is locked, so a value returned by MTY_ConcurrentHashSet or
+///   MTY_ConcurrentHashPop can be freed immediately.
+/// @param numBuckets The total number of keys to preallocate space for. Specifying 0
+///   chooses a small default.
+/// @returns The returned MTY_ConcurrentHash must be destroyed with
+///   MTY_ConcurrentHashDestroy.
+MTY_EXPORT MTY_ConcurrentHash *
+MTY_ConcurrentHashCreate(uint32_t numBuckets);
+
+/// @brief Destroy an MTY_ConcurrentHash.
+/// @details No other thread may be using the hash during this call.
+/// @param hash Passed by reference and set to NULL after being destroyed.
+/// @param freeFunc Function called on each value in the hash, or NULL.
+MTY_EXPORT void
+MTY_ConcurrentHashDestroy(MTY_ConcurrentHash **hash, MTY_FreeFunc freeFunc);
+
+/// @brief Look up a value in a concurrent hash by string key.
+/// @details `func` runs while holding a read lock, so it should be short and must
+///   not call back into the same hash.
+/// @param ctx An MTY_ConcurrentHash.
+/// @param key String key to lookup.
+/// @param func Function called with the value if `key` is found, or NULL to only test
+///   whether `key` exists.
+/// @param opaque Passed through to `func`.
+/// @returns Returns true if `key` was found, otherwise false.
+MTY_EXPORT bool
+MTY_ConcurrentHashRead(MTY_ConcurrentHash *ctx, const char *key, MTY_HashReadFunc func,
+	void *opaque);
+
+/// @brief Look up a value in a concurrent hash by integer key.
+/// @details `func` runs while holding a read lock, so it should be short and must
+///   not call back into the same hash.
+/// @param ctx An MTY_ConcurrentHash.
+/// @param key Integer key to lookup.
+/// @param func Function called with the value if `key` is found, or NULL to only test
+///   whether `key` exists.
+/// @param opaque Passed through to `func`.
+/// @returns Returns true if `key` was found, otherwise false.
+MTY_EXPORT bool
+MTY_ConcurrentHashReadInt(MTY_ConcurrentHash *ctx, int64_t key, MTY_HashReadFunc func,
+	void *opaque);
+
+/// @brief Set a value in a concurrent hash by string key.
+/// @param ctx An MTY_ConcurrentHash.
+/// @param key String key to set.
+/// @param value Value to set associated with `key`.
+/// @returns If `key` already exists, the previous value is returned, otherwise NULL
+///   is returned. No reader can still be using the previous value.
+MTY_EXPORT void *
+MTY_ConcurrentHashSet(MTY_ConcurrentHash *ctx, const char *key, void *value);
+
+/// @brief Set a value in a concurrent hash by integer key.
+/// @param ctx An MTY_ConcurrentHash.
+/// @param key Integer key to set.
+/// @param value Value to set associated with `key`.
+/// @returns If `key` already exists, the previous value is returned, otherwise NULL
+///   is returned. No reader can still be using the previous value.
+MTY_EXPORT void *
+MTY_ConcurrentHashSetInt(MTY_ConcurrentHash *ctx, int64_t key, void *value);
+
+/// @brief Remove a value from a concurrent hash by string key.
+/// @param ctx An MTY_ConcurrentHash.
+/// @param key String key to remove.
+/// @returns The value associated with `key`, otherwise NULL. No reader can still be
+///   using the returned value.
+MTY_EXPORT void *
+MTY_ConcurrentHashPop(MTY_ConcurrentHash *ctx, const char *key);
+
+/// @brief Remove a value from a concurrent hash by integer key.
+/// @param ctx An MTY_ConcurrentHash.
+/// @param key Integer key to remove.
+/// @returns The value associated with `key`, otherwise NULL. No reader can still be
+///   using the returned value.
+MTY_EXPORT void *
+MTY_ConcurrentHashPopInt(MTY_ConcurrentHash *ctx, int64_t key);
+
 /// @brief Create an MTY_Queue for thread safe serialization.
 /// @details The queue is a multi-producer single-consumer style queue, meaning
 ///   multiple threads can submit to the queue safely, but only a single thread can
@@ -3102,6 +3794,31 @@ MTY_HashGetNextKeyInt(MTY_Hash *ctx, uint64_t *iter, int64_t *key);
 MTY_EXPORT MTY_Queue *
 MTY_QueueCreate(uint32_t len, size_t bufSize);
 
+/// @brief Create an MTY_Queue for a single producer thread and a single consumer thread.
+/// @details Pushing takes no lock, and the consumer briefly spins before going to
+///   sleep on multi core systems, so handoff between two busy threads avoids the
+///   kernel entirely. The queue must only ever be pushed to from one thread at a time.
+/// @param len The number of buffers in the queue.
+/// @param bufSize The preallocated size of each buffer in the queue. If only pushing
+///   via MTY_QueuePushPtr, this can be set to 0.
+/// @returns The returned MTY_Queue must be destroyed with MTY_QueueDestroy.
+MTY_EXPORT MTY_Queue *
+MTY_QueueCreateSPSC(uint32_t len, size_t bufSize);
+
+/// @brief Create an MTY_Queue whose buffers share a single byte ring.
+/// @details Behaves like MTY_QueueCreate, but instead of preallocating `len` buffers
+///   of `bufSize`, each message is reserved contiguously from one arena of `ringSize`
+///   bytes and only keeps the space actually pushed. This suits queues where the
+///   largest message is much bigger than the typical one.
+/// @param len The maximum number of messages in the queue at once.
+/// @param bufSize The size reserved by MTY_QueueGetInputBuffer. Messages reserved
+///   with MTY_QueueReserveInputBuffer or pushed with MTY_QueuePushMany may be larger.
+/// @param ringSize The size of the shared arena in bytes, which is the largest
+///   possible message. This is rounded up to at least `bufSize`.
+/// @returns The returned MTY_Queue must be destroyed with MTY_QueueDestroy.
+MTY_EXPORT MTY_Queue *
+MTY_QueueCreateRing(uint32_t len, size_t bufSize, size_t ringSize);
+
 /// @brief Destroy an MTY_Queue.
 /// @param queue Passed by reference and set to NULL after being destroyed.
 MTY_EXPORT void
@@ -3115,15 +3832,30 @@ MTY_EXPORT uint32_t
 MTY_QueueGetLength(MTY_Queue *ctx);
 
 /// @brief Lock and retrieve the next available input buffer from the queue.
+/// @details For a queue created with MTY_QueueCreateRing, this reserves `bufSize`
+///   bytes from the ring.
 /// @param ctx An MTY_Queue.
 /// @returns If there are no input buffers available, NULL is returned.
 MTY_EXPORT void *
 MTY_QueueGetInputBuffer(MTY_Queue *ctx);
 
+/// @brief Lock and retrieve an input buffer of at least `size` bytes from the queue.
+/// @details This is most useful with MTY_QueueCreateRing, where reserving only what
+///   the message needs lets it fit into a fuller ring than MTY_QueueGetInputBuffer.
+///   The buffer is pushed with MTY_QueuePush like any other input buffer.
+/// @param ctx An MTY_Queue.
+/// @param size The number of bytes to reserve, at most the `bufSize` the queue was
+///   created with, or the `ringSize` for a queue created with MTY_QueueCreateRing.
+/// @returns If there is no input buffer with `size` bytes available, NULL is returned.
+MTY_EXPORT void *
+MTY_QueueReserveInputBuffer(MTY_Queue *ctx, size_t size);
+
 /// @brief Push and unlock the most recently acquired input buffer.
 /// @param ctx An MTY_Queue.
 /// @param size The amount of data filled in the most recently locked buffer. If this
 ///   is 0, the previous buffer is immediately released and internally set to empty.
+///   For a queue created with MTY_QueueCreateRing, any reserved space beyond `size`
+///   is returned to the ring.
 MTY_EXPORT void
 MTY_QueuePush(MTY_Queue *ctx, size_t size);
 
@@ -3174,6 +3906,70 @@ MTY_QueuePushPtr(MTY_Queue *ctx, void *opaque, size_t size);
 MTY_EXPORT bool
 MTY_QueuePopPtr(MTY_Queue *ctx, int32_t timeout, void **opaque, size_t *size);
 
+/// @brief Copy several items into consecutive input buffers of the queue.
+/// @details All items are pushed under a single lock and the consumer is woken at
+///   most once, which is much cheaper than one MTY_QueuePush per item. Items keep
+///   their order, and no other producer's items are interleaved between them.
+/// @param ctx An MTY_Queue.
+/// @param items Array of `count` items to copy.
+/// @param sizes Array of `count` sizes in bytes, each at most the queue's `bufSize`,
+///   or its `ringSize` for a queue created with MTY_QueueCreateRing. An item with a
+///   size of 0 or above that limit is never pushed and stops the batch, check
+///   `sizes[n]` to tell it apart from a full queue.
+/// @param count Number of items in `items` and `sizes`.
+/// @returns The number of items pushed, which is also the index of the first item not
+///   pushed. Fewer than `count` if the queue filled up or an item could not be pushed.
+MTY_EXPORT uint32_t
+MTY_QueuePushMany(MTY_Queue *ctx, const void * const *items, const size_t *sizes,
+	uint32_t count);
+
+/// @brief Push several pointers allocated by the caller to a queue.
+/// @details The batched equivalent of MTY_QueuePushPtr, see MTY_QueuePushMany.
+/// @param ctx An MTY_Queue.
+/// @param opaque Array of `count` values you allocated and are responsible for freeing.
+/// @param sizes Array of `count` sizes returned by MTY_QueuePopPtr. May be NULL.
+/// @param count Number of values in `opaque`.
+/// @returns The number of values pushed, fewer than `count` if the queue filled up.
+MTY_EXPORT uint32_t
+MTY_QueuePushPtrMany(MTY_Queue *ctx, void * const *opaque, const size_t *sizes,
+	uint32_t count);
+
+/// @brief Lock and retrieve several consecutive output buffers from the queue.
+/// @details Waits for the first buffer like MTY_QueueGetOutputBuffer, then returns
+///   every buffer already pushed behind it without waiting again. The buffers must
+///   be released with MTY_QueuePopMany.
+/// @param ctx An MTY_Queue.
+/// @param timeout Time to wait in milliseconds for the first output buffer to become
+///   available. A negative value will not timeout.
+/// @param buffers Array of `max` to receive the output buffers, oldest first.
+/// @param sizes Array of `max` to receive the size of the data in each buffer. May
+///   be NULL.
+/// @param max Maximum number of buffers to retrieve.
+/// @returns The number of buffers retrieved, 0 on timeout.
+MTY_EXPORT uint32_t
+MTY_QueueGetOutputBuffers(MTY_Queue *ctx, int32_t timeout, void **buffers,
+	size_t *sizes, uint32_t max);
+
+/// @brief Unlock the `count` oldest acquired output buffers and mark them as empty.
+/// @param ctx An MTY_Queue.
+/// @param count Number of buffers to release, usually the value returned by
+///   MTY_QueueGetOutputBuffers.
+MTY_EXPORT void
+MTY_QueuePopMany(MTY_Queue *ctx, uint32_t count);
+
+/// @brief Pop several pointers allocated by the caller from a queue.
+/// @details The batched equivalent of MTY_QueuePopPtr, see MTY_QueueGetOutputBuffers.
+/// @param ctx An MTY_Queue.
+/// @param timeout Time to wait in milliseconds for the first pointer to become
+///   available. A negative value will not timeout.
+/// @param opaque Array of `max` to receive pointers set via MTY_QueuePushPtr.
+/// @param sizes Array of `max` to receive the `size` passed when pushing. May be NULL.
+/// @param max Maximum number of pointers to pop.
+/// @returns The number of pointers popped, 0 on timeout.
+MTY_EXPORT uint32_t
+MTY_QueuePopPtrMany(MTY_Queue *ctx, int32_t timeout, void **opaque, size_t *sizes,
+	uint32_t max);
+
 /// @brief Set all buffers in a queue as empty.
 /// @param ctx An MTY_Queue.
 /// @param freeFunc Function called on each user allocated value in the queue to
@@ -3181,6 +3977,96 @@ MTY_QueuePopPtr(MTY_Queue *ctx, int32_t timeout, void **opaque, size_t *size);
 MTY_EXPORT void
 MTY_QueueFlush(MTY_Queue *ctx, MTY_FreeFunc freeFunc);
 
+/// @brief Create a bounded MTY_ConcurrentQueue for many producers and many consumers.
+/// @details Unlike MTY_Queue, any number of threads may push and pop at the same time.
+///   Items are fixed size and copied in and out of the queue. Pushing and popping
+///   are lock free unless a thread has to wait for space or items.
+/// @param len The minimum number of items the queue can hold. This is rounded up to
+///   a power of two.
+/// @param itemSize The size in bytes of each item. If 0, items are pointer sized.
+/// @returns The returned MTY_ConcurrentQueue must be destroyed with
+///   MTY_ConcurrentQueueDestroy.
+MTY_EXPORT MTY_ConcurrentQueue *
+MTY_ConcurrentQueueCreate(uint32_t len, size_t itemSize);
+
+/// @brief Destroy an MTY_ConcurrentQueue.
+/// @details No other thread may be using the queue during this call.
+/// @param queue Passed by reference and set to NULL after being destroyed.
+MTY_EXPORT void
+MTY_ConcurrentQueueDestroy(MTY_ConcurrentQueue **queue);
+
+/// @brief Get the current number of items in the queue.
+/// @details This is an approximation while there is activity.
+/// @param ctx An MTY_ConcurrentQueue.
+MTY_EXPORT uint32_t
+MTY_ConcurrentQueueGetLength(MTY_ConcurrentQueue *ctx);
+
+/// @brief Copy an item into the queue.
+/// @param ctx An MTY_ConcurrentQueue.
+/// @param item Item of the size passed to MTY_ConcurrentQueueCreate.
+/// @param timeout Time to wait in milliseconds for space to become available. A value
+///   of 0 returns immediately, a negative value will not timeout.
+/// @returns Returns true if the item was pushed, otherwise false if the queue stayed
+///   full until `timeout`.
+MTY_EXPORT bool
+MTY_ConcurrentQueuePush(MTY_ConcurrentQueue *ctx, const void *item, int32_t timeout);
+
+/// @brief Copy the oldest item out of the queue.
+/// @param ctx An MTY_ConcurrentQueue.
+/// @param item Buffer of the size passed to MTY_ConcurrentQueueCreate.
+/// @param timeout Time to wait in milliseconds for an item to become available. A value
+///   of 0 returns immediately, a negative value will not timeout.
+/// @returns Returns true if an item was popped, otherwise false if the queue stayed
+///   empty until `timeout`.
+MTY_EXPORT bool
+MTY_ConcurrentQueuePop(MTY_ConcurrentQueue *ctx, void *item, int32_t timeout);
+
+/// @brief Create an MTY_TripleBuffer to hand the latest value from one thread to another.
+/// @details A triple buffer is a mailbox holding a single value: the producer always
+///   has a free buffer to write, and the consumer always reads the newest completed
+///   one. Values the consumer was too slow to read are silently replaced. Neither side
+///   ever blocks or copies, which makes this the lowest latency way to pass video
+///   frames from a decoder to a renderer. Exactly one thread may produce and one
+///   thread may consume.
+/// @param bufSize The preallocated size of each of the three buffers.
+/// @returns The returned MTY_TripleBuffer must be destroyed with MTY_TripleBufferDestroy.
+MTY_EXPORT MTY_TripleBuffer *
+MTY_TripleBufferCreate(size_t bufSize);
+
+/// @brief Destroy an MTY_TripleBuffer.
+/// @param tb Passed by reference and set to NULL after being destroyed.
+MTY_EXPORT void
+MTY_TripleBufferDestroy(MTY_TripleBuffer **tb);
+
+/// @brief Retrieve the producer's buffer.
+/// @details The same buffer is returned until MTY_TripleBufferPush is called, and its
+///   contents are left over from an older value.
+/// @param ctx An MTY_TripleBuffer.
+/// @returns A buffer of the `bufSize` passed to MTY_TripleBufferCreate. This is never
+///   NULL.
+MTY_EXPORT void *
+MTY_TripleBufferGetInputBuffer(MTY_TripleBuffer *ctx);
+
+/// @brief Publish the producer's buffer as the latest value.
+/// @details The buffer previously returned by MTY_TripleBufferGetInputBuffer is
+///   replaced with a free one.
+/// @param ctx An MTY_TripleBuffer.
+/// @param size The amount of data filled in the producer's buffer.
+MTY_EXPORT void
+MTY_TripleBufferPush(MTY_TripleBuffer *ctx, size_t size);
+
+/// @brief Retrieve the latest value published by the producer.
+/// @details The returned buffer stays valid and unchanged until the next call to
+///   this function.
+/// @param ctx An MTY_TripleBuffer.
+/// @param buffer Set to the buffer holding the latest value, or NULL if nothing
+///   has been pushed yet.
+/// @param size Set to the `size` passed to MTY_TripleBufferPush. May be NULL.
+/// @returns Returns true if `buffer` holds a value newer than the one returned by
+///   the previous call, otherwise false.
+MTY_EXPORT bool
+MTY_TripleBufferGetOutputBuffer(MTY_TripleBuffer *ctx, void **buffer, size_t *size);
+
 /// @brief Create an MTY_List for a flexibly sized array.
 /// @returns The returned MTY_List must be destroyed with MTY_ListDestroy.\n\n
 ///   Only the first node in the list should be passed to MTY_ListDestroy.
@@ -3200,15 +4086,70 @@ MTY_ListDestroy(MTY_List **list, MTY_FreeFunc freeFunc);
 MTY_EXPORT MTY_ListNode *
 MTY_ListGetFirst(MTY_List *ctx);
 
+/// @brief Get the last node in a list.
+/// @param ctx An MTY_List.
+/// @returns The last node, or NULL if the list is empty.
+MTY_EXPORT MTY_ListNode *
+MTY_ListGetLast(MTY_List *ctx);
+
 /// @brief Append an item to a list.
+/// @details Nodes come from a pool owned by the list, so once the list has reached
+///   its working size, appending and removing items does not allocate.
 /// @param ctx An MTY_List.
 /// @param value Value to append.
-MTY_EXPORT void
+/// @returns The new node holding `value`. It remains valid until it is removed.
+MTY_EXPORT MTY_ListNode *
 MTY_ListAppend(MTY_List *ctx, void *value);
 
+/// @brief Insert an item at the start of a list.
+/// @param ctx An MTY_List.
+/// @param value Value to insert.
+/// @returns The new node holding `value`. It remains valid until it is removed.
+MTY_EXPORT MTY_ListNode *
+MTY_ListPrepend(MTY_List *ctx, void *value);
+
+/// @brief Insert an item in front of a node.
+/// @param ctx An MTY_List.
+/// @param before The node in the list that will follow the new node. If NULL, the
+///   item is appended.
+/// @param value Value to insert.
+/// @returns The new node holding `value`. It remains valid until it is removed.
+MTY_EXPORT MTY_ListNode *
+MTY_ListInsertBefore(MTY_List *ctx, MTY_ListNode *before, void *value);
+
+/// @brief Insert an item behind a node.
+/// @param ctx An MTY_List.
+/// @param after The node in the list that will precede the new node. If NULL, the
+///   item is prepended.
+/// @param value Value to insert.
+/// @returns The new node holding `value`. It remains valid until it is removed.
+MTY_EXPORT MTY_ListNode *
+MTY_ListInsertAfter(MTY_List *ctx, MTY_ListNode *after, void *value);
+
+/// @brief Move a node to a new position in the same list.
+/// @details This is O(1) and never allocates, so moving a node to the front on
+///   every access makes the list a least recently used cache.
+/// @param ctx An MTY_List.
+/// @param node The node in the list to move.
+/// @param before The node in the list that will follow `node`. If NULL, `node` is
+///   moved to the end.
+MTY_EXPORT void
+MTY_ListMove(MTY_List *ctx, MTY_ListNode *node, MTY_ListNode *before);
+
+/// @brief Move every node of another list into this one.
+/// @details This is O(1) and never allocates. Nodes keep their addresses and now
+///   belong to `ctx`, and `other` is left empty but may still be used.
+/// @param ctx An MTY_List receiving the nodes.
+/// @param before The node in `ctx` that will follow the moved nodes. If NULL, the
+///   nodes are appended.
+/// @param other An MTY_List to take the nodes from. If this is `ctx`, nothing happens.
+MTY_EXPORT void
+MTY_ListSplice(MTY_List *ctx, MTY_ListNode *before, MTY_List *other);
+
 /// @brief Remove a node from a list and return its item.
 /// @param ctx An MTY_List.
-/// @param node The node in the list that should be removed.
+/// @param node The node in the list that should be removed. Its memory is recycled
+///   by the list and must not be used afterwards.
 /// @returns The value associated with the removed `node`.
 MTY_EXPORT void *
 MTY_ListRemove(MTY_List *ctx, MTY_ListNode *node);
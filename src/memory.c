@@ -21,9 +21,46 @@ void MTY_SecureZero(void *mem, size_t size)
 		MEMORY_MEMSET(mem, 0, size);
 }
 
+// Allocator
+
+// MEMORY_HOOKS is NULL while the C standard library is in use, keeping the default
+// path a single well predicted branch
+
+static MTY_Allocator MEMORY_ALLOCATOR;
+static const MTY_Allocator *MEMORY_HOOKS;
+
+void MTY_SetAllocator(const MTY_Allocator *allocator)
+{
+	if (allocator) {
+		MEMORY_ALLOCATOR = *allocator;
+		MEMORY_HOOKS = &MEMORY_ALLOCATOR;
+
+	} else {
+		MEMORY_HOOKS = NULL;
+	}
+}
+
+const MTY_Allocator *MTY_GetAllocator(void)
+{
+	return MEMORY_HOOKS;
+}
+
+// `calloc` rejects a `len * size` that overflows, the other paths need to as well
+
+static size_t memory_total(const char *func, size_t len, size_t size)
+{
+	if (len != 0 && size > SIZE_MAX / len)
+		MTY_LogFatalParams(func, "Allocation of %zu elements of %zu bytes overflows", len, size);
+
+	return len * size;
+}
+
 void *MTY_Alloc(size_t len, size_t size)
 {
-	void *mem = calloc(len, size);
+	size_t total = memory_total(__FUNCTION__, len, size);
+
+	void *mem = MEMORY_HOOKS ? MEMORY_HOOKS->alloc(total, true, MEMORY_HOOKS->opaque) :
+		calloc(len, size);
 
 	if (!mem)
 		MTY_LogFatal("'calloc' failed with errno %d", errno);
@@ -31,9 +68,27 @@ void *MTY_Alloc(size_t len, size_t size)
 	return mem;
 }
 
+void *MTY_AllocUninit(size_t len, size_t size)
+{
+	size_t total = memory_total(__FUNCTION__, len, size);
+
+	void *mem = MEMORY_HOOKS ? MEMORY_HOOKS->alloc(total, false, MEMORY_HOOKS->opaque) :
+		malloc(total > 0 ? total : 1);
+
+	if (!mem)
+		MTY_LogFatal("'malloc' failed with errno %d", errno);
+
+	return mem;
+}
+
 void MTY_Free(void *mem)
 {
-	free(mem);
+	if (MEMORY_HOOKS) {
+		MEMORY_HOOKS->free(mem, MEMORY_HOOKS->opaque);
+
+	} else {
+		free(mem);
+	}
 }
 
 void MTY_SecureFree(void *mem, size_t size)
@@ -44,9 +99,10 @@ void MTY_SecureFree(void *mem, size_t size)
 
 void *MTY_Realloc(void *mem, size_t len, size_t size)
 {
-	size_t total = size * len;
+	size_t total = memory_total(__FUNCTION__, len, size);
 
-	void *new_mem = realloc(mem, total);
+	void *new_mem = MEMORY_HOOKS ? MEMORY_HOOKS->realloc(mem, total, MEMORY_HOOKS->opaque) :
+		realloc(mem, total);
 
 	if (!new_mem && total > 0)
 		MTY_LogFatal("'realloc' failed with errno %d", errno);
@@ -54,9 +110,789 @@ void *MTY_Realloc(void *mem, size_t len, size_t size)
 	return new_mem;
 }
 
+
+// Pool
+
+// Objects are carved out of slabs that double in size up to POOL_SLAB_MAX objects.
+// Each thread keeps its own free list per pool, so allocating and freeing only
+// touches the pool's mutex when a whole batch moves between the thread and the
+// shared lists. Each slab keeps its own free list, and once all of its objects are
+// back the slab is returned to the system, keeping up to POOL_EMPTY_MAX of them
+// around so a pool that repeatedly grows and shrinks doesn't churn. A thread's
+// cache entry holds a reference on the pool so the entry can tell when the pool
+// has been destroyed underneath it
+
+#define POOL_ALIGN     16
+#define POOL_SLAB_MIN  32
+#define POOL_SLAB_MAX  1024
+#define POOL_BATCH     32
+#define POOL_CACHE_MAX (POOL_BATCH * 2)
+#define POOL_CACHES    8
+#define POOL_EMPTY_MAX 1
+
+#define POOL_ROUND(v) \
+	(((v) + POOL_ALIGN - 1) & ~((size_t) POOL_ALIGN - 1))
+
+struct pool_obj {
+	struct pool_obj *next;
+};
+
+struct pool_slab {
+	struct pool_slab *prev;
+	struct pool_slab *next;
+	struct pool_obj *free;
+	uint32_t len;
+	uint32_t nfree;
+};
+
+struct pool_cache {
+	MTY_Pool *pool;
+	struct pool_obj *head;
+	uint32_t len;
+};
+
+struct MTY_Pool {
+	size_t size;
+	size_t stride;
+	uint32_t slab_len;
+
+	MTY_Mutex *mutex;
+	struct pool_slab **slabs; // Sorted by address
+	uint32_t nslabs;
+	uint32_t cap;
+	struct pool_slab *avail;  // Slabs with free objects
+	uint32_t empty;
+
+	MTY_Atomic32 refs;
+	MTY_Atomic32 destroyed;
+};
+
+static TLOCAL struct pool_cache POOL_CACHE[POOL_CACHES];
+static TLOCAL uint32_t POOL_EVICT;
+
+static void pool_unref(MTY_Pool *ctx)
+{
+	if (MTY_Atomic32Add(&ctx->refs, -1) == 0) {
+		MTY_MutexDestroy(&ctx->mutex);
+		MTY_Free(ctx);
+	}
+}
+
+static uint32_t pool_find(MTY_Pool *ctx, const void *obj)
+{
+	uint32_t lo = 0;
+	uint32_t hi = ctx->nslabs;
+
+	// The last slab starting at or before `obj`
+	while (lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+
+		if ((uintptr_t) ctx->slabs[mid] <= (uintptr_t) obj) {
+			lo = mid + 1;
+
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo - 1;
+}
+
+static void pool_avail_add(MTY_Pool *ctx, struct pool_slab *slab)
+{
+	slab->prev = NULL;
+	slab->next = ctx->avail;
+
+	if (ctx->avail)
+		ctx->avail->prev = slab;
+
+	ctx->avail = slab;
+}
+
+static void pool_avail_remove(MTY_Pool *ctx, struct pool_slab *slab)
+{
+	if (slab->prev) {
+		slab->prev->next = slab->next;
+
+	} else {
+		ctx->avail = slab->next;
+	}
+
+	if (slab->next)
+		slab->next->prev = slab->prev;
+}
+
+static void pool_slab_create(MTY_Pool *ctx)
+{
+	ctx->slab_len = ctx->slab_len < POOL_SLAB_MAX ? ctx->slab_len * 2 : POOL_SLAB_MAX;
+
+	struct pool_slab *slab = MTY_AllocUninit(1, POOL_ROUND(sizeof(struct pool_slab)) +
+		ctx->slab_len * ctx->stride);
+	slab->free = NULL;
+	slab->len = slab->nfree = ctx->slab_len;
+
+	uint8_t *objs = (uint8_t *) slab + POOL_ROUND(sizeof(struct pool_slab));
+
+	for (uint32_t x = slab->len; x > 0; x--) {
+		struct pool_obj *obj = (struct pool_obj *) (objs + (x - 1) * ctx->stride);
+		obj->next = slab->free;
+		slab->free = obj;
+	}
+
+	if (ctx->nslabs == ctx->cap) {
+		ctx->cap = ctx->cap > 0 ? ctx->cap * 2 : 8;
+		ctx->slabs = MTY_Realloc(ctx->slabs, ctx->cap, sizeof(struct pool_slab *));
+	}
+
+	uint32_t index = ctx->nslabs > 0 ? pool_find(ctx, slab) + 1 : 0;
+	memmove(&ctx->slabs[index + 1], &ctx->slabs[index], (ctx->nslabs - index) * sizeof(struct pool_slab *));
+	ctx->slabs[index] = slab;
+	ctx->nslabs++;
+
+	pool_avail_add(ctx, slab);
+	ctx->empty++;
+}
+
+static void pool_slab_destroy(MTY_Pool *ctx, uint32_t index)
+{
+	struct pool_slab *slab = ctx->slabs[index];
+	pool_avail_remove(ctx, slab);
+
+	ctx->nslabs--;
+	memmove(&ctx->slabs[index], &ctx->slabs[index + 1], (ctx->nslabs - index) * sizeof(struct pool_slab *));
+
+	MTY_Free(slab);
+}
+
+static void pool_give(MTY_Pool *ctx, struct pool_cache *c, uint32_t n)
+{
+	MTY_MutexLock(ctx->mutex);
+
+	// The slabs of a destroyed pool are already gone along with any cached objects
+	if (MTY_Atomic32Get(&ctx->destroyed)) {
+		c->head = NULL;
+		c->len = 0;
+	}
+
+	for (uint32_t x = 0; x < n && c->head; x++) {
+		struct pool_obj *obj = c->head;
+		c->head = obj->next;
+		c->len--;
+
+		uint32_t index = pool_find(ctx, obj);
+		struct pool_slab *slab = ctx->slabs[index];
+
+		obj->next = slab->free;
+		slab->free = obj;
+
+		if (slab->nfree++ == 0)
+			pool_avail_add(ctx, slab);
+
+		if (slab->nfree == slab->len) {
+			if (ctx->empty < POOL_EMPTY_MAX) {
+				ctx->empty++;
+
+			} else {
+				pool_slab_destroy(ctx, index);
+			}
+		}
+	}
+
+	MTY_MutexUnlock(ctx->mutex);
+}
+
+static void pool_take(MTY_Pool *ctx, struct pool_cache *c)
+{
+	MTY_MutexLock(ctx->mutex);
+
+	for (uint32_t x = 0; x < POOL_BATCH; x++) {
+		if (!ctx->avail)
+			pool_slab_create(ctx);
+
+		struct pool_slab *slab = ctx->avail;
+
+		if (slab->nfree == slab->len)
+			ctx->empty--;
+
+		struct pool_obj *obj = slab->free;
+		slab->free = obj->next;
+
+		if (--slab->nfree == 0)
+			pool_avail_remove(ctx, slab);
+
+		obj->next = c->head;
+		c->head = obj;
+		c->len++;
+	}
+
+	MTY_MutexUnlock(ctx->mutex);
+}
+
+static void pool_cache_release(struct pool_cache *c)
+{
+	if (!c->pool)
+		return;
+
+	pool_give(c->pool, c, c->len);
+	pool_unref(c->pool);
+	memset(c, 0, sizeof(struct pool_cache));
+}
+
+static struct pool_cache *pool_cache(MTY_Pool *ctx)
+{
+	struct pool_cache *c = NULL;
+
+	for (uint32_t x = 0; x < POOL_CACHES; x++) {
+		if (POOL_CACHE[x].pool == ctx)
+			return &POOL_CACHE[x];
+
+		if (!c && (!POOL_CACHE[x].pool || MTY_Atomic32Get(&POOL_CACHE[x].pool->destroyed)))
+			c = &POOL_CACHE[x];
+	}
+
+	if (!c)
+		c = &POOL_CACHE[POOL_EVICT++ % POOL_CACHES];
+
+	pool_cache_release(c);
+
+	c->pool = ctx;
+	MTY_Atomic32Add(&ctx->refs, 1);
+
+	return c;
+}
+
+static void pool_release_caches(void)
+{
+	for (uint32_t x = 0; x < POOL_CACHES; x++)
+		pool_cache_release(&POOL_CACHE[x]);
+}
+
+MTY_Pool *MTY_PoolCreate(size_t size)
+{
+	MTY_Pool *ctx = MTY_Alloc(1, sizeof(MTY_Pool));
+	ctx->size = size;
+	ctx->stride = POOL_ROUND(size > sizeof(struct pool_obj) ? size : sizeof(struct pool_obj));
+	ctx->slab_len = POOL_SLAB_MIN / 2;
+	ctx->mutex = MTY_MutexCreate();
+
+	MTY_Atomic32Set(&ctx->refs, 1);
+
+	return ctx;
+}
+
+void MTY_PoolDestroy(MTY_Pool **pool)
+{
+	if (!pool || !*pool)
+		return;
+
+	MTY_Pool *ctx = *pool;
+
+	// Threads still caching objects from this pool notice the flag the next time
+	// they look at their caches, the header and mutex live until they let go
+	MTY_MutexLock(ctx->mutex);
+	MTY_Atomic32Set(&ctx->destroyed, 1);
+
+	for (uint32_t x = 0; x < ctx->nslabs; x++)
+		MTY_Free(ctx->slabs[x]);
+
+	MTY_Free(ctx->slabs);
+	ctx->slabs = NULL;
+	ctx->nslabs = 0;
+	ctx->avail = NULL;
+	MTY_MutexUnlock(ctx->mutex);
+
+	for (uint32_t x = 0; x < POOL_CACHES; x++)
+		if (POOL_CACHE[x].pool == ctx)
+			pool_cache_release(&POOL_CACHE[x]);
+
+	pool_unref(ctx);
+	*pool = NULL;
+}
+
+void *MTY_PoolAlloc(MTY_Pool *ctx)
+{
+	struct pool_cache *c = pool_cache(ctx);
+
+	if (!c->head)
+		pool_take(ctx, c);
+
+	struct pool_obj *obj = c->head;
+	c->head = obj->next;
+	c->len--;
+
+	memset(obj, 0, ctx->size);
+
+	return obj;
+}
+
+void MTY_PoolFree(MTY_Pool *ctx, void *obj)
+{
+	if (!obj)
+		return;
+
+	struct pool_cache *c = pool_cache(ctx);
+
+	struct pool_obj *o = obj;
+	o->next = c->head;
+	c->head = o;
+	c->len++;
+
+	if (c->len > POOL_CACHE_MAX)
+		pool_give(ctx, c, POOL_BATCH);
+}
+
+
+// Thread cache
+
+// Blocks carry a small header with their size class. Classes are powers of two
+// from 16 to 2048 bytes, anything larger goes straight to the C standard library.
+// Freed blocks are kept on the freeing thread's list for its class until the list
+// holds TCACHE_BUDGET bytes
+
+#define TCACHE_CLASSES   8
+#define TCACHE_MIN       16
+#define TCACHE_LARGE     UINT32_MAX
+#define TCACHE_BUDGET    (64 * 1024)
+#define TCACHE_HEADER    16
+
+struct tcache_header {
+	size_t size;
+	uint32_t cls;
+};
+
+struct tcache_block {
+	struct tcache_block *next;
+};
+
+static TLOCAL struct tcache_block *TCACHE_FREE[TCACHE_CLASSES];
+static TLOCAL uint32_t TCACHE_LEN[TCACHE_CLASSES];
+
+static uint32_t tcache_class(size_t size)
+{
+	uint32_t cls = 0;
+
+	while (cls < TCACHE_CLASSES && ((size_t) TCACHE_MIN << cls) < size)
+		cls++;
+
+	return cls < TCACHE_CLASSES ? cls : TCACHE_LARGE;
+}
+
+static struct tcache_header *tcache_header(void *mem)
+{
+	return (struct tcache_header *) ((uint8_t *) mem - TCACHE_HEADER);
+}
+
+static void *tcache_alloc(size_t size, bool zero, void *opaque)
+{
+	uint32_t cls = tcache_class(size);
+	struct tcache_header *h = NULL;
+
+	if (cls != TCACHE_LARGE && TCACHE_FREE[cls]) {
+		struct tcache_block *b = TCACHE_FREE[cls];
+		TCACHE_FREE[cls] = b->next;
+		TCACHE_LEN[cls]--;
+
+		h = tcache_header(b);
+
+	} else {
+		size_t usable = cls != TCACHE_LARGE ? (size_t) TCACHE_MIN << cls : size;
+
+		h = malloc(TCACHE_HEADER + usable);
+		if (!h)
+			return NULL;
+
+		h->size = usable;
+		h->cls = cls;
+	}
+
+	void *mem = (uint8_t *) h + TCACHE_HEADER;
+
+	if (zero)
+		memset(mem, 0, size);
+
+	return mem;
+}
+
+static void tcache_free(void *mem, void *opaque)
+{
+	if (!mem)
+		return;
+
+	struct tcache_header *h = tcache_header(mem);
+
+	if (h->cls != TCACHE_LARGE && TCACHE_LEN[h->cls] < TCACHE_BUDGET / h->size) {
+		struct tcache_block *b = mem;
+		b->next = TCACHE_FREE[h->cls];
+		TCACHE_FREE[h->cls] = b;
+		TCACHE_LEN[h->cls]++;
+
+	} else {
+		free(h);
+	}
+}
+
+static void *tcache_realloc(void *mem, size_t size, void *opaque)
+{
+	if (!mem)
+		return tcache_alloc(size, false, opaque);
+
+	if (size == 0) {
+		tcache_free(mem, opaque);
+		return NULL;
+	}
+
+	struct tcache_header *h = tcache_header(mem);
+
+	if (h->cls == TCACHE_LARGE && tcache_class(size) == TCACHE_LARGE) {
+		h = realloc(h, TCACHE_HEADER + size);
+		if (!h)
+			return NULL;
+
+		h->size = size;
+
+		return (uint8_t *) h + TCACHE_HEADER;
+	}
+
+	if (h->cls != TCACHE_LARGE && size <= h->size)
+		return mem;
+
+	void *new_mem = tcache_alloc(size, false, opaque);
+
+	if (new_mem) {
+		memcpy(new_mem, mem, MTY_MIN(h->size, size));
+		tcache_free(mem, opaque);
+	}
+
+	return new_mem;
+}
+
+static const MTY_Allocator TCACHE_ALLOCATOR = {
+	.alloc = tcache_alloc,
+	.realloc = tcache_realloc,
+	.free = tcache_free,
+};
+
+const MTY_Allocator *MTY_GetThreadCacheAllocator(void)
+{
+	return &TCACHE_ALLOCATOR;
+}
+
+void MTY_ReleaseThreadCache(void)
+{
+	for (uint32_t x = 0; x < TCACHE_CLASSES; x++) {
+		while (TCACHE_FREE[x]) {
+			struct tcache_block *b = TCACHE_FREE[x];
+			TCACHE_FREE[x] = b->next;
+
+			free(tcache_header(b));
+		}
+
+		TCACHE_LEN[x] = 0;
+	}
+
+	pool_release_caches();
+	mty_tlocal_release();
+}
+
+
+// Statistics
+
+// Each block is prefixed with its size and the tag that was current when it was
+// allocated. Counters are shared by all threads and updated with relaxed atomics
+
+#define STATS_HEADER 16
+#define STATS_TAGS   64
+
+struct stats_header {
+	uint64_t size;
+	uint32_t tag;
+};
+
+struct stats_counters {
+	MTY_Atomic64 live_bytes;
+	MTY_Atomic64 live_count;
+	MTY_Atomic64 peak_bytes;
+	MTY_Atomic64 alloc_count;
+	MTY_Atomic64 free_count;
+	MTY_Atomic64 total_bytes;
+	MTY_Atomic64 histogram[MTY_MEMORY_HISTOGRAM];
+};
+
+// Tag 0 is reserved for untagged allocations
+static MTY_AtomicPtr STATS_NAMES[STATS_TAGS];
+static struct stats_counters STATS_TAG_COUNTERS[STATS_TAGS];
+static struct stats_counters STATS_TOTAL;
+static TLOCAL uint32_t STATS_TAG;
+
+static MTY_Allocator STATS_BASE;
+static bool STATS_BASE_HOOKS;
+
+static struct stats_header *stats_header(void *mem)
+{
+	return (struct stats_header *) ((uint8_t *) mem - STATS_HEADER);
+}
+
+static uint32_t stats_bucket(uint64_t size)
+{
+	uint32_t bucket = 0;
+
+	while (bucket < MTY_MEMORY_HISTOGRAM - 1 && ((uint64_t) 16 << bucket) < size)
+		bucket++;
+
+	return bucket;
+}
+
+static void stats_adjust(struct stats_counters *c, int64_t delta)
+{
+	int64_t live = MTY_Atomic64AddEx(&c->live_bytes, delta, MTY_MEMORY_ORDER_RELAXED);
+
+	for (int64_t peak = MTY_Atomic64GetEx(&c->peak_bytes, MTY_MEMORY_ORDER_RELAXED); live > peak;
+		peak = MTY_Atomic64GetEx(&c->peak_bytes, MTY_MEMORY_ORDER_RELAXED))
+	{
+		if (MTY_Atomic64CASEx(&c->peak_bytes, peak, live, MTY_MEMORY_ORDER_RELAXED))
+			break;
+	}
+}
+
+static void stats_add(struct stats_counters *c, uint64_t size)
+{
+	stats_adjust(c, size);
+
+	MTY_Atomic64AddEx(&c->live_count, 1, MTY_MEMORY_ORDER_RELAXED);
+	MTY_Atomic64AddEx(&c->alloc_count, 1, MTY_MEMORY_ORDER_RELAXED);
+	MTY_Atomic64AddEx(&c->total_bytes, size, MTY_MEMORY_ORDER_RELAXED);
+	MTY_Atomic64AddEx(&c->histogram[stats_bucket(size)], 1, MTY_MEMORY_ORDER_RELAXED);
+}
+
+static void stats_remove(struct stats_counters *c, uint64_t size)
+{
+	MTY_Atomic64AddEx(&c->live_bytes, -(int64_t) size, MTY_MEMORY_ORDER_RELAXED);
+	MTY_Atomic64AddEx(&c->live_count, -1, MTY_MEMORY_ORDER_RELAXED);
+	MTY_Atomic64AddEx(&c->free_count, 1, MTY_MEMORY_ORDER_RELAXED);
+}
+
+static void *stats_alloc(size_t size, bool zero, void *opaque)
+{
+	struct stats_header *h = STATS_BASE_HOOKS ?
+		STATS_BASE.alloc(STATS_HEADER + size, zero, STATS_BASE.opaque) :
+		zero ? calloc(1, STATS_HEADER + size) : malloc(STATS_HEADER + size);
+
+	if (!h)
+		return NULL;
+
+	h->size = size;
+	h->tag = STATS_TAG;
+
+	stats_add(&STATS_TOTAL, size);
+	stats_add(&STATS_TAG_COUNTERS[h->tag], size);
+
+	return (uint8_t *) h + STATS_HEADER;
+}
+
+static void stats_free(void *mem, void *opaque)
+{
+	if (!mem)
+		return;
+
+	struct stats_header *h = stats_header(mem);
+
+	stats_remove(&STATS_TOTAL, h->size);
+	stats_remove(&STATS_TAG_COUNTERS[h->tag], h->size);
+
+	if (STATS_BASE_HOOKS) {
+		STATS_BASE.free(h, STATS_BASE.opaque);
+
+	} else {
+		free(h);
+	}
+}
+
+static void *stats_realloc(void *mem, size_t size, void *opaque)
+{
+	if (!mem)
+		return stats_alloc(size, false, opaque);
+
+	if (size == 0) {
+		stats_free(mem, opaque);
+		return NULL;
+	}
+
+	struct stats_header *h = stats_header(mem);
+	uint64_t old_size = h->size;
+
+	h = STATS_BASE_HOOKS ? STATS_BASE.realloc(h, STATS_HEADER + size, STATS_BASE.opaque) :
+		realloc(h, STATS_HEADER + size);
+
+	if (!h)
+		return NULL;
+
+	// A resized block keeps the tag it was allocated with
+	h->size = size;
+
+	stats_adjust(&STATS_TOTAL, (int64_t) size - (int64_t) old_size);
+	stats_adjust(&STATS_TAG_COUNTERS[h->tag], (int64_t) size - (int64_t) old_size);
+
+	return (uint8_t *) h + STATS_HEADER;
+}
+
+// Statistics are enabled for as long as the wrapper stays installed
+
+static bool stats_enabled(void)
+{
+	return MEMORY_HOOKS && MEMORY_HOOKS->alloc == stats_alloc;
+}
+
+void MTY_EnableMemoryStats(void)
+{
+	if (stats_enabled())
+		return;
+
+	const MTY_Allocator *base = MTY_GetAllocator();
+	STATS_BASE_HOOKS = base != NULL;
+
+	if (base)
+		STATS_BASE = *base;
+
+	MTY_Allocator allocator = {
+		.alloc = stats_alloc,
+		.realloc = stats_realloc,
+		.free = stats_free,
+		.allocAligned = base ? base->allocAligned : NULL,
+		.freeAligned = base ? base->freeAligned : NULL,
+		.opaque = base ? base->opaque : NULL,
+	};
+
+	MTY_SetAllocator(&allocator);
+}
+
+static uint32_t stats_find_tag(const char *tag, bool insert)
+{
+	for (uint32_t x = 1; x < STATS_TAGS; x++) {
+		const char *name = MTY_AtomicPtrGet(&STATS_NAMES[x], MTY_MEMORY_ORDER_ACQUIRE);
+
+		if (!name) {
+			if (!insert)
+				return 0;
+
+			// Another thread may claim this slot first, in which case it is checked again
+			if (!MTY_AtomicPtrCAS(&STATS_NAMES[x], NULL, (void *) tag, MTY_MEMORY_ORDER_ACQ_REL)) {
+				x--;
+				continue;
+			}
+
+			return x;
+		}
+
+		if (!strcmp(name, tag))
+			return x;
+	}
+
+	return 0;
+}
+
+const char *MTY_SetMemoryTag(const char *tag)
+{
+	if (!stats_enabled())
+		return NULL;
+
+	const char *prev = MTY_AtomicPtrGet(&STATS_NAMES[STATS_TAG], MTY_MEMORY_ORDER_RELAXED);
+
+	STATS_TAG = tag ? stats_find_tag(tag, true) : 0;
+
+	return prev;
+}
+
+static void stats_read(struct stats_counters *c, MTY_MemoryStats *stats)
+{
+	stats->liveBytes = MTY_Atomic64GetEx(&c->live_bytes, MTY_MEMORY_ORDER_RELAXED);
+	stats->liveCount = MTY_Atomic64GetEx(&c->live_count, MTY_MEMORY_ORDER_RELAXED);
+	stats->peakBytes = MTY_Atomic64GetEx(&c->peak_bytes, MTY_MEMORY_ORDER_RELAXED);
+	stats->allocCount = MTY_Atomic64GetEx(&c->alloc_count, MTY_MEMORY_ORDER_RELAXED);
+	stats->freeCount = MTY_Atomic64GetEx(&c->free_count, MTY_MEMORY_ORDER_RELAXED);
+	stats->totalBytes = MTY_Atomic64GetEx(&c->total_bytes, MTY_MEMORY_ORDER_RELAXED);
+
+	for (uint32_t x = 0; x < MTY_MEMORY_HISTOGRAM; x++)
+		stats->histogram[x] = MTY_Atomic64GetEx(&c->histogram[x], MTY_MEMORY_ORDER_RELAXED);
+}
+
+bool MTY_GetMemoryStats(const char *tag, MTY_MemoryStats *stats)
+{
+	if (!stats_enabled())
+		return false;
+
+	if (!tag) {
+		stats_read(&STATS_TOTAL, stats);
+		return true;
+	}
+
+	uint32_t x = stats_find_tag(tag, false);
+	if (x == 0)
+		return false;
+
+	stats_read(&STATS_TAG_COUNTERS[x], stats);
+
+	return true;
+}
+
+static MTY_JSON *stats_json(const MTY_MemoryStats *stats)
+{
+	MTY_JSON *obj = MTY_JSONObjCreate();
+	MTY_JSONObjSetItem(obj, "liveBytes", MTY_JSONNumberCreate((double) stats->liveBytes));
+	MTY_JSONObjSetItem(obj, "liveCount", MTY_JSONNumberCreate((double) stats->liveCount));
+	MTY_JSONObjSetItem(obj, "peakBytes", MTY_JSONNumberCreate((double) stats->peakBytes));
+	MTY_JSONObjSetItem(obj, "allocCount", MTY_JSONNumberCreate((double) stats->allocCount));
+	MTY_JSONObjSetItem(obj, "freeCount", MTY_JSONNumberCreate((double) stats->freeCount));
+	MTY_JSONObjSetItem(obj, "totalBytes", MTY_JSONNumberCreate((double) stats->totalBytes));
+
+	MTY_JSON *histogram = MTY_JSONArrayCreate(MTY_MEMORY_HISTOGRAM);
+
+	for (uint32_t x = 0; x < MTY_MEMORY_HISTOGRAM; x++)
+		MTY_JSONArraySetItem(histogram, x, MTY_JSONNumberCreate((double) stats->histogram[x]));
+
+	MTY_JSONObjSetItem(obj, "histogram", histogram);
+
+	return obj;
+}
+
+MTY_JSON *MTY_GetMemoryStatsJSON(void)
+{
+	if (!stats_enabled())
+		return NULL;
+
+	// Take the snapshot first so the JSON being built doesn't show up in it
+	const char *names[STATS_TAGS] = {0};
+	MTY_MemoryStats *stats = MTY_AllocUninit(STATS_TAGS, sizeof(MTY_MemoryStats));
+
+	stats_read(&STATS_TOTAL, &stats[0]);
+
+	for (uint32_t x = 1; x < STATS_TAGS; x++) {
+		names[x] = MTY_AtomicPtrGet(&STATS_NAMES[x], MTY_MEMORY_ORDER_ACQUIRE);
+
+		if (names[x])
+			stats_read(&STATS_TAG_COUNTERS[x], &stats[x]);
+	}
+
+	MTY_JSON *json = MTY_JSONObjCreate();
+	MTY_JSONObjSetItem(json, "total", stats_json(&stats[0]));
+
+	MTY_JSON *tags = MTY_JSONObjCreate();
+
+	for (uint32_t x = 1; x < STATS_TAGS && names[x]; x++)
+		MTY_JSONObjSetItem(tags, names[x], stats_json(&stats[x]));
+
+	MTY_JSONObjSetItem(json, "tags", tags);
+
+	MTY_Free(stats);
+
+	return json;
+}
+
+
+// Strings
+
 void *MTY_Dup(const void *mem, size_t size)
 {
-	void *dup = MTY_Alloc(size, 1);
+	void *dup = MTY_AllocUninit(size, 1);
 	memcpy(dup, mem, size);
 
 	return dup;
@@ -113,13 +949,10 @@ const char *MTY_SprintfDL(const char *fmt, ...)
 	va_list args;
 	va_start(args, fmt);
 
-	char *str = MTY_VsprintfD(fmt, args);
+	char *local = mty_tlocal_vsprintf(fmt, args);
 
 	va_end(args);
 
-	char *local = mty_tlocal_strcpy(str);
-	MTY_Free(str);
-
 	return local;
 }
 
@@ -148,6 +981,150 @@ bool MTY_StrSearch(const char *s0, const char *s1, const char *delim)
 }
 
 
+// Arena
+
+// Chunks form a list from oldest to newest. `cur` is the chunk being bumped, chunks
+// behind it are spares left over from a reset and are reused before allocating.
+// Allocations too big for a regular chunk get a dedicated chunk of their own
+
+#define ARENA_CHUNK_SIZE (64 * 1024)
+#define ARENA_ALIGN      16
+
+struct arena_chunk {
+	struct arena_chunk *next;
+	size_t size;
+	size_t used;
+};
+
+#define ARENA_HEADER ((sizeof(struct arena_chunk) + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1))
+
+struct MTY_Arena {
+	size_t chunk_size;
+	struct arena_chunk *first;
+	struct arena_chunk *cur;
+};
+
+static uint8_t *arena_chunk_data(struct arena_chunk *c)
+{
+	return (uint8_t *) c + ARENA_HEADER;
+}
+
+static void *arena_chunk_bump(struct arena_chunk *c, size_t size, size_t align)
+{
+	uintptr_t base = (uintptr_t) arena_chunk_data(c);
+	uintptr_t ptr = (base + c->used + align - 1) & ~((uintptr_t) align - 1);
+
+	if (ptr > base + c->size || size > base + c->size - ptr)
+		return NULL;
+
+	c->used = ptr + size - base;
+
+	return (void *) ptr;
+}
+
+MTY_Arena *MTY_ArenaCreate(size_t chunkSize)
+{
+	MTY_Arena *ctx = MTY_Alloc(1, sizeof(MTY_Arena));
+	ctx->chunk_size = chunkSize > 0 ? chunkSize : ARENA_CHUNK_SIZE;
+
+	return ctx;
+}
+
+void MTY_ArenaDestroy(MTY_Arena **arena)
+{
+	if (!arena || !*arena)
+		return;
+
+	MTY_Arena *ctx = *arena;
+
+	for (struct arena_chunk *c = ctx->first; c;) {
+		struct arena_chunk *next = c->next;
+
+		MTY_Free(c);
+		c = next;
+	}
+
+	MTY_Free(ctx);
+	*arena = NULL;
+}
+
+void *MTY_ArenaAllocAligned(MTY_Arena *ctx, size_t size, size_t align)
+{
+	if (align < ARENA_ALIGN)
+		align = ARENA_ALIGN;
+
+	if (size > SIZE_MAX - ARENA_HEADER - align)
+		MTY_LogFatal("Allocation of %zu bytes aligned to %zu overflows", size, align);
+
+	void *ptr = ctx->cur ? arena_chunk_bump(ctx->cur, size, align) : NULL;
+
+	// Move on to the next spare, or splice in a new chunk after the current one
+	while (!ptr) {
+		struct arena_chunk *next = ctx->cur ? ctx->cur->next : ctx->first;
+
+		if (!next || next->size < size + align) {
+			size_t csize = MTY_MAX(ctx->chunk_size, size + align);
+
+			struct arena_chunk *c = MTY_Alloc(ARENA_HEADER + csize, 1);
+			c->size = csize;
+			c->next = next;
+
+			if (ctx->cur) {
+				ctx->cur->next = c;
+
+			} else {
+				ctx->first = c;
+			}
+
+			next = c;
+		}
+
+		ctx->cur = next;
+		ptr = arena_chunk_bump(ctx->cur, size, align);
+	}
+
+	memset(ptr, 0, size);
+
+	return ptr;
+}
+
+void *MTY_ArenaAlloc(MTY_Arena *ctx, size_t len, size_t size)
+{
+	return MTY_ArenaAllocAligned(ctx, memory_total(__FUNCTION__, len, size), ARENA_ALIGN);
+}
+
+char *MTY_ArenaStrdup(MTY_Arena *ctx, const char *str)
+{
+	size_t size = strlen(str) + 1;
+
+	char *dup = MTY_ArenaAllocAligned(ctx, size, 1);
+	memcpy(dup, str, size);
+
+	return dup;
+}
+
+MTY_ArenaMark MTY_ArenaGetMark(MTY_Arena *ctx)
+{
+	MTY_ArenaMark mark = {0};
+	mark.chunk = ctx->cur;
+	mark.used = ctx->cur ? ctx->cur->used : 0;
+
+	return mark;
+}
+
+void MTY_ArenaReset(MTY_Arena *ctx, const MTY_ArenaMark *mark)
+{
+	ctx->cur = mark ? mark->chunk : NULL;
+
+	if (ctx->cur)
+		ctx->cur->used = mark->used;
+
+	// Everything behind the mark becomes a spare
+	for (struct arena_chunk *c = ctx->cur ? ctx->cur->next : ctx->first; c; c = c->next)
+		c->used = 0;
+}
+
+
 // Stable qsort
 
 struct element {
@@ -6,6 +6,31 @@
 
 #include <string.h>
 
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+// The slot state publishes the slot contents: the writer of a state releases,
+// the reader of a state acquires
+
+// The consumer only sleeps on pop_sync after announcing itself through `waiting`,
+// so producers can skip the signal entirely while it is busy. Announcing then
+// rechecking the slot, and publishing the slot then checking `waiting`, are both
+// sequentially consistent so at least one side always sees the other.
+
+// In SPSC mode the single producer needs no push_mutex, and the consumer spins
+// briefly before sleeping on multi core systems.
+
+// In ring mode slots carry no buffers of their own. Each message is reserved
+// contiguously from one byte arena at `ring_head`, and a message that would run
+// past the end of the arena skips to the start instead. Popping a slot advances
+// `ring_tail` to the end of its message, so the producer can compute free space
+// without any lock shared with the consumer.
+
+#define QUEUE_SPIN 1000
+#define QUEUE_CACHE_LINE 64
+#define QUEUE_RING_ALIGN(size) (((size) + 15) & ~((size_t) 15))
+
 enum {
 	QUEUE_EMPTY = 0,
 	QUEUE_FULL  = 1,
@@ -14,6 +39,7 @@ enum {
 struct queue_slot {
 	void *data;
 	size_t size;
+	uint64_t end;
 	bool ptr;
 	MTY_Atomic32 state;
 };
@@ -21,35 +47,97 @@ struct queue_slot {
 struct MTY_Queue {
 	size_t buf_size;
 	uint32_t len;
+	bool spsc;
+	bool spin;
 
 	MTY_Waitable *pop_sync;
 	MTY_Mutex *push_mutex;
 
 	struct queue_slot *slots;
+
+	uint8_t *ring;
+	size_t ring_size;
+
+	// Producer and consumer state each get their own cache line
+	uint8_t pad0[QUEUE_CACHE_LINE];
 	uint32_t push_pos;
+	uint64_t ring_head;
+	uint64_t ring_reserved;
+
+	uint8_t pad1[QUEUE_CACHE_LINE];
 	uint32_t pop_pos;
+	MTY_Atomic32 waiting;
+	MTY_Atomic64 ring_tail;
+
+	uint8_t pad2[QUEUE_CACHE_LINE];
 };
 
-MTY_Queue *MTY_QueueCreate(uint32_t len, size_t bufSize)
+static void queue_relax(void)
+{
+	#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		_mm_pause();
+	#elif defined(_MSC_VER) && defined(_M_ARM64)
+		__yield();
+	#elif defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+	#elif defined(__aarch64__) || defined(__arm__)
+		__asm__ __volatile__("yield");
+	#endif
+}
+
+static MTY_Queue *queue_create(uint32_t len, size_t bufSize, size_t ringSize, bool spsc)
 {
+	const char *tag = MTY_SetMemoryTag("queue");
+
 	MTY_Queue *ctx = MTY_Alloc(1, sizeof(MTY_Queue));
 	ctx->len = len;
 	ctx->buf_size = bufSize;
+	ctx->spsc = spsc;
+	ctx->spin = spsc && MTY_GetNumProcessors() > 1;
 
 	if (ctx->buf_size < sizeof(void *))
 		ctx->buf_size = sizeof(void *);
 
 	ctx->pop_sync = MTY_WaitableCreate();
-	ctx->push_mutex = MTY_MutexCreate();
+
+	if (!spsc)
+		ctx->push_mutex = MTY_MutexCreate();
 
 	ctx->slots = MTY_Alloc(ctx->len, sizeof(struct queue_slot));
 
-	for (uint32_t x = 0; x < ctx->len; x++)
-		ctx->slots[x].data = MTY_Alloc(ctx->buf_size, 1);
+	if (ringSize > 0) {
+		ctx->ring_size = QUEUE_RING_ALIGN(ringSize);
+
+		if (ctx->ring_size < QUEUE_RING_ALIGN(ctx->buf_size))
+			ctx->ring_size = QUEUE_RING_ALIGN(ctx->buf_size);
+
+		ctx->ring = MTY_AllocUninit(ctx->ring_size, 1);
+
+	} else {
+		for (uint32_t x = 0; x < ctx->len; x++)
+			ctx->slots[x].data = MTY_AllocUninit(ctx->buf_size, 1);
+	}
+
+	MTY_SetMemoryTag(tag);
 
 	return ctx;
 }
 
+MTY_Queue *MTY_QueueCreate(uint32_t len, size_t bufSize)
+{
+	return queue_create(len, bufSize, 0, false);
+}
+
+MTY_Queue *MTY_QueueCreateSPSC(uint32_t len, size_t bufSize)
+{
+	return queue_create(len, bufSize, 0, true);
+}
+
+MTY_Queue *MTY_QueueCreateRing(uint32_t len, size_t bufSize, size_t ringSize)
+{
+	return queue_create(len, bufSize, ringSize > 0 ? ringSize : 1, false);
+}
+
 void MTY_QueueDestroy(MTY_Queue **queue)
 {
 	if (!queue || !*queue)
@@ -57,12 +145,18 @@ void MTY_QueueDestroy(MTY_Queue **queue)
 
 	MTY_Queue *ctx = *queue;
 
-	for (uint32_t x = 0; x < ctx->len; x++)
-		MTY_Free(ctx->slots[x].data);
+	if (ctx->ring) {
+		MTY_Free(ctx->ring);
+
+	} else {
+		for (uint32_t x = 0; x < ctx->len; x++)
+			MTY_Free(ctx->slots[x].data);
+	}
 
 	MTY_Free(ctx->slots);
 
-	MTY_MutexDestroy(&ctx->push_mutex);
+	if (ctx->push_mutex)
+		MTY_MutexDestroy(&ctx->push_mutex);
 	MTY_WaitableDestroy(&ctx->pop_sync);
 
 	MTY_Free(ctx);
@@ -79,22 +173,81 @@ uint32_t MTY_QueueGetLength(MTY_Queue *ctx)
 	return (uint32_t) pos;
 }
 
-void *MTY_QueueGetInputBuffer(MTY_Queue *ctx)
+static void queue_push_lock(MTY_Queue *ctx)
 {
-	MTY_MutexLock(ctx->push_mutex);
+	if (ctx->push_mutex)
+		MTY_MutexLock(ctx->push_mutex);
+}
 
-	int32_t state = MTY_Atomic32Get(&ctx->slots[ctx->push_pos].state);
+static void queue_push_unlock(MTY_Queue *ctx)
+{
+	if (ctx->push_mutex)
+		MTY_MutexUnlock(ctx->push_mutex);
+}
 
-	if (state == QUEUE_EMPTY) {
-		return ctx->slots[ctx->push_pos].data;
+static void *queue_ring_reserve(MTY_Queue *ctx, size_t size)
+{
+	uint64_t tail = MTY_Atomic64GetEx(&ctx->ring_tail, MTY_MEMORY_ORDER_ACQUIRE);
+	uint64_t pos = ctx->ring_head;
+	size_t offset = (size_t) (pos % ctx->ring_size);
+	size_t need = QUEUE_RING_ALIGN(size);
 
-	} else {
-		MTY_MutexUnlock(ctx->push_mutex);
-	}
+	// Messages are never split, skip to the start of the arena if it doesn't fit
+	if (ctx->ring_size - offset < need)
+		pos += ctx->ring_size - offset;
+
+	// While anything is live, the message must end before the oldest one begins in
+	// the next lap. An empty ring can place it anywhere, and since `ring_tail` then
+	// lags behind the skipped space the next check only errs on the safe side
+	if (tail != ctx->ring_head && pos + need - tail > ctx->ring_size)
+		return NULL;
+
+	ctx->ring_reserved = pos;
+
+	return ctx->ring + pos % ctx->ring_size;
+}
+
+static size_t queue_max_size(MTY_Queue *ctx)
+{
+	// `buf_size` is only what MTY_QueueGetInputBuffer reserves in ring mode
+	return ctx->ring ? ctx->ring_size : ctx->buf_size;
+}
+
+static void *queue_reserve_locked(MTY_Queue *ctx, size_t size)
+{
+	if (size > queue_max_size(ctx))
+		return NULL;
+
+	int32_t state = MTY_Atomic32GetEx(&ctx->slots[ctx->push_pos].state, MTY_MEMORY_ORDER_ACQUIRE);
+
+	if (state == QUEUE_EMPTY)
+		return ctx->ring ? queue_ring_reserve(ctx, size) : ctx->slots[ctx->push_pos].data;
 
 	return NULL;
 }
 
+static void *queue_reserve(MTY_Queue *ctx, size_t size)
+{
+	queue_push_lock(ctx);
+
+	void *buffer = queue_reserve_locked(ctx, size);
+
+	if (!buffer)
+		queue_push_unlock(ctx);
+
+	return buffer;
+}
+
+void *MTY_QueueGetInputBuffer(MTY_Queue *ctx)
+{
+	return queue_reserve(ctx, ctx->buf_size);
+}
+
+void *MTY_QueueReserveInputBuffer(MTY_Queue *ctx, size_t size)
+{
+	return queue_reserve(ctx, size);
+}
+
 static uint32_t queue_next_pos(MTY_Queue *ctx, uint32_t pos)
 {
 	if (++pos == ctx->len)
@@ -103,21 +256,42 @@ static uint32_t queue_next_pos(MTY_Queue *ctx, uint32_t pos)
 	return pos;
 }
 
-static void queue_push(MTY_Queue *ctx, size_t size, bool ptr)
+static bool queue_commit(MTY_Queue *ctx, size_t size, bool ptr)
 {
 	if (size > 0 || ptr) {
 		uint32_t lock_pos = ctx->push_pos;
 		ctx->slots[lock_pos].size = size;
 
+		// Only the bytes actually written stay reserved in the arena
+		if (ctx->ring) {
+			ctx->ring_head = ctx->ring_reserved + QUEUE_RING_ALIGN(ptr ? sizeof(void *) : size);
+			ctx->slots[lock_pos].data = ctx->ring + ctx->ring_reserved % ctx->ring_size;
+			ctx->slots[lock_pos].end = ctx->ring_head;
+		}
+
 		ctx->push_pos = queue_next_pos(ctx, ctx->push_pos);
 
 		ctx->slots[lock_pos].ptr = ptr;
-		MTY_Atomic32Set(&ctx->slots[lock_pos].state, QUEUE_FULL);
+		MTY_Atomic32SetEx(&ctx->slots[lock_pos].state, QUEUE_FULL, MTY_MEMORY_ORDER_SEQ_CST);
 
-		MTY_WaitableSignal(ctx->pop_sync);
+		return true;
 	}
 
-	MTY_MutexUnlock(ctx->push_mutex);
+	return false;
+}
+
+static void queue_wake(MTY_Queue *ctx)
+{
+	if (MTY_Atomic32GetEx(&ctx->waiting, MTY_MEMORY_ORDER_SEQ_CST))
+		MTY_WaitableSignal(ctx->pop_sync);
+}
+
+static void queue_push(MTY_Queue *ctx, size_t size, bool ptr)
+{
+	if (queue_commit(ctx, size, ptr))
+		queue_wake(ctx);
+
+	queue_push_unlock(ctx);
 }
 
 void MTY_QueuePush(MTY_Queue *ctx, size_t size)
@@ -125,11 +299,43 @@ void MTY_QueuePush(MTY_Queue *ctx, size_t size)
 	queue_push(ctx, size, false);
 }
 
+static bool queue_full(MTY_Queue *ctx, MTY_MemoryOrder order)
+{
+	return MTY_Atomic32GetEx(&ctx->slots[ctx->pop_pos].state, order) == QUEUE_FULL;
+}
+
+static bool queue_wait(MTY_Queue *ctx, int32_t timeout)
+{
+	if (ctx->spin) {
+		for (uint32_t x = 0; x < QUEUE_SPIN; x++) {
+			if (queue_full(ctx, MTY_MEMORY_ORDER_RELAXED))
+				return true;
+
+			queue_relax();
+		}
+	}
+
+	MTY_Atomic32SetEx(&ctx->waiting, 1, MTY_MEMORY_ORDER_SEQ_CST);
+
+	// A push may have landed before the producer could see `waiting`
+	bool r = queue_full(ctx, MTY_MEMORY_ORDER_SEQ_CST);
+
+	// Because the signal is left set whenever the consumer was waiting, this may
+	// already be signaled when there is no data. Worst case the loop spins one
+	// extra time
+	if (!r)
+		r = MTY_WaitableWait(ctx->pop_sync, timeout);
+
+	MTY_Atomic32SetEx(&ctx->waiting, 0, MTY_MEMORY_ORDER_RELAXED);
+
+	return r;
+}
+
 static bool queue_pop(MTY_Queue *ctx, int32_t timeout, bool last, void **buffer, size_t *size)
 {
 	begin:
 
-	if (MTY_Atomic32Get(&ctx->slots[ctx->pop_pos].state) == QUEUE_FULL) {
+	if (MTY_Atomic32GetEx(&ctx->slots[ctx->pop_pos].state, MTY_MEMORY_ORDER_ACQUIRE) == QUEUE_FULL) {
 		*buffer = ctx->slots[ctx->pop_pos].data;
 
 		if (size)
@@ -138,7 +344,7 @@ static bool queue_pop(MTY_Queue *ctx, int32_t timeout, bool last, void **buffer,
 		if (last) {
 			uint32_t next_pos = queue_next_pos(ctx, ctx->pop_pos);
 
-			if (MTY_Atomic32Get(&ctx->slots[next_pos].state) == QUEUE_FULL) {
+			if (MTY_Atomic32GetEx(&ctx->slots[next_pos].state, MTY_MEMORY_ORDER_ACQUIRE) == QUEUE_FULL) {
 				MTY_QueuePop(ctx);
 				goto begin;
 			}
@@ -147,9 +353,7 @@ static bool queue_pop(MTY_Queue *ctx, int32_t timeout, bool last, void **buffer,
 		return true;
 
 	} else if (timeout != 0) {
-		// Because of the lock free check, this may already be signaled when
-		// there is no data. Worst case the loop spins one extra time
-		if (MTY_WaitableWait(ctx->pop_sync, timeout))
+		if (queue_wait(ctx, timeout))
 			goto begin;
 	}
 
@@ -172,12 +376,15 @@ void MTY_QueuePop(MTY_Queue *ctx)
 
 	ctx->pop_pos = queue_next_pos(ctx, ctx->pop_pos);
 
-	MTY_Atomic32Set(&ctx->slots[lock_pos].state, QUEUE_EMPTY);
+	if (ctx->ring)
+		MTY_Atomic64SetEx(&ctx->ring_tail, ctx->slots[lock_pos].end, MTY_MEMORY_ORDER_RELEASE);
+
+	MTY_Atomic32SetEx(&ctx->slots[lock_pos].state, QUEUE_EMPTY, MTY_MEMORY_ORDER_RELEASE);
 }
 
 bool MTY_QueuePushPtr(MTY_Queue *ctx, void *opaque, size_t size)
 {
-	void *buffer = MTY_QueueGetInputBuffer(ctx);
+	void *buffer = queue_reserve(ctx, sizeof(void *));
 
 	if (buffer) {
 		memcpy(buffer, &opaque, sizeof(void *));
@@ -203,6 +410,98 @@ bool MTY_QueuePopPtr(MTY_Queue *ctx, int32_t timeout, void **opaque, size_t *siz
 	return false;
 }
 
+static uint32_t queue_push_many(MTY_Queue *ctx, const void * const *items, const size_t *sizes,
+	uint32_t count, bool ptr)
+{
+	uint32_t n = 0;
+
+	queue_push_lock(ctx);
+
+	// Every slot is published before the single check of `waiting`, the consumer's
+	// recheck looks at the first of them
+	for (; n < count; n++) {
+		size_t size = sizes ? sizes[n] : 0;
+
+		// Empty and oversized items can never be pushed, so they end the batch instead
+		// of being skipped, keeping `n` the index of the first item not pushed
+		if (!ptr && (size == 0 || size > queue_max_size(ctx)))
+			break;
+
+		void *buffer = queue_reserve_locked(ctx, ptr ? sizeof(void *) : size);
+
+		if (!buffer)
+			break;
+
+		memcpy(buffer, ptr ? (const void *) &items[n] : items[n], ptr ? sizeof(void *) : size);
+		queue_commit(ctx, size, ptr);
+	}
+
+	if (n > 0)
+		queue_wake(ctx);
+
+	queue_push_unlock(ctx);
+
+	return n;
+}
+
+uint32_t MTY_QueuePushMany(MTY_Queue *ctx, const void * const *items, const size_t *sizes,
+	uint32_t count)
+{
+	return queue_push_many(ctx, items, sizes, count, false);
+}
+
+uint32_t MTY_QueuePushPtrMany(MTY_Queue *ctx, void * const *opaque, const size_t *sizes,
+	uint32_t count)
+{
+	return queue_push_many(ctx, (const void * const *) opaque, sizes, count, true);
+}
+
+uint32_t MTY_QueueGetOutputBuffers(MTY_Queue *ctx, int32_t timeout, void **buffers,
+	size_t *sizes, uint32_t max)
+{
+	if (max == 0 || !queue_pop(ctx, timeout, false, &buffers[0], sizes ? &sizes[0] : NULL))
+		return 0;
+
+	uint32_t n = 1;
+
+	if (max > ctx->len)
+		max = ctx->len;
+
+	for (uint32_t pos = queue_next_pos(ctx, ctx->pop_pos); n < max; pos = queue_next_pos(ctx, pos), n++) {
+		struct queue_slot *slot = &ctx->slots[pos];
+
+		if (MTY_Atomic32GetEx(&slot->state, MTY_MEMORY_ORDER_ACQUIRE) != QUEUE_FULL)
+			break;
+
+		buffers[n] = slot->data;
+
+		if (sizes)
+			sizes[n] = slot->size;
+	}
+
+	return n;
+}
+
+void MTY_QueuePopMany(MTY_Queue *ctx, uint32_t count)
+{
+	for (uint32_t x = 0; x < count; x++)
+		MTY_QueuePop(ctx);
+}
+
+uint32_t MTY_QueuePopPtrMany(MTY_Queue *ctx, int32_t timeout, void **opaque, size_t *sizes,
+	uint32_t max)
+{
+	// The buffers are read in place, then `opaque` is overwritten with their contents
+	uint32_t n = MTY_QueueGetOutputBuffers(ctx, timeout, opaque, sizes, max);
+
+	for (uint32_t x = 0; x < n; x++)
+		memcpy(&opaque[x], opaque[x], sizeof(void *));
+
+	MTY_QueuePopMany(ctx, n);
+
+	return n;
+}
+
 void MTY_QueueFlush(MTY_Queue *ctx, MTY_FreeFunc freeFunc)
 {
 	for (void *data = NULL; queue_pop(ctx, 0, false, (void **) &data, NULL);) {
@@ -217,3 +516,325 @@ void MTY_QueueFlush(MTY_Queue *ctx, MTY_FreeFunc freeFunc)
 		MTY_QueuePop(ctx);
 	}
 }
+
+
+// Concurrent
+
+// Bounded multi-producer multi-consumer ring, see "Bounded MPMC queue" (Vyukov).
+// Each slot's sequence number says whose turn it is: a producer at position `pos`
+// may write the slot when seq == pos, a consumer may read it when seq == pos + 1.
+// Producers and consumers each claim positions with a CAS on their own counter.
+
+// Blocking is layered on top with a mutex and two condition variables that are
+// only touched when a thread is actually waiting. Sequence numbers are published
+// and waiter counts read with sequentially consistent accesses, mirroring the
+// waiter's increment then recheck, so a wakeup can not be lost. Each sleeping
+// waiter is signaled at most once until it runs again, so a burst of pushes does
+// not turn into a burst of wakeup syscalls.
+
+struct cqueue_slot {
+	MTY_Atomic32 seq;
+};
+
+struct MTY_ConcurrentQueue {
+	uint32_t mask;
+	size_t item_size;
+	struct cqueue_slot *slots;
+	uint8_t *items;
+
+	MTY_Mutex *mutex;
+	MTY_Cond *not_empty;
+	MTY_Cond *not_full;
+
+	uint8_t pad0[QUEUE_CACHE_LINE];
+	MTY_Atomic32 push_pos;
+	MTY_Atomic32 push_waiters;
+	uint32_t push_signals;
+
+	uint8_t pad1[QUEUE_CACHE_LINE];
+	MTY_Atomic32 pop_pos;
+	MTY_Atomic32 pop_waiters;
+	uint32_t pop_signals;
+
+	uint8_t pad2[QUEUE_CACHE_LINE];
+};
+
+MTY_ConcurrentQueue *MTY_ConcurrentQueueCreate(uint32_t len, size_t itemSize)
+{
+	MTY_ConcurrentQueue *ctx = MTY_Alloc(1, sizeof(MTY_ConcurrentQueue));
+
+	uint32_t num_slots = 2;
+
+	while (num_slots < len && num_slots < 0x40000000)
+		num_slots *= 2;
+
+	ctx->mask = num_slots - 1;
+	ctx->item_size = itemSize > 0 ? itemSize : sizeof(void *);
+	ctx->slots = MTY_Alloc(num_slots, sizeof(struct cqueue_slot));
+	ctx->items = MTY_AllocUninit(num_slots, ctx->item_size);
+
+	for (uint32_t x = 0; x < num_slots; x++)
+		MTY_Atomic32Set(&ctx->slots[x].seq, x);
+
+	ctx->mutex = MTY_MutexCreate();
+	ctx->not_empty = MTY_CondCreate();
+	ctx->not_full = MTY_CondCreate();
+
+	return ctx;
+}
+
+void MTY_ConcurrentQueueDestroy(MTY_ConcurrentQueue **queue)
+{
+	if (!queue || !*queue)
+		return;
+
+	MTY_ConcurrentQueue *ctx = *queue;
+
+	MTY_CondDestroy(&ctx->not_full);
+	MTY_CondDestroy(&ctx->not_empty);
+	MTY_MutexDestroy(&ctx->mutex);
+
+	MTY_Free(ctx->items);
+	MTY_Free(ctx->slots);
+
+	MTY_Free(ctx);
+	*queue = NULL;
+}
+
+uint32_t MTY_ConcurrentQueueGetLength(MTY_ConcurrentQueue *ctx)
+{
+	uint32_t push_pos = MTY_Atomic32GetEx(&ctx->push_pos, MTY_MEMORY_ORDER_RELAXED);
+	uint32_t pop_pos = MTY_Atomic32GetEx(&ctx->pop_pos, MTY_MEMORY_ORDER_RELAXED);
+	int32_t len = (int32_t) (push_pos - pop_pos);
+
+	return len < 0 ? 0 : len > (int32_t) ctx->mask + 1 ? ctx->mask + 1 : (uint32_t) len;
+}
+
+static bool cqueue_claim(MTY_ConcurrentQueue *ctx, MTY_Atomic32 *counter, uint32_t offset, uint32_t *index)
+{
+	// Positions wrap around, so compare them with unsigned math
+	uint32_t pos = MTY_Atomic32GetEx(counter, MTY_MEMORY_ORDER_RELAXED);
+
+	while (true) {
+		// Sequentially consistent so that the recheck in cqueue_wait is ordered after
+		// the waiter count increment, this is a plain load on common hardware
+		uint32_t seq = MTY_Atomic32GetEx(&ctx->slots[pos & ctx->mask].seq, MTY_MEMORY_ORDER_SEQ_CST);
+		int32_t diff = (int32_t) (seq - (pos + offset));
+
+		if (diff == 0) {
+			if (MTY_Atomic32CASEx(counter, pos, pos + 1, MTY_MEMORY_ORDER_RELAXED)) {
+				*index = pos;
+				return true;
+			}
+
+		} else if (diff < 0) {
+			// Full for producers, empty for consumers
+			return false;
+		}
+
+		pos = MTY_Atomic32GetEx(counter, MTY_MEMORY_ORDER_RELAXED);
+	}
+}
+
+static bool cqueue_try_push(MTY_ConcurrentQueue *ctx, const void *item)
+{
+	uint32_t pos = 0;
+
+	if (!cqueue_claim(ctx, &ctx->push_pos, 0, &pos))
+		return false;
+
+	memcpy(ctx->items + (pos & ctx->mask) * ctx->item_size, item, ctx->item_size);
+	MTY_Atomic32SetEx(&ctx->slots[pos & ctx->mask].seq, pos + 1, MTY_MEMORY_ORDER_SEQ_CST);
+
+	return true;
+}
+
+static bool cqueue_try_pop(MTY_ConcurrentQueue *ctx, void *item)
+{
+	uint32_t pos = 0;
+
+	if (!cqueue_claim(ctx, &ctx->pop_pos, 1, &pos))
+		return false;
+
+	memcpy(item, ctx->items + (pos & ctx->mask) * ctx->item_size, ctx->item_size);
+	MTY_Atomic32SetEx(&ctx->slots[pos & ctx->mask].seq, pos + ctx->mask + 1, MTY_MEMORY_ORDER_SEQ_CST);
+
+	return true;
+}
+
+static void cqueue_wake(MTY_ConcurrentQueue *ctx, bool push)
+{
+	// Wake threads waiting on the opposite operation
+	MTY_Atomic32 *waiters = push ? &ctx->pop_waiters : &ctx->push_waiters;
+	uint32_t *signals = push ? &ctx->pop_signals : &ctx->push_signals;
+	MTY_Cond *cond = push ? ctx->not_empty : ctx->not_full;
+
+	if (MTY_Atomic32GetEx(waiters, MTY_MEMORY_ORDER_SEQ_CST) > 0) {
+		MTY_MutexLock(ctx->mutex);
+
+		if (*signals < (uint32_t) MTY_Atomic32GetEx(waiters, MTY_MEMORY_ORDER_RELAXED)) {
+			MTY_CondSignal(cond);
+			(*signals)++;
+		}
+
+		MTY_MutexUnlock(ctx->mutex);
+	}
+}
+
+static bool cqueue_wait(MTY_ConcurrentQueue *ctx, bool push, void *item, int32_t timeout)
+{
+	MTY_Atomic32 *waiters = push ? &ctx->push_waiters : &ctx->pop_waiters;
+	uint32_t *signals = push ? &ctx->push_signals : &ctx->pop_signals;
+	MTY_Cond *cond = push ? ctx->not_full : ctx->not_empty;
+
+	MTY_Time start = timeout > 0 ? MTY_GetTime() : 0;
+	bool r = false;
+
+	MTY_MutexLock(ctx->mutex);
+	MTY_Atomic32AddEx(waiters, 1, MTY_MEMORY_ORDER_SEQ_CST);
+
+	while (!(r = push ? cqueue_try_push(ctx, item) : cqueue_try_pop(ctx, item))) {
+		int32_t remaining = timeout;
+
+		if (timeout > 0) {
+			remaining = timeout - (int32_t) MTY_TimeDiff(start, MTY_GetTime());
+
+			if (remaining <= 0)
+				break;
+		}
+
+		MTY_CondWait(cond, ctx->mutex, remaining);
+
+		if (*signals > 0)
+			(*signals)--;
+	}
+
+	MTY_Atomic32AddEx(waiters, -1, MTY_MEMORY_ORDER_RELAXED);
+	MTY_MutexUnlock(ctx->mutex);
+
+	return r;
+}
+
+bool MTY_ConcurrentQueuePush(MTY_ConcurrentQueue *ctx, const void *item, int32_t timeout)
+{
+	bool r = cqueue_try_push(ctx, item);
+
+	if (!r && timeout != 0)
+		r = cqueue_wait(ctx, true, (void *) item, timeout);
+
+	if (r)
+		cqueue_wake(ctx, true);
+
+	return r;
+}
+
+bool MTY_ConcurrentQueuePop(MTY_ConcurrentQueue *ctx, void *item, int32_t timeout)
+{
+	bool r = cqueue_try_pop(ctx, item);
+
+	if (!r && timeout != 0)
+		r = cqueue_wait(ctx, false, item, timeout);
+
+	if (r)
+		cqueue_wake(ctx, false);
+
+	return r;
+}
+
+
+// Triple buffer
+
+// Three buffers rotate between the producer's back buffer, the shared middle buffer
+// and the consumer's front buffer. Only the middle index is shared, packed with a
+// flag saying it holds a frame the consumer has not seen yet. Each side swaps its
+// own buffer with the middle one, so neither ever waits on or copies from the other.
+
+#define TRIPLE_INDEX 0x3
+#define TRIPLE_FRESH 0x4
+
+struct MTY_TripleBuffer {
+	void *bufs[3];
+	size_t sizes[3];
+
+	uint8_t pad0[QUEUE_CACHE_LINE];
+	MTY_Atomic32 middle;
+
+	uint8_t pad1[QUEUE_CACHE_LINE];
+	uint32_t back;
+
+	uint8_t pad2[QUEUE_CACHE_LINE];
+	uint32_t front;
+	bool has_front;
+
+	uint8_t pad3[QUEUE_CACHE_LINE];
+};
+
+MTY_TripleBuffer *MTY_TripleBufferCreate(size_t bufSize)
+{
+	MTY_TripleBuffer *ctx = MTY_Alloc(1, sizeof(MTY_TripleBuffer));
+
+	for (uint8_t x = 0; x < 3; x++)
+		ctx->bufs[x] = MTY_AllocUninit(bufSize > 0 ? bufSize : 1, 1);
+
+	ctx->back = 0;
+	ctx->front = 2;
+	MTY_Atomic32Set(&ctx->middle, 1);
+
+	return ctx;
+}
+
+void MTY_TripleBufferDestroy(MTY_TripleBuffer **tb)
+{
+	if (!tb || !*tb)
+		return;
+
+	MTY_TripleBuffer *ctx = *tb;
+
+	for (uint8_t x = 0; x < 3; x++)
+		MTY_Free(ctx->bufs[x]);
+
+	MTY_Free(ctx);
+	*tb = NULL;
+}
+
+static uint32_t triple_swap(MTY_TripleBuffer *ctx, int32_t value)
+{
+	int32_t middle = MTY_Atomic32GetEx(&ctx->middle, MTY_MEMORY_ORDER_RELAXED);
+
+	while (!MTY_Atomic32CASEx(&ctx->middle, middle, value, MTY_MEMORY_ORDER_ACQ_REL))
+		middle = MTY_Atomic32GetEx(&ctx->middle, MTY_MEMORY_ORDER_RELAXED);
+
+	return (uint32_t) middle & TRIPLE_INDEX;
+}
+
+void *MTY_TripleBufferGetInputBuffer(MTY_TripleBuffer *ctx)
+{
+	return ctx->bufs[ctx->back];
+}
+
+void MTY_TripleBufferPush(MTY_TripleBuffer *ctx, size_t size)
+{
+	ctx->sizes[ctx->back] = size;
+
+	// Publishes the back buffer, and takes back whichever buffer was in the middle,
+	// possibly an older frame the consumer never looked at
+	ctx->back = triple_swap(ctx, (int32_t) (ctx->back | TRIPLE_FRESH));
+}
+
+bool MTY_TripleBufferGetOutputBuffer(MTY_TripleBuffer *ctx, void **buffer, size_t *size)
+{
+	bool fresh = MTY_Atomic32GetEx(&ctx->middle, MTY_MEMORY_ORDER_RELAXED) & TRIPLE_FRESH;
+
+	// Only the consumer clears the flag, so the middle buffer stays fresh until swapped
+	if (fresh) {
+		ctx->front = triple_swap(ctx, (int32_t) ctx->front);
+		ctx->has_front = true;
+	}
+
+	*buffer = ctx->has_front ? ctx->bufs[ctx->front] : NULL;
+
+	if (size)
+		*size = ctx->has_front ? ctx->sizes[ctx->front] : 0;
+
+	return fresh;
+}
@@ -24,7 +24,11 @@ struct MTY_Resampler {
 
 MTY_Resampler *MTY_ResamplerCreate(void)
 {
-	return MTY_Alloc(1, sizeof(MTY_Resampler));
+	// Only the leading history needs to be zeroed, see MTY_Resample
+	MTY_Resampler *ctx = MTY_AllocUninit(1, sizeof(MTY_Resampler));
+	MTY_ResamplerReset(ctx);
+
+	return ctx;
 }
 
 void MTY_ResamplerDestroy(MTY_Resampler **resampler)
@@ -91,8 +95,10 @@ const int16_t *MTY_Resample(MTY_Resampler *ctx, float ratio, const int16_t *in,
 	size_t half_len = 2 * (lrint(count) + 1);
 	size_t pos = half_len;
 
-	if (ctx->len == 0)
+	if (ctx->len == 0) {
+		memset(ctx->buffer, 0, half_len * sizeof(int16_t));
 		ctx->len = half_len;
+	}
 
 	memcpy(ctx->buffer + ctx->len, in, inFrames * 2 * sizeof(int16_t));
 	ctx->len += inFrames * 2;
@@ -132,5 +138,7 @@ const int16_t *MTY_Resample(MTY_Resampler *ctx, float ratio, const int16_t *in,
 
 void MTY_ResamplerReset(MTY_Resampler *ctx)
 {
-	memset(ctx, 0, sizeof(MTY_Resampler));
+	ctx->len = 0;
+	ctx->index = 0;
+	ctx->ratio = 0;
 }
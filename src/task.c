@@ -0,0 +1,356 @@
+// This Source Code Form is subject to the terms of the MIT License.
+// If a copy of the MIT License was not distributed with this file,
+// You can obtain one at https://spdx.org/licenses/MIT.html.
+
+#include "matoya.h"
+
+#include "tlocal.h"
+
+#define TASK_DEQUE_MIN 64
+
+struct MTY_TaskGroup {
+	MTY_Atomic32 pending;
+};
+
+struct task {
+	MTY_AnonFunc func;
+	MTY_ParallelForFunc pfunc;
+	void *opaque;
+	int64_t begin;
+	int64_t end;
+	int64_t grain;
+	MTY_TaskGroup *group;
+};
+
+struct task_deque {
+	MTY_Mutex *mutex;
+	struct task *tasks;
+	uint32_t len;
+	uint32_t top;
+	uint32_t bottom;
+};
+
+struct task_worker {
+	struct task_sched *sched;
+	uint32_t index;
+	MTY_Thread *thread;
+};
+
+struct task_sched {
+	uint32_t num_workers;
+	struct task_worker *workers;
+
+	// One deque per worker plus a shared deque for threads outside the scheduler
+	struct task_deque *deques;
+
+	MTY_Mutex *mutex;
+	MTY_Cond *work_cond;
+	MTY_Cond *done_cond;
+	MTY_Atomic32 queued;
+	MTY_Atomic32 sleeping;
+	MTY_Atomic32 waiting;
+};
+
+static MTY_Once TASK_ONCE;
+static struct task_sched *TASK_SCHED;
+
+// 1-based index of the worker running on this thread, 0 if not a worker
+static TLOCAL uint32_t TASK_WORKER;
+
+
+// Deque
+
+static void task_deque_create(struct task_deque *dq)
+{
+	dq->mutex = MTY_MutexCreate();
+	dq->len = TASK_DEQUE_MIN;
+	dq->tasks = MTY_Alloc(dq->len, sizeof(struct task));
+}
+
+static void task_deque_grow(struct task_deque *dq)
+{
+	uint32_t len = dq->len * 2;
+	struct task *tasks = MTY_Alloc(len, sizeof(struct task));
+
+	for (uint32_t x = dq->top; x != dq->bottom; x++)
+		tasks[x & (len - 1)] = dq->tasks[x & (dq->len - 1)];
+
+	MTY_Free(dq->tasks);
+	dq->tasks = tasks;
+	dq->len = len;
+}
+
+static void task_deque_push(struct task_deque *dq, const struct task *t)
+{
+	MTY_MutexLock(dq->mutex);
+
+	if (dq->bottom - dq->top == dq->len)
+		task_deque_grow(dq);
+
+	dq->tasks[dq->bottom & (dq->len - 1)] = *t;
+	dq->bottom++;
+
+	MTY_MutexUnlock(dq->mutex);
+}
+
+static bool task_deque_pop(struct task_deque *dq, struct task *t)
+{
+	bool r = false;
+
+	MTY_MutexLock(dq->mutex);
+
+	if (dq->bottom != dq->top) {
+		dq->bottom--;
+		*t = dq->tasks[dq->bottom & (dq->len - 1)];
+		r = true;
+	}
+
+	MTY_MutexUnlock(dq->mutex);
+
+	return r;
+}
+
+static bool task_deque_steal(struct task_deque *dq, struct task *t)
+{
+	// Thieves take the oldest (and usually largest) task from the opposite end
+	if (!MTY_MutexTryLock(dq->mutex))
+		return false;
+
+	bool r = false;
+
+	if (dq->bottom != dq->top) {
+		*t = dq->tasks[dq->top & (dq->len - 1)];
+		dq->top++;
+		r = true;
+	}
+
+	MTY_MutexUnlock(dq->mutex);
+
+	return r;
+}
+
+
+// Scheduler
+
+static uint32_t task_self(struct task_sched *s)
+{
+	return TASK_WORKER > 0 ? TASK_WORKER - 1 : s->num_workers;
+}
+
+static bool task_find(struct task_sched *s, uint32_t self, struct task *t)
+{
+	bool r = task_deque_pop(&s->deques[self], t);
+
+	for (uint32_t x = 1; x <= s->num_workers && !r; x++)
+		r = task_deque_steal(&s->deques[(self + x) % (s->num_workers + 1)], t);
+
+	if (r)
+		MTY_Atomic32Add(&s->queued, -1);
+
+	return r;
+}
+
+static void task_push(struct task_sched *s, const struct task *t)
+{
+	MTY_Atomic32Add(&t->group->pending, 1);
+
+	task_deque_push(&s->deques[task_self(s)], t);
+	MTY_Atomic32Add(&s->queued, 1);
+
+	// Threads waiting on a group steal work too
+	bool sleeping = MTY_Atomic32Get(&s->sleeping) > 0;
+	bool waiting = MTY_Atomic32Get(&s->waiting) > 0;
+
+	if (sleeping || waiting) {
+		MTY_MutexLock(s->mutex);
+
+		if (sleeping)
+			MTY_CondSignal(s->work_cond);
+
+		if (waiting)
+			MTY_CondSignalAll(s->done_cond);
+
+		MTY_MutexUnlock(s->mutex);
+	}
+}
+
+static void task_run(struct task_sched *s, struct task *t)
+{
+	if (t->pfunc) {
+		// Keep the lower half and leave the upper half for thieves until the range
+		// is within the grain size. The width of a range can exceed INT64_MAX
+		for (uint64_t w = (uint64_t) t->end - (uint64_t) t->begin; w > (uint64_t) t->grain;
+			w = (uint64_t) t->end - (uint64_t) t->begin)
+		{
+			struct task upper = *t;
+			upper.begin = (int64_t) ((uint64_t) t->begin + w / 2);
+			t->end = upper.begin;
+
+			task_push(s, &upper);
+		}
+
+		t->pfunc(t->begin, t->end, t->opaque);
+
+	} else {
+		t->func(t->opaque);
+	}
+
+	// The group may be freed by its waiter as soon as pending reaches zero
+	if (MTY_Atomic32Add(&t->group->pending, -1) == 0) {
+		MTY_MutexLock(s->mutex);
+		MTY_CondSignalAll(s->done_cond);
+		MTY_MutexUnlock(s->mutex);
+	}
+}
+
+static void *task_worker_func(void *opaque)
+{
+	struct task_worker *w = opaque;
+	struct task_sched *s = w->sched;
+
+	TASK_WORKER = w->index + 1;
+	MTY_ThreadSetName(NULL, "MTY_TaskGroup");
+
+	while (true) {
+		struct task t;
+
+		if (task_find(s, w->index, &t)) {
+			task_run(s, &t);
+			continue;
+		}
+
+		MTY_MutexLock(s->mutex);
+		MTY_Atomic32Add(&s->sleeping, 1);
+
+		while (MTY_Atomic32Get(&s->queued) <= 0)
+			MTY_CondWait(s->work_cond, s->mutex, -1);
+
+		MTY_Atomic32Add(&s->sleeping, -1);
+		MTY_MutexUnlock(s->mutex);
+	}
+
+	return NULL;
+}
+
+static void task_sched_create(void *opaque)
+{
+	struct task_sched *s = MTY_Alloc(1, sizeof(struct task_sched));
+
+	// The thread waiting on a group executes tasks as well
+	uint32_t num_cpu = MTY_GetNumProcessors();
+	s->num_workers = num_cpu > 1 ? num_cpu - 1 : 1;
+
+	s->mutex = MTY_MutexCreate();
+	s->work_cond = MTY_CondCreate();
+	s->done_cond = MTY_CondCreate();
+
+	s->deques = MTY_Alloc(s->num_workers + 1, sizeof(struct task_deque));
+
+	for (uint32_t x = 0; x < s->num_workers + 1; x++)
+		task_deque_create(&s->deques[x]);
+
+	s->workers = MTY_Alloc(s->num_workers, sizeof(struct task_worker));
+
+	for (uint32_t x = 0; x < s->num_workers; x++) {
+		s->workers[x].sched = s;
+		s->workers[x].index = x;
+		s->workers[x].thread = MTY_ThreadCreate(task_worker_func, &s->workers[x]);
+	}
+
+	TASK_SCHED = s;
+}
+
+static struct task_sched *task_sched(void)
+{
+	MTY_CallOnce(&TASK_ONCE, task_sched_create, NULL);
+
+	return TASK_SCHED;
+}
+
+static void task_wait(struct task_sched *s, MTY_TaskGroup *group)
+{
+	uint32_t self = task_self(s);
+
+	while (MTY_Atomic32Get(&group->pending) > 0) {
+		struct task t;
+
+		// Help out instead of blocking, which also keeps nested waits on
+		// worker threads from deadlocking the scheduler
+		if (task_find(s, self, &t)) {
+			task_run(s, &t);
+			continue;
+		}
+
+		// task_push wakes waiters along with workers, so sleep until the group is
+		// done or there is work to steal
+		MTY_MutexLock(s->mutex);
+		MTY_Atomic32Add(&s->waiting, 1);
+
+		while (MTY_Atomic32Get(&group->pending) > 0 && MTY_Atomic32Get(&s->queued) <= 0)
+			MTY_CondWait(s->done_cond, s->mutex, -1);
+
+		MTY_Atomic32Add(&s->waiting, -1);
+		MTY_MutexUnlock(s->mutex);
+	}
+}
+
+
+// Public
+
+MTY_TaskGroup *MTY_TaskGroupCreate(void)
+{
+	task_sched();
+
+	return MTY_Alloc(1, sizeof(MTY_TaskGroup));
+}
+
+void MTY_TaskGroupDestroy(MTY_TaskGroup **group)
+{
+	if (!group || !*group)
+		return;
+
+	MTY_TaskGroup *ctx = *group;
+
+	MTY_TaskGroupWait(ctx);
+
+	MTY_Free(ctx);
+	*group = NULL;
+}
+
+void MTY_TaskGroupRun(MTY_TaskGroup *ctx, MTY_AnonFunc func, void *opaque)
+{
+	struct task t = {0};
+	t.func = func;
+	t.opaque = opaque;
+	t.group = ctx;
+
+	task_push(task_sched(), &t);
+}
+
+void MTY_TaskGroupWait(MTY_TaskGroup *ctx)
+{
+	task_wait(task_sched(), ctx);
+}
+
+void MTY_ParallelFor(int64_t begin, int64_t end, int64_t grain, MTY_ParallelForFunc func,
+	void *opaque)
+{
+	if (end <= begin)
+		return;
+
+	struct task_sched *s = task_sched();
+
+	MTY_TaskGroup group = {0};
+	MTY_Atomic32Set(&group.pending, 1);
+
+	struct task t = {0};
+	t.pfunc = func;
+	t.opaque = opaque;
+	t.begin = begin;
+	t.end = end;
+	t.grain = grain > 0 ? grain : 1;
+	t.group = &group;
+
+	task_run(s, &t);
+	task_wait(s, &group);
+}
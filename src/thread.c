@@ -11,51 +11,194 @@
 #include "rwlock.h"
 #include "tlocal.h"
 
+#if defined(__linux__)
+	#include <unistd.h>
+	#include <poll.h>
+	#include <sys/eventfd.h>
+
+	#include "futexutil.h"
+#endif
+
 
 // RWLock
 
-static TLOCAL struct thread_rwlock {
+// Only locks currently held by a thread are tracked, so this limits how many
+// different rwlocks a single thread can hold at once, not how many can exist
+#define RWLOCK_HELD_MAX 32
+
+// Visible readers table shared by all reader biased locks, see "BRAVO: Biased
+// Locking for Reader-Writer Locks" (Dice & Kogan, 2019)
+#define RWLOCK_BIAS_SLOTS   4096
+#define RWLOCK_BIAS_INHIBIT 9
+
+struct thread_rwlock {
+	MTY_RWLock *rwlock;
+	uint32_t slot;
 	uint16_t taken;
 	bool read;
 	bool write;
-} RWLOCK_STATE[UINT8_MAX];
+};
+
+static TLOCAL struct thread_rwlock RWLOCK_HELD[RWLOCK_HELD_MAX];
+static TLOCAL uint32_t RWLOCK_HELD_LEN;
+
+static MTY_Atomic64 RWLOCK_BIAS_TABLE[RWLOCK_BIAS_SLOTS];
 
 struct MTY_RWLock {
 	mty_rwlock rwlock;
-	MTY_Atomic32 yield;
-	uint8_t index;
-};
+	MTY_Atomic32 writers;
+	MTY_Mutex *gate;
+	MTY_Cond *gate_cond;
 
-static MTY_Atomic32 RWLOCK_INIT[UINT8_MAX];
+	bool biased;
+	MTY_Atomic32 rbias;
+	MTY_Atomic64 inhibit;
+};
 
-static uint8_t thread_rwlock_index(void)
+static struct thread_rwlock *thread_rwlock_get(MTY_RWLock *ctx)
 {
-	for (uint8_t x = 0; x < UINT8_MAX; x++)
-		if (MTY_Atomic32CAS(&RWLOCK_INIT[x], 0, 1))
-			return x;
+	for (uint32_t x = RWLOCK_HELD_LEN; x > 0; x--)
+		if (RWLOCK_HELD[x - 1].rwlock == ctx)
+			return &RWLOCK_HELD[x - 1];
 
-	MTY_LogFatal("Could not find a free rwlock slot, maximum is %u", UINT8_MAX);
+	if (RWLOCK_HELD_LEN == RWLOCK_HELD_MAX)
+		MTY_LogFatal("A thread can hold at most %u rwlocks at once", RWLOCK_HELD_MAX);
 
-	return 0;
+	struct thread_rwlock *rw = &RWLOCK_HELD[RWLOCK_HELD_LEN++];
+	memset(rw, 0, sizeof(struct thread_rwlock));
+	rw->rwlock = ctx;
+
+	return rw;
+}
+
+static void thread_rwlock_release(struct thread_rwlock *rw)
+{
+	if (rw->taken == 0)
+		*rw = RWLOCK_HELD[--RWLOCK_HELD_LEN];
 }
 
 static void thread_rwlock_yield(MTY_RWLock *ctx)
 {
-	// Ensure that readers will yield to writers in a tight loop
-	while (MTY_Atomic32Get(&ctx->yield) > 0)
-		MTY_Sleep(0);
+	// New readers park behind waiting writers so they can't be starved
+	if (MTY_Atomic32Get(&ctx->writers) > 0) {
+		MTY_MutexLock(ctx->gate);
+
+		while (MTY_Atomic32Get(&ctx->writers) > 0)
+			MTY_CondWait(ctx->gate_cond, ctx->gate, -1);
+
+		MTY_MutexUnlock(ctx->gate);
+	}
 }
 
-MTY_RWLock *MTY_RWLockCreate(void)
+static uint32_t thread_rwlock_bias_slot(MTY_RWLock *ctx)
+{
+	// The address of a thread local is unique per thread
+	uint64_t h = (uint64_t) (uintptr_t) &RWLOCK_HELD_LEN ^ (uint64_t) (uintptr_t) ctx;
+
+	return (uint32_t) ((h * 0x9E3779B97F4A7C15) >> 52) % RWLOCK_BIAS_SLOTS;
+}
+
+static bool thread_rwlock_bias_reader(MTY_RWLock *ctx, struct thread_rwlock *rw)
+{
+	if (!MTY_Atomic32Get(&ctx->rbias))
+		return false;
+
+	uint32_t slot = thread_rwlock_bias_slot(ctx);
+	MTY_Atomic64 *entry = &RWLOCK_BIAS_TABLE[slot];
+
+	if (!MTY_Atomic64CAS(entry, 0, (int64_t) (uintptr_t) ctx))
+		return false;
+
+	// A writer may have revoked the bias before it could see this slot
+	if (!MTY_Atomic32Get(&ctx->rbias)) {
+		MTY_Atomic64Set(entry, 0);
+		return false;
+	}
+
+	rw->slot = slot + 1;
+
+	return true;
+}
+
+static void thread_rwlock_slow_reader(MTY_RWLock *ctx)
+{
+	thread_rwlock_yield(ctx);
+	mty_rwlock_reader(&ctx->rwlock);
+
+	// Holding the read lock excludes writers, so the bias can be safely restored
+	if (ctx->biased && !MTY_Atomic32Get(&ctx->rbias) &&
+		MTY_GetTime() >= MTY_Atomic64Get(&ctx->inhibit))
+		MTY_Atomic32Set(&ctx->rbias, 1);
+}
+
+static void thread_rwlock_unlock_reader(MTY_RWLock *ctx, struct thread_rwlock *rw)
+{
+	if (rw->slot > 0) {
+		MTY_Atomic64Set(&RWLOCK_BIAS_TABLE[rw->slot - 1], 0);
+		rw->slot = 0;
+
+	} else {
+		mty_rwlock_unlock_reader(&ctx->rwlock);
+	}
+}
+
+static void thread_rwlock_revoke(MTY_RWLock *ctx)
+{
+	MTY_Atomic32Set(&ctx->rbias, 0);
+
+	MTY_Time begin = MTY_GetTime();
+	int64_t val = (int64_t) (uintptr_t) ctx;
+
+	for (uint32_t x = 0; x < RWLOCK_BIAS_SLOTS; x++)
+		while (MTY_Atomic64Get(&RWLOCK_BIAS_TABLE[x]) == val)
+			MTY_Sleep(0);
+
+	// Keep the bias off for a multiple of the revocation cost so frequent
+	// writers don't keep paying for it
+	MTY_Time end = MTY_GetTime();
+	MTY_Atomic64Set(&ctx->inhibit, end + (end - begin) * RWLOCK_BIAS_INHIBIT);
+}
+
+static void thread_rwlock_writer(MTY_RWLock *ctx)
+{
+	MTY_Atomic32Add(&ctx->writers, 1);
+	mty_rwlock_writer(&ctx->rwlock);
+
+	if (MTY_Atomic32Add(&ctx->writers, -1) == 0) {
+		MTY_MutexLock(ctx->gate);
+		MTY_CondSignalAll(ctx->gate_cond);
+		MTY_MutexUnlock(ctx->gate);
+	}
+
+	if (ctx->biased && MTY_Atomic32Get(&ctx->rbias))
+		thread_rwlock_revoke(ctx);
+}
+
+static MTY_RWLock *thread_rwlock_create(bool biased)
 {
 	MTY_RWLock *ctx = MTY_Alloc(1, sizeof(MTY_RWLock));
-	ctx->index = thread_rwlock_index();
+	ctx->biased = biased;
 
 	mty_rwlock_create(&ctx->rwlock);
 
+	ctx->gate = MTY_MutexCreate();
+	ctx->gate_cond = MTY_CondCreate();
+
+	MTY_Atomic32Set(&ctx->rbias, biased ? 1 : 0);
+
 	return ctx;
 }
 
+MTY_RWLock *MTY_RWLockCreate(void)
+{
+	return thread_rwlock_create(false);
+}
+
+MTY_RWLock *MTY_RWLockCreateBiased(void)
+{
+	return thread_rwlock_create(true);
+}
+
 void MTY_RWLockDestroy(MTY_RWLock **rwlock)
 {
 	if (!rwlock || !*rwlock)
@@ -63,9 +206,9 @@ void MTY_RWLockDestroy(MTY_RWLock **rwlock)
 
 	MTY_RWLock *ctx = *rwlock;
 
+	MTY_CondDestroy(&ctx->gate_cond);
+	MTY_MutexDestroy(&ctx->gate);
 	mty_rwlock_destroy(&ctx->rwlock);
-	memset(&RWLOCK_STATE[ctx->index], 0, sizeof(struct thread_rwlock));
-	MTY_Atomic32Set(&RWLOCK_INIT[ctx->index], 0);
 
 	MTY_Free(ctx);
 	*rwlock = NULL;
@@ -73,29 +216,32 @@ void MTY_RWLockDestroy(MTY_RWLock **rwlock)
 
 bool MTY_RWTryLockReader(MTY_RWLock *ctx)
 {
-	struct thread_rwlock *rw = &RWLOCK_STATE[ctx->index];
+	struct thread_rwlock *rw = thread_rwlock_get(ctx);
 
 	bool r = true;
 
 	if (rw->taken == 0) {
-		thread_rwlock_yield(ctx);
-		r = mty_rwlock_try_reader(&ctx->rwlock);
-		rw->read = true;
+		r = thread_rwlock_bias_reader(ctx, rw) ||
+			(MTY_Atomic32Get(&ctx->writers) == 0 && mty_rwlock_try_reader(&ctx->rwlock));
+		rw->read = r;
 	}
 
 	if (r)
 		rw->taken++;
 
+	thread_rwlock_release(rw);
+
 	return r;
 }
 
 void MTY_RWLockReader(MTY_RWLock *ctx)
 {
-	struct thread_rwlock *rw = &RWLOCK_STATE[ctx->index];
+	struct thread_rwlock *rw = thread_rwlock_get(ctx);
 
 	if (rw->taken == 0) {
-		thread_rwlock_yield(ctx);
-		mty_rwlock_reader(&ctx->rwlock);
+		if (!thread_rwlock_bias_reader(ctx, rw))
+			thread_rwlock_slow_reader(ctx);
+
 		rw->read = true;
 	}
 
@@ -105,18 +251,16 @@ void MTY_RWLockReader(MTY_RWLock *ctx)
 void MTY_RWLockWriter(MTY_RWLock *ctx)
 {
 	bool relock = false;
-	struct thread_rwlock *rw = &RWLOCK_STATE[ctx->index];
+	struct thread_rwlock *rw = thread_rwlock_get(ctx);
 
 	if (rw->read) {
-		mty_rwlock_unlock_reader(&ctx->rwlock);
+		thread_rwlock_unlock_reader(ctx, rw);
 		rw->read = false;
 		relock = true;
 	}
 
 	if (rw->taken == 0 || relock) {
-		MTY_Atomic32Add(&ctx->yield, 1);
-		mty_rwlock_writer(&ctx->rwlock);
-		MTY_Atomic32Add(&ctx->yield, -1);
+		thread_rwlock_writer(ctx);
 		rw->write = true;
 	}
 
@@ -125,11 +269,11 @@ void MTY_RWLockWriter(MTY_RWLock *ctx)
 
 void MTY_RWLockUnlock(MTY_RWLock *ctx)
 {
-	struct thread_rwlock *rw = &RWLOCK_STATE[ctx->index];
+	struct thread_rwlock *rw = thread_rwlock_get(ctx);
 
 	if (--rw->taken == 0) {
 		if (rw->read) {
-			mty_rwlock_unlock_reader(&ctx->rwlock);
+			thread_rwlock_unlock_reader(ctx, rw);
 			rw->read = false;
 
 		} else if (rw->write) {
@@ -137,11 +281,179 @@ void MTY_RWLockUnlock(MTY_RWLock *ctx)
 			rw->write = false;
 		}
 	}
+
+	thread_rwlock_release(rw);
 }
 
 
 // Waitable
 
+#if defined(__linux__)
+
+// Bit 0 is the signal, the remaining bits count the number of waiting threads
+#define WAITABLE_SIGNAL 0x1
+#define WAITABLE_WAITER 0x2
+
+struct MTY_Waitable {
+	MTY_Atomic32 state;
+
+	// Pollable waitables keep their signal in an eventfd counter instead
+	int32_t fd;
+};
+
+MTY_Waitable *MTY_WaitableCreate(void)
+{
+	MTY_Waitable *ctx = MTY_Alloc(1, sizeof(struct MTY_Waitable));
+	ctx->fd = -1;
+
+	return ctx;
+}
+
+MTY_Waitable *MTY_WaitableCreatePollable(void)
+{
+	MTY_Waitable *ctx = MTY_WaitableCreate();
+
+	ctx->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (ctx->fd == -1)
+		MTY_LogFatal("'eventfd' failed with errno %d", errno);
+
+	return ctx;
+}
+
+void MTY_WaitableDestroy(MTY_Waitable **waitable)
+{
+	if (!waitable || !*waitable)
+		return;
+
+	MTY_Waitable *ctx = *waitable;
+
+	if (ctx->fd != -1)
+		close(ctx->fd);
+
+	MTY_Free(ctx);
+	*waitable = NULL;
+}
+
+int32_t MTY_WaitableGetFD(MTY_Waitable *ctx)
+{
+	return ctx->fd;
+}
+
+static bool waitable_fd_wait(MTY_Waitable *ctx, int32_t timeout)
+{
+	MTY_Time deadline = MTY_GetTime() + (MTY_Time) timeout * 1000;
+
+	while (true) {
+		// Reading resets the counter, so multiple signals collapse into one just
+		// like the futex version. EAGAIN means another thread consumed it first.
+		uint64_t val = 0;
+		if (read(ctx->fd, &val, sizeof(uint64_t)) == sizeof(uint64_t))
+			return true;
+
+		int32_t remaining = -1;
+
+		if (timeout >= 0) {
+			MTY_Time now = MTY_GetTime();
+			remaining = now < deadline ? (int32_t) ((deadline - now + 999) / 1000) : 0;
+		}
+
+		if (remaining == 0)
+			return false;
+
+		struct pollfd fd = {0};
+		fd.fd = ctx->fd;
+		fd.events = POLLIN;
+
+		int32_t e = poll(&fd, 1, remaining);
+
+		if (e == 0)
+			return false;
+
+		if (e < 0 && errno != EINTR)
+			MTY_LogFatal("'poll' failed with errno %d", errno);
+	}
+}
+
+static bool waitable_consume(MTY_Waitable *ctx, int32_t waiter)
+{
+	while (true) {
+		int32_t state = MTY_Atomic32Get(&ctx->state);
+
+		if (!(state & WAITABLE_SIGNAL))
+			return false;
+
+		if (MTY_Atomic32CAS(&ctx->state, state, (state & ~WAITABLE_SIGNAL) - waiter))
+			return true;
+	}
+}
+
+bool MTY_WaitableWait(MTY_Waitable *ctx, int32_t timeout)
+{
+	if (ctx->fd != -1)
+		return waitable_fd_wait(ctx, timeout);
+
+	if (waitable_consume(ctx, 0))
+		return true;
+
+	if (timeout == 0)
+		return false;
+
+	MTY_Time deadline = MTY_GetTime() + (MTY_Time) timeout * 1000;
+	MTY_Atomic32Add(&ctx->state, WAITABLE_WAITER);
+
+	while (true) {
+		if (waitable_consume(ctx, WAITABLE_WAITER))
+			return true;
+
+		int32_t state = MTY_Atomic32Get(&ctx->state);
+		int32_t remaining = -1;
+
+		if (timeout > 0) {
+			MTY_Time now = MTY_GetTime();
+			remaining = now < deadline ? (int32_t) ((deadline - now + 999) / 1000) : 0;
+		}
+
+		if (remaining == 0 || (!(state & WAITABLE_SIGNAL) && !mty_futex_wait(&ctx->state.value, state, remaining))) {
+			// A signal may have arrived at the same time as the timeout
+			if (waitable_consume(ctx, WAITABLE_WAITER))
+				return true;
+
+			MTY_Atomic32Add(&ctx->state, -WAITABLE_WAITER);
+
+			return false;
+		}
+	}
+}
+
+void MTY_WaitableSignal(MTY_Waitable *ctx)
+{
+	if (ctx->fd != -1) {
+		// Only fails with EAGAIN if the counter would overflow, which is still signaled
+		uint64_t val = 1;
+		if (write(ctx->fd, &val, sizeof(uint64_t)) != sizeof(uint64_t) && errno != EAGAIN)
+			MTY_LogFatal("'write' to eventfd failed with errno %d", errno);
+
+		return;
+	}
+
+	while (true) {
+		int32_t state = MTY_Atomic32Get(&ctx->state);
+
+		if (state & WAITABLE_SIGNAL)
+			break;
+
+		if (MTY_Atomic32CAS(&ctx->state, state, state | WAITABLE_SIGNAL)) {
+			// Only make the syscall if another thread is waiting
+			if (state >= WAITABLE_WAITER)
+				mty_futex_wake(&ctx->state.value, 1);
+
+			break;
+		}
+	}
+}
+
+#else
+
 struct MTY_Waitable {
 	bool signal;
 	MTY_Mutex *mutex;
@@ -158,6 +470,11 @@ MTY_Waitable *MTY_WaitableCreate(void)
 	return ctx;
 }
 
+MTY_Waitable *MTY_WaitableCreatePollable(void)
+{
+	return MTY_WaitableCreate();
+}
+
 void MTY_WaitableDestroy(MTY_Waitable **waitable)
 {
 	if (!waitable || !*waitable)
@@ -199,38 +516,123 @@ void MTY_WaitableSignal(MTY_Waitable *ctx)
 	MTY_MutexUnlock(ctx->mutex);
 }
 
+int32_t MTY_WaitableGetFD(MTY_Waitable *ctx)
+{
+	return -1;
+}
+
+#endif
+
 
 // ThreadPool
 
+// Internal status set when a running task is detached
+#define THREAD_POOL_DETACHED 4
+
 struct thread_info {
-	MTY_Async status;
+	MTY_Atomic32 status;
+	MTY_Atomic32 next;
 	MTY_AnonFunc func;
 	MTY_AnonFunc detach;
 	void *opaque;
-	MTY_Thread *t;
-	MTY_Mutex *m;
 };
 
 struct MTY_ThreadPool {
 	uint32_t num;
 	struct thread_info *ti;
+
+	// Lock free stack of available indexes, the upper 32 bits are an ABA tag
+	MTY_Atomic64 free;
+
+	MTY_Mutex *mutex;
+	MTY_Cond *cond;
+	bool stop;
+
+	uint32_t *queue;
+	uint32_t queue_pos;
+	uint32_t queue_len;
+
+	MTY_Thread **threads;
+	uint32_t max_threads;
+	uint32_t num_threads;
+	uint32_t idle;
+	uint64_t affinity;
 };
 
-MTY_ThreadPool *MTY_ThreadPoolCreate(uint32_t maxThreads)
+static void thread_pool_push_free(MTY_ThreadPool *ctx, uint32_t index)
+{
+	while (true) {
+		int64_t head = MTY_Atomic64GetEx(&ctx->free, MTY_MEMORY_ORDER_RELAXED);
+		uint64_t tag = ((uint64_t) head >> 32) + 1;
+
+		MTY_Atomic32SetEx(&ctx->ti[index].next, (int32_t) (head & 0xFFFFFFFF), MTY_MEMORY_ORDER_RELAXED);
+
+		// Publishes the next link and everything written to the slot before it was freed
+		if (MTY_Atomic64CASEx(&ctx->free, head, (int64_t) (tag << 32 | index), MTY_MEMORY_ORDER_RELEASE))
+			break;
+	}
+}
+
+static uint32_t thread_pool_pop_free(MTY_ThreadPool *ctx)
+{
+	while (true) {
+		int64_t head = MTY_Atomic64GetEx(&ctx->free, MTY_MEMORY_ORDER_ACQUIRE);
+		uint32_t index = (uint32_t) (head & 0xFFFFFFFF);
+
+		if (index == 0)
+			return 0;
+
+		// If another thread pops this index first, the tag makes the CAS fail
+		uint64_t tag = ((uint64_t) head >> 32) + 1;
+		uint32_t next = (uint32_t) MTY_Atomic32GetEx(&ctx->ti[index].next, MTY_MEMORY_ORDER_RELAXED);
+
+		if (MTY_Atomic64CASEx(&ctx->free, head, (int64_t) (tag << 32 | next), MTY_MEMORY_ORDER_ACQUIRE))
+			return index;
+	}
+}
+
+static void thread_pool_release(MTY_ThreadPool *ctx, struct thread_info *ti)
+{
+	if (ti->detach)
+		ti->detach(ti->opaque);
+
+	MTY_Atomic32SetEx(&ti->status, MTY_ASYNC_DONE, MTY_MEMORY_ORDER_RELEASE);
+	thread_pool_push_free(ctx, (uint32_t) (ti - ctx->ti));
+}
+
+MTY_ThreadPool *MTY_ThreadPoolCreateQueued(uint32_t maxThreads, uint32_t maxQueued)
 {
 	MTY_ThreadPool *ctx = MTY_Alloc(1, sizeof(MTY_ThreadPool));
 
-	ctx->num = maxThreads + 1;
+	if (maxThreads == 0)
+		maxThreads = 1;
+
+	// Index 0 is never dispatched, it signifies failure
+	ctx->num = maxThreads + maxQueued + 1;
 	ctx->ti = MTY_Alloc(ctx->num, sizeof(struct thread_info));
+	ctx->queue = MTY_Alloc(ctx->num, sizeof(uint32_t));
 
-	for (uint32_t x = 0; x < ctx->num; x++) {
-		ctx->ti[x].status = MTY_ASYNC_DONE;
-		ctx->ti[x].m = MTY_MutexCreate();
-	}
+	for (uint32_t x = 0; x < ctx->num; x++)
+		MTY_Atomic32Set(&ctx->ti[x].status, MTY_ASYNC_DONE);
+
+	// Push in reverse so the lowest indexes are handed out first
+	for (uint32_t x = ctx->num - 1; x > 0; x--)
+		thread_pool_push_free(ctx, x);
+
+	ctx->max_threads = maxThreads;
+	ctx->threads = MTY_Alloc(ctx->max_threads, sizeof(MTY_Thread *));
+
+	ctx->mutex = MTY_MutexCreate();
+	ctx->cond = MTY_CondCreate();
 
 	return ctx;
 }
 
+MTY_ThreadPool *MTY_ThreadPoolCreate(uint32_t maxThreads)
+{
+	return MTY_ThreadPoolCreateQueued(maxThreads, 0);
+}
+
 void MTY_ThreadPoolDestroy(MTY_ThreadPool **pool, MTY_AnonFunc detach)
 {
 	if (!pool || !*pool)
@@ -238,15 +640,23 @@ void MTY_ThreadPoolDestroy(MTY_ThreadPool **pool, MTY_AnonFunc detach)
 
 	MTY_ThreadPool *ctx = *pool;
 
-	for (uint32_t x = 0; x < ctx->num; x++) {
+	for (uint32_t x = 1; x < ctx->num; x++)
 		MTY_ThreadPoolDetach(ctx, x, detach);
 
-		if (ctx->ti[x].t)
-			MTY_ThreadDestroy(&ctx->ti[x].t);
+	// Workers drain whatever is still queued before exiting
+	MTY_MutexLock(ctx->mutex);
+	ctx->stop = true;
+	MTY_CondSignalAll(ctx->cond);
+	MTY_MutexUnlock(ctx->mutex);
+
+	for (uint32_t x = 0; x < ctx->num_threads; x++)
+		MTY_ThreadDestroy(&ctx->threads[x]);
 
-		MTY_MutexDestroy(&ctx->ti[x].m);
-	}
+	MTY_CondDestroy(&ctx->cond);
+	MTY_MutexDestroy(&ctx->mutex);
 
+	MTY_Free(ctx->threads);
+	MTY_Free(ctx->queue);
 	MTY_Free(ctx->ti);
 	MTY_Free(ctx);
 	*pool = NULL;
@@ -254,92 +664,191 @@ void MTY_ThreadPoolDestroy(MTY_ThreadPool **pool, MTY_AnonFunc detach)
 
 static void *thread_pool_func(void *opaque)
 {
-	struct thread_info *ti = (struct thread_info *) opaque;
+	MTY_ThreadPool *ctx = opaque;
 
-	ti->func(ti->opaque);
+	MTY_ThreadSetName(NULL, "MTY_ThreadPool");
 
-	MTY_MutexLock(ti->m);
+	MTY_MutexLock(ctx->mutex);
 
-	if (ti->detach) {
-		ti->detach(ti->opaque);
-		ti->status = MTY_ASYNC_DONE;
+	while (true) {
+		while (ctx->queue_len == 0 && !ctx->stop) {
+			ctx->idle++;
+			MTY_CondWait(ctx->cond, ctx->mutex, -1);
+			ctx->idle--;
+		}
 
-	} else {
-		ti->status = MTY_ASYNC_OK;
+		if (ctx->queue_len == 0)
+			break;
+
+		struct thread_info *ti = &ctx->ti[ctx->queue[ctx->queue_pos]];
+		ctx->queue_pos = (ctx->queue_pos + 1) % ctx->num;
+		ctx->queue_len--;
+
+		MTY_MutexUnlock(ctx->mutex);
+
+		ti->func(ti->opaque);
+
+		// If the CAS fails the task was detached while it was running
+		if (!MTY_Atomic32CASEx(&ti->status, MTY_ASYNC_CONTINUE, MTY_ASYNC_OK, MTY_MEMORY_ORDER_ACQ_REL))
+			thread_pool_release(ctx, ti);
+
+		MTY_MutexLock(ctx->mutex);
 	}
 
-	MTY_MutexUnlock(ti->m);
+	MTY_MutexUnlock(ctx->mutex);
 
 	return NULL;
 }
 
 uint32_t MTY_ThreadPoolDispatch(MTY_ThreadPool *ctx, MTY_AnonFunc func, void *opaque)
 {
-	uint32_t index = 0;
+	uint32_t index = thread_pool_pop_free(ctx);
 
-	for (uint32_t x = 1; x < ctx->num && index == 0; x++) {
-		struct thread_info *ti = &ctx->ti[x];
+	if (index == 0) {
+		MTY_Log("Could not find available index");
+		return 0;
+	}
 
-		MTY_MutexLock(ti->m);
+	struct thread_info *ti = &ctx->ti[index];
+	ti->func = func;
+	ti->opaque = opaque;
+	ti->detach = NULL;
+	MTY_Atomic32SetEx(&ti->status, MTY_ASYNC_CONTINUE, MTY_MEMORY_ORDER_RELEASE);
+
+	MTY_MutexLock(ctx->mutex);
 
-		if (ti->status == MTY_ASYNC_DONE) {
-			MTY_ThreadDestroy(&ti->t);
+	ctx->queue[(ctx->queue_pos + ctx->queue_len) % ctx->num] = index;
+	ctx->queue_len++;
 
-			ti->func = func;
-			ti->opaque = opaque;
-			ti->detach = NULL;
-			ti->status = MTY_ASYNC_CONTINUE;
-			ti->t = MTY_ThreadCreate(thread_pool_func, ti);
-			index = x;
-		}
+	// Workers are spawned lazily and live until the pool is destroyed
+	if (ctx->queue_len > ctx->idle && ctx->num_threads < ctx->max_threads) {
+		MTY_Thread *thread = MTY_ThreadCreate(thread_pool_func, ctx);
 
-		MTY_MutexUnlock(ti->m);
+		if (ctx->affinity != 0)
+			MTY_ThreadSetAffinity(thread, ctx->affinity);
+
+		ctx->threads[ctx->num_threads++] = thread;
+
+	} else if (ctx->idle > 0) {
+		MTY_CondSignal(ctx->cond);
 	}
 
-	if (index == 0)
-		MTY_Log("Could not find available index");
+	MTY_MutexUnlock(ctx->mutex);
 
 	return index;
 }
 
 void MTY_ThreadPoolDetach(MTY_ThreadPool *ctx, uint32_t index, MTY_AnonFunc detach)
 {
+	if (index == 0)
+		return;
+
 	struct thread_info *ti = &ctx->ti[index];
 
-	MTY_MutexLock(ti->m);
+	// The detach function must be visible before the worker can observe the new status
+	MTY_Async status = MTY_Atomic32GetEx(&ti->status, MTY_MEMORY_ORDER_ACQUIRE);
 
-	if (ti->status == MTY_ASYNC_CONTINUE) {
+	if (status == MTY_ASYNC_CONTINUE) {
 		ti->detach = detach;
 
-	} else if (ti->status == MTY_ASYNC_OK) {
-		if (detach)
-			detach(ti->opaque);
+		if (MTY_Atomic32CASEx(&ti->status, MTY_ASYNC_CONTINUE, THREAD_POOL_DETACHED, MTY_MEMORY_ORDER_ACQ_REL))
+			return;
 
-		ti->status = MTY_ASYNC_DONE;
+		status = MTY_Atomic32GetEx(&ti->status, MTY_MEMORY_ORDER_ACQUIRE);
 	}
 
-	MTY_MutexUnlock(ti->m);
+	if (status == MTY_ASYNC_OK) {
+		ti->detach = detach;
+		thread_pool_release(ctx, ti);
+	}
 }
 
 MTY_Async MTY_ThreadPoolPoll(MTY_ThreadPool *ctx, uint32_t index, void **opaque)
 {
 	struct thread_info *ti = &ctx->ti[index];
 
-	MTY_MutexLock(ti->m);
-
-	MTY_Async status = ti->status;
+	// Acquire so the results written by the task are visible once it reports OK
+	MTY_Async status = MTY_Atomic32GetEx(&ti->status, MTY_MEMORY_ORDER_ACQUIRE);
 	*opaque = ti->opaque;
 
-	MTY_MutexUnlock(ti->m);
+	return status == THREAD_POOL_DETACHED ? MTY_ASYNC_CONTINUE : status;
+}
+
+void MTY_ThreadPoolSetAffinity(MTY_ThreadPool *ctx, uint64_t mask)
+{
+	MTY_MutexLock(ctx->mutex);
+
+	ctx->affinity = mask;
+
+	if (mask != 0)
+		for (uint32_t x = 0; x < ctx->num_threads; x++)
+			MTY_ThreadSetAffinity(ctx->threads[x], mask);
+
+	MTY_MutexUnlock(ctx->mutex);
+}
+
+
+// Once
+
+#define ONCE_INIT    0
+#define ONCE_RUNNING 1
+#define ONCE_DONE    2
+
+void MTY_CallOnce(MTY_Once *once, MTY_AnonFunc func, void *opaque)
+{
+	if (MTY_Atomic32GetEx(&once->state, MTY_MEMORY_ORDER_ACQUIRE) == ONCE_DONE)
+		return;
+
+	if (MTY_Atomic32CASEx(&once->state, ONCE_INIT, ONCE_RUNNING, MTY_MEMORY_ORDER_ACQUIRE)) {
+		func(opaque);
 
-	return status;
+		MTY_Atomic32SetEx(&once->state, ONCE_DONE, MTY_MEMORY_ORDER_RELEASE);
+
+		#if defined(__linux__)
+			mty_futex_wake(&once->state.value, INT32_MAX);
+		#endif
+
+		return;
+	}
+
+	while (MTY_Atomic32GetEx(&once->state, MTY_MEMORY_ORDER_ACQUIRE) != ONCE_DONE) {
+		#if defined(__linux__)
+			mty_futex_wait(&once->state.value, ONCE_RUNNING, -1);
+		#else
+			MTY_Sleep(0);
+		#endif
+	}
 }
 
 
 // Global locks
 
+// Locks are allocated in chunks on first use and live for the lifetime of the process
+#define THREAD_GLOCK_CHUNK  64
+#define THREAD_GLOCK_CHUNKS 1024
+
 static MTY_Atomic32 THREAD_GINDEX = {1};
-static mty_rwlock THREAD_GLOCKS[UINT8_MAX];
+static MTY_AtomicPtr THREAD_GLOCKS[THREAD_GLOCK_CHUNKS];
+
+static mty_rwlock *thread_glock(uint32_t index)
+{
+	MTY_AtomicPtr *chunk = &THREAD_GLOCKS[index / THREAD_GLOCK_CHUNK];
+	mty_rwlock *locks = MTY_AtomicPtrGet(chunk, MTY_MEMORY_ORDER_ACQUIRE);
+
+	if (!locks) {
+		mty_rwlock *new_locks = MTY_Alloc(THREAD_GLOCK_CHUNK, sizeof(mty_rwlock));
+
+		if (MTY_AtomicPtrCAS(chunk, NULL, new_locks, MTY_MEMORY_ORDER_ACQ_REL)) {
+			locks = new_locks;
+
+		} else {
+			MTY_Free(new_locks);
+			locks = MTY_AtomicPtrGet(chunk, MTY_MEMORY_ORDER_ACQUIRE);
+		}
+	}
+
+	return &locks[index % THREAD_GLOCK_CHUNK];
+}
 
 void MTY_GlobalLock(MTY_Atomic32 *lock)
 {
@@ -350,10 +859,10 @@ void MTY_GlobalLock(MTY_Atomic32 *lock)
 		if (index < 2) {
 			if (MTY_Atomic32CAS(lock, 0, 1)) {
 				index = MTY_Atomic32Add(&THREAD_GINDEX, 1);
-				if (index >= UINT8_MAX)
-					MTY_LogFatal("Global lock index of %u exceeded", UINT8_MAX);
+				if (index >= THREAD_GLOCK_CHUNK * THREAD_GLOCK_CHUNKS)
+					MTY_LogFatal("Global lock index of %u exceeded", THREAD_GLOCK_CHUNK * THREAD_GLOCK_CHUNKS);
 
-				mty_rwlock_create(&THREAD_GLOCKS[index]);
+				mty_rwlock_create(thread_glock(index));
 				MTY_Atomic32Set(lock, index);
 
 			} else {
@@ -362,11 +871,11 @@ void MTY_GlobalLock(MTY_Atomic32 *lock)
 			}
 		}
 
-		mty_rwlock_writer(&THREAD_GLOCKS[index]);
+		mty_rwlock_writer(thread_glock(index));
 	}
 }
 
 void MTY_GlobalUnlock(MTY_Atomic32 *lock)
 {
-	mty_rwlock_unlock_writer(&THREAD_GLOCKS[MTY_Atomic32Get(lock)]);
+	mty_rwlock_unlock_writer(thread_glock(MTY_Atomic32Get(lock)));
 }
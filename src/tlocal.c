@@ -5,68 +5,186 @@
 #include "matoya.h"
 #include "tlocal.h"
 
-#include <string.h>
 #include <stdio.h>
+#include <string.h>
+
+// A stack of pages per thread. The first page is static, further pages are allocated
+// on demand and linked after it. Pages after the current one are spares left over
+// from a popped scope. Outside of any scope results are only meant to live for a few
+// calls, so the stack wraps back to the first page instead of growing
+
+#define TLOCAL_PAGE  (8 * 1024)
+#define TLOCAL_KEEP  (64 * 1024)
+#define TLOCAL_ALIGN 8
 
-#define TLOCAL_MAX (8 * 1024)
+#define TLOCAL_ROUND(v) \
+	(((v) + TLOCAL_ALIGN - 1) & ~((size_t) TLOCAL_ALIGN - 1))
 
-static TLOCAL uint8_t *TLOCAL_MEM;
-static TLOCAL size_t *TLOCAL_OFFSET;
-static TLOCAL size_t TLOCAL_SIZE;
+struct tlocal_page {
+	struct tlocal_page *next;
+	uint8_t *mem;
+	size_t size;
+	size_t used;
+};
 
-static TLOCAL uint8_t TLOCAL_MEM_INTERNAL[TLOCAL_MAX];
-static TLOCAL size_t TLOCAL_OFFSET_INTERNAL;
-static TLOCAL size_t TLOCAL_OFFSET_EXTERNAL;
+static TLOCAL uint64_t TLOCAL_MEM[TLOCAL_PAGE / sizeof(uint64_t)];
+static TLOCAL struct tlocal_page TLOCAL_FIRST;
+static TLOCAL struct tlocal_page *TLOCAL_CUR;
+static TLOCAL uint32_t TLOCAL_DEPTH;
 
-static void tlocal_check_mem(void)
+static struct tlocal_page *tlocal_cur(void)
 {
-	if (!TLOCAL_MEM) {
-		TLOCAL_MEM = TLOCAL_MEM_INTERNAL;
-		TLOCAL_OFFSET = &TLOCAL_OFFSET_INTERNAL;
-		TLOCAL_SIZE = TLOCAL_MAX;
+	if (!TLOCAL_CUR) {
+		TLOCAL_FIRST.mem = (uint8_t *) TLOCAL_MEM;
+		TLOCAL_FIRST.size = TLOCAL_PAGE;
+		TLOCAL_CUR = &TLOCAL_FIRST;
 	}
+
+	return TLOCAL_CUR;
 }
 
-void *mty_tlocal(size_t size)
+static void tlocal_trim(void)
 {
-	tlocal_check_mem();
+	size_t kept = 0;
 
-	if (size > TLOCAL_SIZE)
-		MTY_LogFatal("Thread local storage heap overflow");
+	for (struct tlocal_page *prev = TLOCAL_CUR, *page = prev->next; page; page = prev->next) {
+		if (kept + page->size <= TLOCAL_KEEP) {
+			kept += page->size;
+			prev = page;
 
-	if (*TLOCAL_OFFSET + size > TLOCAL_SIZE)
-		*TLOCAL_OFFSET = 0;
+		} else {
+			prev->next = page->next;
+			MTY_Free(page);
+		}
+	}
+}
 
-	void *ptr = TLOCAL_MEM + *TLOCAL_OFFSET;
-	memset(ptr, 0, size);
+static bool tlocal_wraps(struct tlocal_page *page, size_t size)
+{
+	return page->used + size > page->size && !(page->next && size <= page->next->size) &&
+		TLOCAL_DEPTH == 0 && size <= TLOCAL_FIRST.size;
+}
+
+static void *tlocal_alloc(size_t size)
+{
+	struct tlocal_page *page = tlocal_cur();
+	size = TLOCAL_ROUND(size);
 
-	*TLOCAL_OFFSET += size;
+	if (page->used + size > page->size) {
+		if (page->next && size <= page->next->size) {
+			page = page->next;
+
+		} else if (tlocal_wraps(page, size)) {
+			page = TLOCAL_CUR = &TLOCAL_FIRST;
+			tlocal_trim();
+
+		} else {
+			size_t page_size = size > TLOCAL_PAGE ? size : TLOCAL_PAGE;
+
+			page = MTY_AllocUninit(1, TLOCAL_ROUND(sizeof(struct tlocal_page)) + page_size);
+			page->mem = (uint8_t *) page + TLOCAL_ROUND(sizeof(struct tlocal_page));
+			page->size = page_size;
+			page->next = TLOCAL_CUR->next;
+			TLOCAL_CUR->next = page;
+		}
+
+		page->used = 0;
+		TLOCAL_CUR = page;
+	}
+
+	void *ptr = page->mem + page->used;
+	page->used += size;
 
 	return ptr;
 }
 
-char *mty_tlocal_strcpy(const char *str)
+void *mty_tlocal(size_t size)
 {
-	tlocal_check_mem();
+	void *ptr = tlocal_alloc(size);
+	memset(ptr, 0, size);
+
+	return ptr;
+}
 
+char *mty_tlocal_strcpy(const char *str)
+{
 	size_t len = strlen(str) + 1;
 
-	if (len > TLOCAL_SIZE)
-		len = TLOCAL_SIZE;
+	// `str` may itself be in thread local storage, which a wrap overwrites or frees
+	if (tlocal_wraps(tlocal_cur(), TLOCAL_ROUND(len))) {
+		char *dup = MTY_Dup(str, len);
+		char *local = tlocal_alloc(len);
+		memcpy(local, dup, len);
+		MTY_Free(dup);
+
+		return local;
+	}
 
-	char *local = mty_tlocal(len);
-	snprintf(local, len, "%s", str);
+	char *local = tlocal_alloc(len);
+	memcpy(local, str, len);
 
 	return local;
 }
 
-void mty_tlocal_set_mem(void *buf, size_t size)
+char *mty_tlocal_vsprintf(const char *fmt, va_list args)
 {
-	TLOCAL_MEM = buf;
-	TLOCAL_SIZE = size;
+	va_list args_copy;
+	va_copy(args_copy, args);
+
+	size_t size = vsnprintf(NULL, 0, fmt, args_copy) + 1;
 
-	if (buf) {
-		TLOCAL_OFFSET = &TLOCAL_OFFSET_EXTERNAL;
-		*TLOCAL_OFFSET = 0;
+	va_end(args_copy);
+
+	// Same as above, the arguments may point into thread local storage
+	if (tlocal_wraps(tlocal_cur(), TLOCAL_ROUND(size))) {
+		char *str = MTY_VsprintfD(fmt, args);
+		char *local = mty_tlocal_strcpy(str);
+		MTY_Free(str);
+
+		return local;
 	}
+
+	char *local = tlocal_alloc(size);
+	vsnprintf(local, size, fmt, args);
+
+	return local;
+}
+
+void mty_tlocal_release(void)
+{
+	tlocal_cur();
+
+	for (struct tlocal_page *page = TLOCAL_FIRST.next; page;) {
+		struct tlocal_page *next = page->next;
+
+		MTY_Free(page);
+		page = next;
+	}
+
+	TLOCAL_FIRST.next = NULL;
+	TLOCAL_FIRST.used = 0;
+	TLOCAL_CUR = &TLOCAL_FIRST;
+	TLOCAL_DEPTH = 0;
+}
+
+MTY_ThreadLocalMark MTY_ThreadLocalPush(void)
+{
+	struct tlocal_page *page = tlocal_cur();
+
+	MTY_ThreadLocalMark mark = {0};
+	mark.page = page;
+	mark.used = page->used;
+	mark.depth = TLOCAL_DEPTH++;
+
+	return mark;
+}
+
+void MTY_ThreadLocalPop(const MTY_ThreadLocalMark *mark)
+{
+	TLOCAL_CUR = mark->page;
+	TLOCAL_CUR->used = mark->used;
+	TLOCAL_DEPTH = mark->depth;
+
+	if (TLOCAL_DEPTH == 0)
+		tlocal_trim();
 }
@@ -21,6 +21,7 @@
 #include <sys/file.h>
 #include <dirent.h>
 
+#include "fsutil.h"
 #include "home.h"
 #include "tlocal.h"
 
@@ -203,42 +204,44 @@ static int32_t file_compare(const void *p1, const void *p2)
 
 MTY_FileList *MTY_GetFileList(const char *path, const char *filter)
 {
-	void *tmp = MTY_Alloc(0x1000, 1);
-	mty_tlocal_set_mem(tmp, 0x1000);
+	// Keeps `path` and any other thread local results the caller holds intact
+	MTY_ThreadLocalMark mark = MTY_ThreadLocalPush();
 
-	MTY_FileList *fl = MTY_Alloc(1, sizeof(MTY_FileList));
-	char *pathd = MTY_Strdup(path);
+	struct file_list *ctx = MTY_Alloc(1, sizeof(struct file_list));
+	ctx->arena = MTY_ArenaCreate(16 * 1024);
+
+	MTY_FileList *fl = &ctx->fl;
 
 	bool ok = false;
 
 	struct dirent *ent = NULL;
-	DIR *dir = opendir(pathd);
+	DIR *dir = opendir(path);
 	if (dir) {
 		ent = readdir(dir);
 		ok = ent;
 	}
 
 	while (ok) {
+		MTY_ThreadLocalMark entry = MTY_ThreadLocalPush();
+
 		char *name = ent->d_name;
 		bool is_dir = ent->d_type == DT_DIR ||
 			(ent->d_type == DT_UNKNOWN && (!strcmp(name, "..") || !strcmp(name, ".")));
 
 		if (is_dir || MTY_StrSearch(name, filter ? filter : "", "|")) {
-			fl->files = MTY_Realloc(fl->files, fl->len + 1, sizeof(MTY_FileDesc));
+			MTY_FileDesc *desc = mty_file_list_add(ctx);
 
-			char *jpath = MTY_Strdup(MTY_JoinPath(pathd, name));
-
-			fl->files[fl->len].dir = is_dir;
-			fl->files[fl->len].name = MTY_Strdup(name);
-			fl->files[fl->len].path = jpath;
+			desc->dir = is_dir;
+			desc->name = MTY_ArenaStrdup(ctx->arena, name);
+			desc->path = MTY_ArenaStrdup(ctx->arena, MTY_JoinPath(path, name));
 
 			struct stat st;
-			if (!is_dir && stat(jpath, &st) == 0)
-				fl->files[fl->len].size = st.st_size;
-
-			fl->len++;
+			if (!is_dir && stat(desc->path, &st) == 0)
+				desc->size = st.st_size;
 		}
 
+		MTY_ThreadLocalPop(&entry);
+
 		ent = readdir(dir);
 		if (!ent) {
 			closedir(dir);
@@ -246,13 +249,10 @@ MTY_FileList *MTY_GetFileList(const char *path, const char *filter)
 		}
 	}
 
-	MTY_Free(pathd);
-
 	if (fl->len > 0)
 		MTY_Sort(fl->files, fl->len, sizeof(MTY_FileDesc), file_compare);
 
-	mty_tlocal_set_mem(NULL, 0);
-	MTY_Free(tmp);
+	MTY_ThreadLocalPop(&mark);
 
 	return fl;
 }
@@ -12,7 +12,17 @@
 
 #define FSUTIL_DELIM '/'
 
-static FILE *fsutil_open(const char *path, const char *mode)
+// File lists are built by each platform's MTY_GetFileList and freed by MTY_FreeFileList
+
+struct file_list {
+	MTY_FileList fl;
+	MTY_Arena *arena;
+	uint32_t cap;
+};
+
+MTY_FileDesc *mty_file_list_add(struct file_list *ctx);
+
+static inline FILE *fsutil_open(const char *path, const char *mode)
 {
 	FILE *f = fopen(path, mode);
 	if (!f) {
@@ -23,7 +33,7 @@ static FILE *fsutil_open(const char *path, const char *mode)
 	return f;
 }
 
-static size_t fsutil_size(const char *path)
+static inline size_t fsutil_size(const char *path)
 {
 	struct stat st;
 	int32_t e = stat(path, &st);
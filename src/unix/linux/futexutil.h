@@ -0,0 +1,38 @@
+// This Source Code Form is subject to the terms of the MIT License.
+// If a copy of the MIT License was not distributed with this file,
+// You can obtain one at https://spdx.org/licenses/MIT.html.
+
+#pragma once
+
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+static bool mty_futex_wait(volatile int32_t *addr, int32_t val, int32_t timeout)
+{
+	struct timespec ts = {0};
+	ts.tv_sec = timeout / 1000;
+	ts.tv_nsec = (timeout % 1000) * 1000 * 1000;
+
+	long r = syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, timeout < 0 ? NULL : &ts, NULL, 0);
+
+	// EAGAIN (value already changed) and EINTR are treated as spurious wakeups
+	if (r != 0 && errno == ETIMEDOUT)
+		return false;
+
+	if (r != 0 && errno != EAGAIN && errno != EINTR)
+		MTY_LogFatal("'SYS_futex' (FUTEX_WAIT) failed with errno %d", errno);
+
+	return true;
+}
+
+static void mty_futex_wake(volatile int32_t *addr, int32_t n)
+{
+	if (syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0) < 0)
+		MTY_LogFatal("'SYS_futex' (FUTEX_WAKE) failed with errno %d", errno);
+}
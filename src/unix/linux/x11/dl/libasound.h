@@ -152,60 +152,55 @@ static snd_pcm_uframes_t (*snd_pcm_status_get_avail_max)(const snd_pcm_status_t
 
 // Runtime open
 
-static MTY_Atomic32 LIBASOUND_LOCK;
+static MTY_Once LIBASOUND_ONCE;
 static MTY_SO *LIBASOUND_SO;
 static bool LIBASOUND_INIT;
 
 static void __attribute__((destructor)) libasound_global_destroy(void)
 {
-	MTY_GlobalLock(&LIBASOUND_LOCK);
-
 	MTY_SOUnload(&LIBASOUND_SO);
 	LIBASOUND_INIT = false;
-
-	MTY_GlobalUnlock(&LIBASOUND_LOCK);
 }
 
-static bool libasound_global_init(void)
+static void libasound_global_load(void *opaque)
 {
-	MTY_GlobalLock(&LIBASOUND_LOCK);
-
-	if (!LIBASOUND_INIT) {
-		bool r = true;
-
-		LIBASOUND_SO = MTY_SOLoad("libasound.so.2");
-
-		if (!LIBASOUND_SO) {
-			r = false;
-			goto except;
-		}
-
-		LOAD_SYM(LIBASOUND_SO, snd_pcm_open);
-		LOAD_SYM(LIBASOUND_SO, snd_pcm_hw_params_any);
-		LOAD_SYM(LIBASOUND_SO, snd_pcm_hw_params_set_access);
-		LOAD_SYM(LIBASOUND_SO, snd_pcm_hw_params_set_format);
-		LOAD_SYM(LIBASOUND_SO, snd_pcm_hw_params_set_channels);
-		LOAD_SYM(LIBASOUND_SO, snd_pcm_hw_params_set_rate);
-		LOAD_SYM(LIBASOUND_SO, snd_pcm_hw_params);
-		LOAD_SYM(LIBASOUND_SO, snd_pcm_prepare);
-		LOAD_SYM(LIBASOUND_SO, snd_pcm_writei);
-		LOAD_SYM(LIBASOUND_SO, snd_pcm_close);
-		LOAD_SYM(LIBASOUND_SO, snd_pcm_nonblock);
-		LOAD_SYM(LIBASOUND_SO, snd_pcm_status);
-		LOAD_SYM(LIBASOUND_SO, snd_pcm_status_sizeof);
-		LOAD_SYM(LIBASOUND_SO, snd_pcm_hw_params_sizeof);
-		LOAD_SYM(LIBASOUND_SO, snd_pcm_status_get_avail);
-		LOAD_SYM(LIBASOUND_SO, snd_pcm_status_get_avail_max);
-
-		except:
-
-		if (!r)
-			libasound_global_destroy();
-
-		LIBASOUND_INIT = r;
+	bool r = true;
+
+	LIBASOUND_SO = MTY_SOLoad("libasound.so.2");
+
+	if (!LIBASOUND_SO) {
+		r = false;
+		goto except;
 	}
 
-	MTY_GlobalUnlock(&LIBASOUND_LOCK);
+	LOAD_SYM(LIBASOUND_SO, snd_pcm_open);
+	LOAD_SYM(LIBASOUND_SO, snd_pcm_hw_params_any);
+	LOAD_SYM(LIBASOUND_SO, snd_pcm_hw_params_set_access);
+	LOAD_SYM(LIBASOUND_SO, snd_pcm_hw_params_set_format);
+	LOAD_SYM(LIBASOUND_SO, snd_pcm_hw_params_set_channels);
+	LOAD_SYM(LIBASOUND_SO, snd_pcm_hw_params_set_rate);
+	LOAD_SYM(LIBASOUND_SO, snd_pcm_hw_params);
+	LOAD_SYM(LIBASOUND_SO, snd_pcm_prepare);
+	LOAD_SYM(LIBASOUND_SO, snd_pcm_writei);
+	LOAD_SYM(LIBASOUND_SO, snd_pcm_close);
+	LOAD_SYM(LIBASOUND_SO, snd_pcm_nonblock);
+	LOAD_SYM(LIBASOUND_SO, snd_pcm_status);
+	LOAD_SYM(LIBASOUND_SO, snd_pcm_status_sizeof);
+	LOAD_SYM(LIBASOUND_SO, snd_pcm_hw_params_sizeof);
+	LOAD_SYM(LIBASOUND_SO, snd_pcm_status_get_avail);
+	LOAD_SYM(LIBASOUND_SO, snd_pcm_status_get_avail_max);
+
+	except:
+
+	if (!r)
+		libasound_global_destroy();
+
+	LIBASOUND_INIT = r;
+}
+
+static bool libasound_global_init(void)
+{
+	MTY_CallOnce(&LIBASOUND_ONCE, libasound_global_load, NULL);
 
 	return LIBASOUND_INIT;
 }
@@ -30,65 +30,60 @@ static unsigned char *(*HMAC)(const EVP_MD *evp_md, const void *key, int key_len
 static int (*RAND_bytes)(unsigned char *buf, int num);
 static int (*EVP_EncodeBlock)(unsigned char *t, const unsigned char *f, int n);
 
-static MTY_Atomic32 LIBCRYPTO_LOCK;
+static MTY_Once LIBCRYPTO_ONCE;
 static MTY_SO *LIBCRYPTO_SO;
 static bool LIBCRYPTO_INIT;
 
 static void __attribute__((destructor)) libcrypto_global_destroy(void)
 {
-	MTY_GlobalLock(&LIBCRYPTO_LOCK);
-
 	MTY_SOUnload(&LIBCRYPTO_SO);
 	LIBCRYPTO_INIT = false;
-
-	MTY_GlobalUnlock(&LIBCRYPTO_LOCK);
 }
 
-static bool libcrypto_global_init(void)
+static void libcrypto_global_load(void *opaque)
 {
-	MTY_GlobalLock(&LIBCRYPTO_LOCK);
-
-	if (!LIBCRYPTO_INIT) {
-		bool r = true;
-		LIBCRYPTO_SO = MTY_SOLoad("libcrypto.so.3");
-
-		if (!LIBCRYPTO_SO)
-			LIBCRYPTO_SO = MTY_SOLoad("libcrypto.so.1.1");
-
-		if (!LIBCRYPTO_SO)
-			LIBCRYPTO_SO = MTY_SOLoad("libcrypto.so.1.0.0");
-
-		if (!LIBCRYPTO_SO) {
-			r = false;
-			goto except;
-		}
-
-		LOAD_SYM(LIBCRYPTO_SO, EVP_aes_128_gcm);
-		LOAD_SYM(LIBCRYPTO_SO, EVP_CIPHER_CTX_new);
-		LOAD_SYM(LIBCRYPTO_SO, EVP_CIPHER_CTX_free);
-		LOAD_SYM(LIBCRYPTO_SO, EVP_CipherInit_ex);
-		LOAD_SYM(LIBCRYPTO_SO, EVP_EncryptUpdate);
-		LOAD_SYM(LIBCRYPTO_SO, EVP_DecryptUpdate);
-		LOAD_SYM(LIBCRYPTO_SO, EVP_EncryptFinal_ex);
-		LOAD_SYM(LIBCRYPTO_SO, EVP_DecryptFinal_ex);
-		LOAD_SYM(LIBCRYPTO_SO, EVP_CIPHER_CTX_ctrl);
-		LOAD_SYM(LIBCRYPTO_SO, EVP_sha1);
-		LOAD_SYM(LIBCRYPTO_SO, EVP_sha256);
-		LOAD_SYM(LIBCRYPTO_SO, SHA1);
-		LOAD_SYM(LIBCRYPTO_SO, SHA256);
-		LOAD_SYM(LIBCRYPTO_SO, HMAC);
-		LOAD_SYM(LIBCRYPTO_SO, RAND_bytes);
-		LOAD_SYM(LIBCRYPTO_SO, EVP_EncodeBlock);
-
-		except:
-
-		if (!r)
-			libcrypto_global_destroy();
-
-		LIBCRYPTO_INIT = r;
+	bool r = true;
+	LIBCRYPTO_SO = MTY_SOLoad("libcrypto.so.3");
+
+	if (!LIBCRYPTO_SO)
+		LIBCRYPTO_SO = MTY_SOLoad("libcrypto.so.1.1");
+
+	if (!LIBCRYPTO_SO)
+		LIBCRYPTO_SO = MTY_SOLoad("libcrypto.so.1.0.0");
+
+	if (!LIBCRYPTO_SO) {
+		r = false;
+		goto except;
 	}
 
-	MTY_GlobalUnlock(&LIBCRYPTO_LOCK);
+	LOAD_SYM(LIBCRYPTO_SO, EVP_aes_128_gcm);
+	LOAD_SYM(LIBCRYPTO_SO, EVP_CIPHER_CTX_new);
+	LOAD_SYM(LIBCRYPTO_SO, EVP_CIPHER_CTX_free);
+	LOAD_SYM(LIBCRYPTO_SO, EVP_CipherInit_ex);
+	LOAD_SYM(LIBCRYPTO_SO, EVP_EncryptUpdate);
+	LOAD_SYM(LIBCRYPTO_SO, EVP_DecryptUpdate);
+	LOAD_SYM(LIBCRYPTO_SO, EVP_EncryptFinal_ex);
+	LOAD_SYM(LIBCRYPTO_SO, EVP_DecryptFinal_ex);
+	LOAD_SYM(LIBCRYPTO_SO, EVP_CIPHER_CTX_ctrl);
+	LOAD_SYM(LIBCRYPTO_SO, EVP_sha1);
+	LOAD_SYM(LIBCRYPTO_SO, EVP_sha256);
+	LOAD_SYM(LIBCRYPTO_SO, SHA1);
+	LOAD_SYM(LIBCRYPTO_SO, SHA256);
+	LOAD_SYM(LIBCRYPTO_SO, HMAC);
+	LOAD_SYM(LIBCRYPTO_SO, RAND_bytes);
+	LOAD_SYM(LIBCRYPTO_SO, EVP_EncodeBlock);
+
+	except:
+
+	if (!r)
+		libcrypto_global_destroy();
+
+	LIBCRYPTO_INIT = r;
+}
+
+static bool libcrypto_global_init(void)
+{
+	MTY_CallOnce(&LIBCRYPTO_ONCE, libcrypto_global_load, NULL);
 
 	return LIBCRYPTO_INIT;
 }
@@ -106,66 +106,61 @@ static CURLUcode (*curl_url_set)(CURLU *handle, CURLUPart what, const char *part
 
 // Runtime open
 
-static MTY_Atomic32 LIBCURL_LOCK;
+static MTY_Once LIBCURL_ONCE;
 static MTY_SO *LIBCURL_SO;
 static bool LIBCURL_INIT;
 
 static void __attribute__((destructor)) libcurl_global_destroy(void)
 {
-	MTY_GlobalLock(&LIBCURL_LOCK);
-
 	MTY_SOUnload(&LIBCURL_SO);
 	LIBCURL_INIT = false;
-
-	MTY_GlobalUnlock(&LIBCURL_LOCK);
 }
 
-static bool libcurl_global_init(void)
+static void libcurl_global_load(void *opaque)
 {
-	MTY_GlobalLock(&LIBCURL_LOCK);
-
-	if (!LIBCURL_INIT) {
-		bool r = true;
-		LIBCURL_SO = MTY_SOLoad("libcurl.so.4");
-
-		if (!LIBCURL_SO) {
-			r = false;
-			goto except;
-		}
-
-		LOAD_SYM(LIBCURL_SO, curl_global_init);
-		LOAD_SYM(LIBCURL_SO, curl_easy_init);
-		LOAD_SYM(LIBCURL_SO, curl_easy_cleanup);
-		LOAD_SYM(LIBCURL_SO, curl_easy_setopt);
-		LOAD_SYM(LIBCURL_SO, curl_easy_perform);
-		LOAD_SYM(LIBCURL_SO, curl_easy_send);
-		LOAD_SYM(LIBCURL_SO, curl_easy_recv);
-		LOAD_SYM(LIBCURL_SO, curl_easy_getinfo);
-		LOAD_SYM(LIBCURL_SO, curl_slist_append);
-		LOAD_SYM(LIBCURL_SO, curl_slist_free_all);
-		LOAD_SYM(LIBCURL_SO, curl_free);
-
-		LOAD_SYM_OPT(LIBCURL_SO, curl_url);
-		LOAD_SYM_OPT(LIBCURL_SO, curl_url_cleanup);
-		LOAD_SYM_OPT(LIBCURL_SO, curl_url_get);
-		LOAD_SYM_OPT(LIBCURL_SO, curl_url_set);
-
-		CURLcode e = curl_global_init(CURL_GLOBAL_ALL);
-		if (e != CURLE_OK) {
-			MTY_Log("'curl_global_init' failed with error %d", e);
-			r = false;
-			goto except;
-		}
-
-		except:
-
-		if (!r)
-			libcurl_global_destroy();
-
-		LIBCURL_INIT = r;
+	bool r = true;
+	LIBCURL_SO = MTY_SOLoad("libcurl.so.4");
+
+	if (!LIBCURL_SO) {
+		r = false;
+		goto except;
+	}
+
+	LOAD_SYM(LIBCURL_SO, curl_global_init);
+	LOAD_SYM(LIBCURL_SO, curl_easy_init);
+	LOAD_SYM(LIBCURL_SO, curl_easy_cleanup);
+	LOAD_SYM(LIBCURL_SO, curl_easy_setopt);
+	LOAD_SYM(LIBCURL_SO, curl_easy_perform);
+	LOAD_SYM(LIBCURL_SO, curl_easy_send);
+	LOAD_SYM(LIBCURL_SO, curl_easy_recv);
+	LOAD_SYM(LIBCURL_SO, curl_easy_getinfo);
+	LOAD_SYM(LIBCURL_SO, curl_slist_append);
+	LOAD_SYM(LIBCURL_SO, curl_slist_free_all);
+	LOAD_SYM(LIBCURL_SO, curl_free);
+
+	LOAD_SYM_OPT(LIBCURL_SO, curl_url);
+	LOAD_SYM_OPT(LIBCURL_SO, curl_url_cleanup);
+	LOAD_SYM_OPT(LIBCURL_SO, curl_url_get);
+	LOAD_SYM_OPT(LIBCURL_SO, curl_url_set);
+
+	CURLcode e = curl_global_init(CURL_GLOBAL_ALL);
+	if (e != CURLE_OK) {
+		MTY_Log("'curl_global_init' failed with error %d", e);
+		r = false;
+		goto except;
 	}
 
-	MTY_GlobalUnlock(&LIBCURL_LOCK);
+	except:
+
+	if (!r)
+		libcurl_global_destroy();
+
+	LIBCURL_INIT = r;
+}
+
+static bool libcurl_global_init(void)
+{
+	MTY_CallOnce(&LIBCURL_ONCE, libcurl_global_load, NULL);
 
 	return LIBCURL_INIT;
 }
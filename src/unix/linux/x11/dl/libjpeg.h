@@ -224,51 +224,46 @@ static void (*jpeg_destroy_decompress)(j_decompress_ptr cinfo);
 
 // Runtime open
 
-static MTY_Atomic32 LIBJPEG_LOCK;
+static MTY_Once LIBJPEG_ONCE;
 static MTY_SO *LIBJPEG_SO;
 static bool LIBJPEG_INIT;
 
 static void __attribute__((destructor)) libjpeg_global_destroy(void)
 {
-	MTY_GlobalLock(&LIBJPEG_LOCK);
-
 	MTY_SOUnload(&LIBJPEG_SO);
 	LIBJPEG_INIT = false;
-
-	MTY_GlobalUnlock(&LIBJPEG_LOCK);
 }
 
-static bool libjpeg_global_init(void)
+static void libjpeg_global_load(void *opaque)
 {
-	MTY_GlobalLock(&LIBJPEG_LOCK);
+	bool r = true;
 
-	if (!LIBJPEG_INIT) {
-		bool r = true;
-
-		LIBJPEG_SO = MTY_SOLoad("libjpeg.so.8");
-		if (!LIBJPEG_SO) {
-			r = false;
-			goto except;
-		}
+	LIBJPEG_SO = MTY_SOLoad("libjpeg.so.8");
+	if (!LIBJPEG_SO) {
+		r = false;
+		goto except;
+	}
 
-		LOAD_SYM(LIBJPEG_SO, jpeg_std_error);
-		LOAD_SYM(LIBJPEG_SO, jpeg_CreateDecompress);
-		LOAD_SYM(LIBJPEG_SO, jpeg_mem_src);
-		LOAD_SYM(LIBJPEG_SO, jpeg_read_header);
-		LOAD_SYM(LIBJPEG_SO, jpeg_start_decompress);
-		LOAD_SYM(LIBJPEG_SO, jpeg_read_scanlines);
-		LOAD_SYM(LIBJPEG_SO, jpeg_finish_decompress);
-		LOAD_SYM(LIBJPEG_SO, jpeg_destroy_decompress);
+	LOAD_SYM(LIBJPEG_SO, jpeg_std_error);
+	LOAD_SYM(LIBJPEG_SO, jpeg_CreateDecompress);
+	LOAD_SYM(LIBJPEG_SO, jpeg_mem_src);
+	LOAD_SYM(LIBJPEG_SO, jpeg_read_header);
+	LOAD_SYM(LIBJPEG_SO, jpeg_start_decompress);
+	LOAD_SYM(LIBJPEG_SO, jpeg_read_scanlines);
+	LOAD_SYM(LIBJPEG_SO, jpeg_finish_decompress);
+	LOAD_SYM(LIBJPEG_SO, jpeg_destroy_decompress);
 
-		except:
+	except:
 
-		if (!r)
-			libjpeg_global_destroy();
+	if (!r)
+		libjpeg_global_destroy();
 
-		LIBJPEG_INIT = r;
-	}
+	LIBJPEG_INIT = r;
+}
 
-	MTY_GlobalUnlock(&LIBJPEG_LOCK);
+static bool libjpeg_global_init(void)
+{
+	MTY_CallOnce(&LIBJPEG_ONCE, libjpeg_global_load, NULL);
 
 	return LIBJPEG_INIT;
 }
@@ -73,58 +73,53 @@ static jmp_buf *(*png_set_longjmp_fn)(png_structrp png_ptr, png_longjmp_ptr long
 
 // Runtime open
 
-static MTY_Atomic32 LIBPNG_LOCK;
+static MTY_Once LIBPNG_ONCE;
 static MTY_SO *LIBPNG_SO;
 static bool LIBPNG_INIT;
 
 static void __attribute__((destructor)) libpng_global_destroy(void)
 {
-	MTY_GlobalLock(&LIBPNG_LOCK);
-
 	MTY_SOUnload(&LIBPNG_SO);
 	LIBPNG_INIT = false;
-
-	MTY_GlobalUnlock(&LIBPNG_LOCK);
 }
 
-static bool libpng_global_init(void)
+static void libpng_global_load(void *opaque)
 {
-	MTY_GlobalLock(&LIBPNG_LOCK);
-
-	if (!LIBPNG_INIT) {
-		bool r = true;
-
-		LIBPNG_SO = MTY_SOLoad("libpng16.so.16");
-		if (!LIBPNG_SO) {
-			r = false;
-			goto except;
-		}
-
-		LOAD_SYM(LIBPNG_SO, png_sig_cmp);
-		LOAD_SYM(LIBPNG_SO, png_create_read_struct);
-		LOAD_SYM(LIBPNG_SO, png_destroy_read_struct);
-		LOAD_SYM(LIBPNG_SO, png_create_info_struct);
-		LOAD_SYM(LIBPNG_SO, png_destroy_info_struct);
-		LOAD_SYM(LIBPNG_SO, png_set_read_fn);
-		LOAD_SYM(LIBPNG_SO, png_get_io_ptr);
-		LOAD_SYM(LIBPNG_SO, png_set_sig_bytes);
-		LOAD_SYM(LIBPNG_SO, png_read_info);
-		LOAD_SYM(LIBPNG_SO, png_get_IHDR);
-		LOAD_SYM(LIBPNG_SO, png_set_add_alpha);
-		LOAD_SYM(LIBPNG_SO, png_set_interlace_handling);
-		LOAD_SYM(LIBPNG_SO, png_read_update_info);
-		LOAD_SYM(LIBPNG_SO, png_read_row);
-		LOAD_SYM(LIBPNG_SO, png_set_longjmp_fn);
-
-		except:
-
-		if (!r)
-			libpng_global_destroy();
-
-		LIBPNG_INIT = r;
+	bool r = true;
+
+	LIBPNG_SO = MTY_SOLoad("libpng16.so.16");
+	if (!LIBPNG_SO) {
+		r = false;
+		goto except;
 	}
 
-	MTY_GlobalUnlock(&LIBPNG_LOCK);
+	LOAD_SYM(LIBPNG_SO, png_sig_cmp);
+	LOAD_SYM(LIBPNG_SO, png_create_read_struct);
+	LOAD_SYM(LIBPNG_SO, png_destroy_read_struct);
+	LOAD_SYM(LIBPNG_SO, png_create_info_struct);
+	LOAD_SYM(LIBPNG_SO, png_destroy_info_struct);
+	LOAD_SYM(LIBPNG_SO, png_set_read_fn);
+	LOAD_SYM(LIBPNG_SO, png_get_io_ptr);
+	LOAD_SYM(LIBPNG_SO, png_set_sig_bytes);
+	LOAD_SYM(LIBPNG_SO, png_read_info);
+	LOAD_SYM(LIBPNG_SO, png_get_IHDR);
+	LOAD_SYM(LIBPNG_SO, png_set_add_alpha);
+	LOAD_SYM(LIBPNG_SO, png_set_interlace_handling);
+	LOAD_SYM(LIBPNG_SO, png_read_update_info);
+	LOAD_SYM(LIBPNG_SO, png_read_row);
+	LOAD_SYM(LIBPNG_SO, png_set_longjmp_fn);
+
+	except:
+
+	if (!r)
+		libpng_global_destroy();
+
+	LIBPNG_INIT = r;
+}
+
+static bool libpng_global_init(void)
+{
+	MTY_CallOnce(&LIBPNG_ONCE, libpng_global_load, NULL);
 
 	return LIBPNG_INIT;
 }
@@ -112,120 +112,115 @@ static int (*ASN1_INTEGER_set)(ASN1_INTEGER *a, long v);
 
 // Runtime open
 
-static MTY_Atomic32 LIBSSL_LOCK;
+static MTY_Once LIBSSL_ONCE;
 static MTY_SO *LIBSSL_SO;
 static bool LIBSSL_INIT;
 
 static void __attribute__((destructor)) libssl_global_destroy(void)
 {
-	MTY_GlobalLock(&LIBSSL_LOCK);
-
 	MTY_SOUnload(&LIBSSL_SO);
 	LIBSSL_INIT = false;
-
-	MTY_GlobalUnlock(&LIBSSL_LOCK);
 }
 
-static bool libssl_global_init(void)
+static void libssl_global_load(void *opaque)
 {
-	MTY_GlobalLock(&LIBSSL_LOCK);
-
-	if (!LIBSSL_INIT) {
-		bool r = true;
-		bool ssl3 = true;
-		bool library_init = false;
-		LIBSSL_SO = MTY_SOLoad("libssl.so.3");
-
-		if (!LIBSSL_SO) {
-			LIBSSL_SO = MTY_SOLoad("libssl.so.1.1");
-			ssl3 = false;
-		}
-
-		if (!LIBSSL_SO) {
-			LIBSSL_SO = MTY_SOLoad("libssl.so.1.0.0");
-			library_init = true;
-		}
-
-		if (!LIBSSL_SO) {
-			r = false;
-			goto except;
-		}
-
-		LOAD_SYM(LIBSSL_SO, SSL_new);
-		LOAD_SYM(LIBSSL_SO, SSL_free);
-		LOAD_SYM(LIBSSL_SO, SSL_read);
-		LOAD_SYM(LIBSSL_SO, SSL_write);
-		LOAD_SYM(LIBSSL_SO, SSL_set_verify);
-		LOAD_SYM(LIBSSL_SO, SSL_get_error);
-		LOAD_SYM(LIBSSL_SO, SSL_ctrl);
-		LOAD_SYM(LIBSSL_SO, SSL_set_bio);
-		LOAD_SYM(LIBSSL_SO, SSL_set_connect_state);
-		LOAD_SYM(LIBSSL_SO, SSL_do_handshake);
-		LOAD_SYM(LIBSSL_SO, SSL_use_certificate);
-		LOAD_SYM(LIBSSL_SO, SSL_use_RSAPrivateKey);
-
-		// libssl 3 uses a different symbol for SSL_get_peer_certificate
-		if (ssl3) {
-			LOAD_SYM(LIBSSL_SO, SSL_get1_peer_certificate);
-			SSL_get_peer_certificate = SSL_get1_peer_certificate;
-
-		} else {
-			LOAD_SYM(LIBSSL_SO, SSL_get_peer_certificate);
-		}
-
-		LOAD_SYM(LIBSSL_SO, DTLS_method);
-		LOAD_SYM(LIBSSL_SO, SSL_CTX_new);
-		LOAD_SYM(LIBSSL_SO, SSL_CTX_free);
-
-		LOAD_SYM(LIBSSL_SO, BIO_new);
-		LOAD_SYM(LIBSSL_SO, BIO_s_mem);
-		LOAD_SYM(LIBSSL_SO, BIO_write);
-		LOAD_SYM(LIBSSL_SO, BIO_ctrl_pending);
-		LOAD_SYM(LIBSSL_SO, BIO_read);
-		LOAD_SYM(LIBSSL_SO, BIO_free);
-
-		LOAD_SYM(LIBSSL_SO, X509_new);
-		LOAD_SYM(LIBSSL_SO, X509_free);
-		LOAD_SYM(LIBSSL_SO, X509_set_pubkey);
-		LOAD_SYM(LIBSSL_SO, X509_sign);
-		LOAD_SYM(LIBSSL_SO, X509_digest);
-		// LOAD_SYM(LIBSSL_SO, X509_getm_notBefore);
-		// LOAD_SYM(LIBSSL_SO, X509_getm_notAfter);
-		LOAD_SYM(LIBSSL_SO, X509_set_version);
-		LOAD_SYM(LIBSSL_SO, X509_set_issuer_name);
-		LOAD_SYM(LIBSSL_SO, X509_get_subject_name);
-		LOAD_SYM(LIBSSL_SO, X509_get_serialNumber);
-		LOAD_SYM(LIBSSL_SO, X509_gmtime_adj);
-		LOAD_SYM(LIBSSL_SO, X509_NAME_add_entry_by_txt);
-
-		LOAD_SYM(LIBSSL_SO, RSA_new);
-		LOAD_SYM(LIBSSL_SO, RSA_free);
-		LOAD_SYM(LIBSSL_SO, RSA_generate_key_ex);
-
-		LOAD_SYM(LIBSSL_SO, BN_new);
-		LOAD_SYM(LIBSSL_SO, BN_free);
-		LOAD_SYM(LIBSSL_SO, BN_set_word);
-
-		LOAD_SYM(LIBSSL_SO, EVP_PKEY_new);
-		LOAD_SYM(LIBSSL_SO, EVP_sha256);
-		LOAD_SYM(LIBSSL_SO, EVP_PKEY_assign);
-
-		LOAD_SYM(LIBSSL_SO, ASN1_INTEGER_set);
-
-		if (library_init) {
-			LOAD_SYM(LIBSSL_SO, SSL_library_init);
-			SSL_library_init();
-		}
-
-		except:
-
-		if (!r)
-			libssl_global_destroy();
-
-		LIBSSL_INIT = r;
+	bool r = true;
+	bool ssl3 = true;
+	bool library_init = false;
+	LIBSSL_SO = MTY_SOLoad("libssl.so.3");
+
+	if (!LIBSSL_SO) {
+		LIBSSL_SO = MTY_SOLoad("libssl.so.1.1");
+		ssl3 = false;
+	}
+
+	if (!LIBSSL_SO) {
+		LIBSSL_SO = MTY_SOLoad("libssl.so.1.0.0");
+		library_init = true;
+	}
+
+	if (!LIBSSL_SO) {
+		r = false;
+		goto except;
+	}
+
+	LOAD_SYM(LIBSSL_SO, SSL_new);
+	LOAD_SYM(LIBSSL_SO, SSL_free);
+	LOAD_SYM(LIBSSL_SO, SSL_read);
+	LOAD_SYM(LIBSSL_SO, SSL_write);
+	LOAD_SYM(LIBSSL_SO, SSL_set_verify);
+	LOAD_SYM(LIBSSL_SO, SSL_get_error);
+	LOAD_SYM(LIBSSL_SO, SSL_ctrl);
+	LOAD_SYM(LIBSSL_SO, SSL_set_bio);
+	LOAD_SYM(LIBSSL_SO, SSL_set_connect_state);
+	LOAD_SYM(LIBSSL_SO, SSL_do_handshake);
+	LOAD_SYM(LIBSSL_SO, SSL_use_certificate);
+	LOAD_SYM(LIBSSL_SO, SSL_use_RSAPrivateKey);
+
+	// libssl 3 uses a different symbol for SSL_get_peer_certificate
+	if (ssl3) {
+		LOAD_SYM(LIBSSL_SO, SSL_get1_peer_certificate);
+		SSL_get_peer_certificate = SSL_get1_peer_certificate;
+
+	} else {
+		LOAD_SYM(LIBSSL_SO, SSL_get_peer_certificate);
 	}
 
-	MTY_GlobalUnlock(&LIBSSL_LOCK);
+	LOAD_SYM(LIBSSL_SO, DTLS_method);
+	LOAD_SYM(LIBSSL_SO, SSL_CTX_new);
+	LOAD_SYM(LIBSSL_SO, SSL_CTX_free);
+
+	LOAD_SYM(LIBSSL_SO, BIO_new);
+	LOAD_SYM(LIBSSL_SO, BIO_s_mem);
+	LOAD_SYM(LIBSSL_SO, BIO_write);
+	LOAD_SYM(LIBSSL_SO, BIO_ctrl_pending);
+	LOAD_SYM(LIBSSL_SO, BIO_read);
+	LOAD_SYM(LIBSSL_SO, BIO_free);
+
+	LOAD_SYM(LIBSSL_SO, X509_new);
+	LOAD_SYM(LIBSSL_SO, X509_free);
+	LOAD_SYM(LIBSSL_SO, X509_set_pubkey);
+	LOAD_SYM(LIBSSL_SO, X509_sign);
+	LOAD_SYM(LIBSSL_SO, X509_digest);
+	// LOAD_SYM(LIBSSL_SO, X509_getm_notBefore);
+	// LOAD_SYM(LIBSSL_SO, X509_getm_notAfter);
+	LOAD_SYM(LIBSSL_SO, X509_set_version);
+	LOAD_SYM(LIBSSL_SO, X509_set_issuer_name);
+	LOAD_SYM(LIBSSL_SO, X509_get_subject_name);
+	LOAD_SYM(LIBSSL_SO, X509_get_serialNumber);
+	LOAD_SYM(LIBSSL_SO, X509_gmtime_adj);
+	LOAD_SYM(LIBSSL_SO, X509_NAME_add_entry_by_txt);
+
+	LOAD_SYM(LIBSSL_SO, RSA_new);
+	LOAD_SYM(LIBSSL_SO, RSA_free);
+	LOAD_SYM(LIBSSL_SO, RSA_generate_key_ex);
+
+	LOAD_SYM(LIBSSL_SO, BN_new);
+	LOAD_SYM(LIBSSL_SO, BN_free);
+	LOAD_SYM(LIBSSL_SO, BN_set_word);
+
+	LOAD_SYM(LIBSSL_SO, EVP_PKEY_new);
+	LOAD_SYM(LIBSSL_SO, EVP_sha256);
+	LOAD_SYM(LIBSSL_SO, EVP_PKEY_assign);
+
+	LOAD_SYM(LIBSSL_SO, ASN1_INTEGER_set);
+
+	if (library_init) {
+		LOAD_SYM(LIBSSL_SO, SSL_library_init);
+		SSL_library_init();
+	}
+
+	except:
+
+	if (!r)
+		libssl_global_destroy();
+
+	LIBSSL_INIT = r;
+}
+
+static bool libssl_global_init(void)
+{
+	MTY_CallOnce(&LIBSSL_ONCE, libssl_global_load, NULL);
 
 	return LIBSSL_INIT;
 }
@@ -40,63 +40,58 @@ static const char *(*udev_list_entry_get_name)(struct udev_list_entry *list_entr
 
 // Runtime open
 
-static MTY_Atomic32 LIBUDEV_LOCK;
+static MTY_Once LIBUDEV_ONCE;
 static MTY_SO *LIBUDEV_SO;
 static bool LIBUDEV_INIT;
 
 static void __attribute__((destructor)) libudev_global_destroy(void)
 {
-	MTY_GlobalLock(&LIBUDEV_LOCK);
-
 	MTY_SOUnload(&LIBUDEV_SO);
 	LIBUDEV_INIT = false;
-
-	MTY_GlobalUnlock(&LIBUDEV_LOCK);
 }
 
-static bool libudev_global_init(void)
+static void libudev_global_load(void *opaque)
 {
-	MTY_GlobalLock(&LIBUDEV_LOCK);
-
-	if (!LIBUDEV_INIT) {
-		bool r = true;
-
-		LIBUDEV_SO = MTY_SOLoad("libudev.so.1");
-		if (!LIBUDEV_SO) {
-			r = false;
-			goto except;
-		}
-
-		LOAD_SYM(LIBUDEV_SO, udev_new);
-		LOAD_SYM(LIBUDEV_SO, udev_unref);
-		LOAD_SYM(LIBUDEV_SO, udev_monitor_new_from_netlink);
-		LOAD_SYM(LIBUDEV_SO, udev_monitor_enable_receiving);
-		LOAD_SYM(LIBUDEV_SO, udev_monitor_filter_add_match_subsystem_devtype);
-		LOAD_SYM(LIBUDEV_SO, udev_monitor_unref);
-		LOAD_SYM(LIBUDEV_SO, udev_monitor_get_fd);
-		LOAD_SYM(LIBUDEV_SO, udev_monitor_receive_device);
-		LOAD_SYM(LIBUDEV_SO, udev_device_new_from_syspath);
-		LOAD_SYM(LIBUDEV_SO, udev_device_get_action);
-		LOAD_SYM(LIBUDEV_SO, udev_device_get_syspath);
-		LOAD_SYM(LIBUDEV_SO, udev_device_get_devnode);
-		LOAD_SYM(LIBUDEV_SO, udev_device_unref);
-		LOAD_SYM(LIBUDEV_SO, udev_enumerate_new);
-		LOAD_SYM(LIBUDEV_SO, udev_enumerate_add_match_subsystem);
-		LOAD_SYM(LIBUDEV_SO, udev_enumerate_scan_devices);
-		LOAD_SYM(LIBUDEV_SO, udev_enumerate_get_list_entry);
-		LOAD_SYM(LIBUDEV_SO, udev_enumerate_unref);
-		LOAD_SYM(LIBUDEV_SO, udev_list_entry_get_next);
-		LOAD_SYM(LIBUDEV_SO, udev_list_entry_get_name);
-
-		except:
-
-		if (!r)
-			libudev_global_destroy();
-
-		LIBUDEV_INIT = r;
+	bool r = true;
+
+	LIBUDEV_SO = MTY_SOLoad("libudev.so.1");
+	if (!LIBUDEV_SO) {
+		r = false;
+		goto except;
 	}
 
-	MTY_GlobalUnlock(&LIBUDEV_LOCK);
+	LOAD_SYM(LIBUDEV_SO, udev_new);
+	LOAD_SYM(LIBUDEV_SO, udev_unref);
+	LOAD_SYM(LIBUDEV_SO, udev_monitor_new_from_netlink);
+	LOAD_SYM(LIBUDEV_SO, udev_monitor_enable_receiving);
+	LOAD_SYM(LIBUDEV_SO, udev_monitor_filter_add_match_subsystem_devtype);
+	LOAD_SYM(LIBUDEV_SO, udev_monitor_unref);
+	LOAD_SYM(LIBUDEV_SO, udev_monitor_get_fd);
+	LOAD_SYM(LIBUDEV_SO, udev_monitor_receive_device);
+	LOAD_SYM(LIBUDEV_SO, udev_device_new_from_syspath);
+	LOAD_SYM(LIBUDEV_SO, udev_device_get_action);
+	LOAD_SYM(LIBUDEV_SO, udev_device_get_syspath);
+	LOAD_SYM(LIBUDEV_SO, udev_device_get_devnode);
+	LOAD_SYM(LIBUDEV_SO, udev_device_unref);
+	LOAD_SYM(LIBUDEV_SO, udev_enumerate_new);
+	LOAD_SYM(LIBUDEV_SO, udev_enumerate_add_match_subsystem);
+	LOAD_SYM(LIBUDEV_SO, udev_enumerate_scan_devices);
+	LOAD_SYM(LIBUDEV_SO, udev_enumerate_get_list_entry);
+	LOAD_SYM(LIBUDEV_SO, udev_enumerate_unref);
+	LOAD_SYM(LIBUDEV_SO, udev_list_entry_get_next);
+	LOAD_SYM(LIBUDEV_SO, udev_list_entry_get_name);
+
+	except:
+
+	if (!r)
+		libudev_global_destroy();
+
+	LIBUDEV_INIT = r;
+}
+
+static bool libudev_global_init(void)
+{
+	MTY_CallOnce(&LIBUDEV_ONCE, libudev_global_load, NULL);
 
 	return LIBUDEV_INIT;
 }
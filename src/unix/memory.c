@@ -14,6 +14,17 @@
 
 void *MTY_AllocAligned(size_t size, size_t align)
 {
+	const MTY_Allocator *hooks = MTY_GetAllocator();
+
+	if (hooks && hooks->allocAligned) {
+		void *mem = hooks->allocAligned(size, align, hooks->opaque);
+
+		if (!mem)
+			MTY_LogFatal("'allocAligned' failed");
+
+		return mem;
+	}
+
 	void *mem = NULL;
 	int32_t e = posix_memalign(&mem, align, size);
 
@@ -27,7 +38,14 @@ void *MTY_AllocAligned(size_t size, size_t align)
 
 void MTY_FreeAligned(void *mem)
 {
-	free(mem);
+	const MTY_Allocator *hooks = MTY_GetAllocator();
+
+	if (hooks && hooks->allocAligned) {
+		hooks->freeAligned(mem, hooks->opaque);
+
+	} else {
+		free(mem);
+	}
 }
 
 int32_t MTY_Strcasecmp(const char *s0, const char *s1)
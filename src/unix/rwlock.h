@@ -12,7 +12,7 @@
 
 typedef pthread_rwlock_t mty_rwlock;
 
-static void mty_rwlock_create(mty_rwlock *rwlock)
+static inline void mty_rwlock_create(mty_rwlock *rwlock)
 {
 	pthread_rwlockattr_t attr;
 
@@ -32,14 +32,14 @@ static void mty_rwlock_create(mty_rwlock *rwlock)
 		MTY_LogFatal("'pthread_rwlockattr_destroy' failed with error %d", e);
 }
 
-static void mty_rwlock_reader(mty_rwlock *rwlock)
+static inline void mty_rwlock_reader(mty_rwlock *rwlock)
 {
 	int32_t e = pthread_rwlock_rdlock(rwlock);
 	if (e != 0)
 		MTY_LogFatal("'pthread_rwlock_rdlock' failed with error %d", e);
 }
 
-static bool mty_rwlock_try_reader(mty_rwlock *rwlock)
+static inline bool mty_rwlock_try_reader(mty_rwlock *rwlock)
 {
 	int32_t e = pthread_rwlock_tryrdlock(rwlock);
 	if (e != 0 && e != EBUSY)
@@ -48,26 +48,26 @@ static bool mty_rwlock_try_reader(mty_rwlock *rwlock)
 	return e == 0;
 }
 
-static void mty_rwlock_writer(mty_rwlock *rwlock)
+static inline void mty_rwlock_writer(mty_rwlock *rwlock)
 {
 	int32_t e = pthread_rwlock_wrlock(rwlock);
 	if (e != 0)
 		MTY_LogFatal("'pthread_rwlock_wrlock' failed with error %d", e);
 }
 
-static void mty_rwlock_unlock_reader(mty_rwlock *rwlock)
+static inline void mty_rwlock_unlock_reader(mty_rwlock *rwlock)
 {
 	int32_t e = pthread_rwlock_unlock(rwlock);
 	if (e != 0)
 		MTY_Log("'pthread_rwlock_unlock' failed with error %d", e);
 }
 
-static void mty_rwlock_unlock_writer(mty_rwlock *rwlock)
+static inline void mty_rwlock_unlock_writer(mty_rwlock *rwlock)
 {
 	mty_rwlock_unlock_reader(rwlock);
 }
 
-static void mty_rwlock_destroy(mty_rwlock *rwlock)
+static inline void mty_rwlock_destroy(mty_rwlock *rwlock)
 {
 	int32_t e = pthread_rwlock_destroy(rwlock);
 	if (e != 0)
@@ -2,37 +2,120 @@
 // If a copy of the MIT License was not distributed with this file,
 // You can obtain one at https://spdx.org/licenses/MIT.html.
 
-#define _DEFAULT_SOURCE // clock_gettime
+#define _GNU_SOURCE // clock_gettime, cpu_set_t, pthread_setname_np
 
 #include "matoya.h"
 
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 #include <errno.h>
 #include <time.h>
 
 #include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+	#include <sys/resource.h>
+	#include <sys/syscall.h>
+
+	#include "futexutil.h"
+#endif
 
 
 // Thread
 
+// Realtime priority used for MTY_THREAD_PRIORITY_REALTIME, low enough to stay
+// below kernel threads and typical audio servers
+#define THREAD_RT_PRIORITY 10
+
+// Nice values on Linux are per kernel task. A thread's tid is 0 until it starts,
+// when it applies any nice value requested before then, and -1 once it has finished
+// so a tid the kernel may have handed to another task is never used
+#define THREAD_NICE_UNSET INT32_MIN
+
 struct MTY_Thread {
 	pthread_t thread;
 	bool detach;
 	MTY_ThreadFunc func;
 	void *opaque;
 	void *ret;
+
+	#if defined(__linux__)
+		MTY_Atomic32 tid;
+		MTY_Atomic32 nice;
+	#endif
 };
 
+#if defined(__linux__)
+
+static bool thread_set_nice(pid_t tid, int32_t nice)
+{
+	if (setpriority(PRIO_PROCESS, tid, nice) == 0)
+		return true;
+
+	// Without CAP_SYS_NICE the nice value can only be lowered to the RLIMIT_NICE ceiling
+	struct rlimit rl = {0};
+
+	if (nice < 0 && errno == EACCES && getrlimit(RLIMIT_NICE, &rl) == 0) {
+		int32_t min = 20 - (int32_t) rl.rlim_cur;
+
+		if (min < 0 && setpriority(PRIO_PROCESS, tid, min) == 0)
+			return true;
+	}
+
+	MTY_Log("'setpriority' failed with errno %d", errno);
+
+	return false;
+}
+
+static bool thread_nice(MTY_Thread *ctx, int32_t nice)
+{
+	if (!ctx)
+		return thread_set_nice((pid_t) syscall(SYS_gettid), nice);
+
+	MTY_Atomic32Set(&ctx->nice, nice);
+
+	int32_t tid = MTY_Atomic32Get(&ctx->tid);
+
+	if (tid == -1)
+		return false;
+
+	// The thread applies the latest value itself as soon as it starts
+	if (tid == 0)
+		return true;
+
+	return thread_set_nice(tid, nice);
+}
+
+#endif
+
 static void *thread_func(void *opaque)
 {
 	MTY_Thread *ctx = (MTY_Thread *) opaque;
 
+	#if defined(__linux__)
+		pid_t tid = (pid_t) syscall(SYS_gettid);
+		MTY_Atomic32Set(&ctx->tid, tid);
+
+		int32_t nice = MTY_Atomic32Get(&ctx->nice);
+
+		if (nice != THREAD_NICE_UNSET)
+			thread_set_nice(tid, nice);
+	#endif
+
 	ctx->ret = ctx->func(ctx->opaque);
 
+	#if defined(__linux__)
+		MTY_Atomic32Set(&ctx->tid, -1);
+	#endif
+
 	if (ctx->detach)
 		MTY_Free(ctx);
 
+	MTY_ReleaseThreadCache();
+
 	return NULL;
 }
 
@@ -43,6 +126,10 @@ static MTY_Thread *thread_create(MTY_ThreadFunc func, void *opaque, bool detach)
 	ctx->opaque = opaque;
 	ctx->detach = detach;
 
+	#if defined(__linux__)
+		MTY_Atomic32Set(&ctx->nice, THREAD_NICE_UNSET);
+	#endif
+
 	pthread_t thread = 0;
 	int32_t e = pthread_create(&thread, NULL, thread_func, ctx);
 
@@ -99,9 +186,225 @@ int64_t MTY_ThreadGetID(MTY_Thread *ctx)
 	return (int64_t) (ctx ? ctx->thread : pthread_self());
 }
 
+uint32_t MTY_GetNumProcessors(void)
+{
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return n > 0 ? (uint32_t) n : 1;
+}
+
+static bool thread_set_realtime(pthread_t thread)
+{
+	int32_t min = sched_get_priority_min(SCHED_FIFO);
+	int32_t max = sched_get_priority_max(SCHED_FIFO);
+
+	struct sched_param param = {0};
+	param.sched_priority = MTY_MIN(MTY_MAX(THREAD_RT_PRIORITY, min), max);
+
+	#if defined(__linux__)
+		// Unprivileged processes may still use realtime scheduling up to RLIMIT_RTPRIO
+		struct rlimit rl = {0};
+
+		if (getrlimit(RLIMIT_RTPRIO, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY &&
+			(int32_t) rl.rlim_cur >= min && (int32_t) rl.rlim_cur < param.sched_priority)
+		{
+			param.sched_priority = (int32_t) rl.rlim_cur;
+		}
+	#endif
+
+	if (pthread_setschedparam(thread, SCHED_FIFO, &param) == 0)
+		return true;
+
+	return pthread_setschedparam(thread, SCHED_RR, &param) == 0;
+}
+
+bool MTY_ThreadSetPriority(MTY_Thread *ctx, MTY_ThreadPriority priority)
+{
+	pthread_t thread = ctx ? ctx->thread : pthread_self();
+
+	if (priority == MTY_THREAD_PRIORITY_REALTIME) {
+		if (thread_set_realtime(thread))
+			return true;
+
+		// Realtime scheduling is not permitted, get as close as possible
+		priority = MTY_THREAD_PRIORITY_HIGH;
+	}
+
+	struct sched_param param = {0};
+
+	#if defined(__linux__)
+		// Linux ignores the static priority for SCHED_OTHER, it uses the per-thread nice value
+		int32_t e = pthread_setschedparam(thread, SCHED_OTHER, &param);
+
+		if (e != 0) {
+			MTY_Log("'pthread_setschedparam' failed with error %d", e);
+			return false;
+		}
+
+		return thread_nice(ctx, priority == MTY_THREAD_PRIORITY_LOW ? 10 :
+			priority == MTY_THREAD_PRIORITY_HIGH ? -10 : 0);
+
+	#else
+		int32_t min = sched_get_priority_min(SCHED_OTHER);
+		int32_t max = sched_get_priority_max(SCHED_OTHER);
+
+		param.sched_priority = priority == MTY_THREAD_PRIORITY_LOW ? min :
+			priority == MTY_THREAD_PRIORITY_HIGH ? max : (min + max) / 2;
+
+		int32_t e = pthread_setschedparam(thread, SCHED_OTHER, &param);
+
+		if (e != 0) {
+			MTY_Log("'pthread_setschedparam' failed with error %d", e);
+			return false;
+		}
+
+		return true;
+	#endif
+}
+
+bool MTY_ThreadSetAffinity(MTY_Thread *ctx, uint64_t mask)
+{
+	#if defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+
+		for (uint32_t x = 0; x < 64; x++)
+			if (mask & (1ull << x))
+				CPU_SET(x, &set);
+
+		int32_t e = pthread_setaffinity_np(ctx ? ctx->thread : pthread_self(), sizeof(cpu_set_t), &set);
+		if (e != 0) {
+			MTY_Log("'pthread_setaffinity_np' failed with error %d", e);
+			return false;
+		}
+
+		return true;
+
+	#else
+		// Apple only supports affinity tags as scheduling hints
+		return false;
+	#endif
+}
+
+bool MTY_ThreadSetName(MTY_Thread *ctx, const char *name)
+{
+	#if defined(__APPLE__)
+		// Apple can only name the calling thread
+		if (ctx && !pthread_equal(ctx->thread, pthread_self()))
+			return false;
+
+		int32_t e = pthread_setname_np(name);
+		if (e != 0) {
+			MTY_Log("'pthread_setname_np' failed with error %d", e);
+			return false;
+		}
+
+		return true;
+
+	#elif defined(__linux__)
+		// Linux truncates names to 15 characters plus the null terminator
+		char tname[16];
+		snprintf(tname, 16, "%s", name);
+
+		int32_t e = pthread_setname_np(ctx ? ctx->thread : pthread_self(), tname);
+		if (e != 0) {
+			MTY_Log("'pthread_setname_np' failed with error %d", e);
+			return false;
+		}
+
+		return true;
+
+	#else
+		return false;
+	#endif
+}
+
 
 // Mutex
 
+#if defined(__linux__)
+
+// Maximum number of times to spin before sleeping, the actual number is adapted
+// per mutex based on how long previous acquisitions took
+#define MUTEX_SPIN_MAX 100
+
+struct MTY_Mutex {
+	int32_t state; // 0 unlocked, 1 locked, 2 locked with possible waiters
+	int32_t spins;
+};
+
+MTY_Mutex *MTY_MutexCreate(void)
+{
+	return MTY_Alloc(1, sizeof(MTY_Mutex));
+}
+
+void MTY_MutexDestroy(MTY_Mutex **mutex)
+{
+	if (!mutex || !*mutex)
+		return;
+
+	MTY_Free(*mutex);
+	*mutex = NULL;
+}
+
+static void mutex_relax(void)
+{
+	#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+	#elif defined(__aarch64__) || defined(__arm__)
+		__asm__ __volatile__("yield");
+	#endif
+}
+
+static bool mutex_try_lock(MTY_Mutex *ctx)
+{
+	int32_t c = 0;
+
+	return __atomic_compare_exchange_n(&ctx->state, &c, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static void mutex_lock_contended(MTY_Mutex *ctx)
+{
+	while (__atomic_exchange_n(&ctx->state, 2, __ATOMIC_ACQUIRE) != 0)
+		mty_futex_wait(&ctx->state, 2, -1);
+}
+
+void MTY_MutexLock(MTY_Mutex *ctx)
+{
+	if (mutex_try_lock(ctx))
+		return;
+
+	int32_t spins = __atomic_load_n(&ctx->spins, __ATOMIC_RELAXED);
+	int32_t max = MTY_MIN(spins * 2 + 10, MUTEX_SPIN_MAX);
+
+	for (int32_t x = 0; x < max; x++) {
+		if (__atomic_load_n(&ctx->state, __ATOMIC_RELAXED) == 0 && mutex_try_lock(ctx)) {
+			__atomic_store_n(&ctx->spins, spins + (x - spins) / 8, __ATOMIC_RELAXED);
+			return;
+		}
+
+		mutex_relax();
+	}
+
+	__atomic_store_n(&ctx->spins, spins + (max - spins) / 8, __ATOMIC_RELAXED);
+
+	mutex_lock_contended(ctx);
+}
+
+bool MTY_MutexTryLock(MTY_Mutex *ctx)
+{
+	return mutex_try_lock(ctx);
+}
+
+void MTY_MutexUnlock(MTY_Mutex *ctx)
+{
+	// Only make the syscall if another thread may be sleeping
+	if (__atomic_exchange_n(&ctx->state, 0, __ATOMIC_RELEASE) == 2)
+		mty_futex_wake(&ctx->state, 1);
+}
+
+#else
+
 struct MTY_Mutex {
 	pthread_mutex_t mutex;
 };
@@ -155,9 +458,70 @@ void MTY_MutexUnlock(MTY_Mutex *ctx)
 		MTY_LogFatal("'pthread_mutex_unlock' failed with error %d", e);
 }
 
+#endif
+
 
 // Cond
 
+#if defined(__linux__)
+
+struct MTY_Cond {
+	int32_t seq;
+	int32_t waiters;
+};
+
+MTY_Cond *MTY_CondCreate(void)
+{
+	return MTY_Alloc(1, sizeof(MTY_Cond));
+}
+
+void MTY_CondDestroy(MTY_Cond **cond)
+{
+	if (!cond || !*cond)
+		return;
+
+	MTY_Free(*cond);
+	*cond = NULL;
+}
+
+bool MTY_CondWait(MTY_Cond *ctx, MTY_Mutex *mutex, int32_t timeout)
+{
+	__atomic_add_fetch(&ctx->waiters, 1, __ATOMIC_SEQ_CST);
+	int32_t seq = __atomic_load_n(&ctx->seq, __ATOMIC_SEQ_CST);
+
+	MTY_MutexUnlock(mutex);
+
+	// If the sequence changed after unlocking, a signal has already been sent
+	bool r = mty_futex_wait(&ctx->seq, seq, timeout);
+
+	__atomic_sub_fetch(&ctx->waiters, 1, __ATOMIC_SEQ_CST);
+
+	// Other woken threads may be waiting on the mutex as well
+	mutex_lock_contended(mutex);
+
+	return r;
+}
+
+static void cond_signal(MTY_Cond *ctx, int32_t n)
+{
+	__atomic_add_fetch(&ctx->seq, 1, __ATOMIC_SEQ_CST);
+
+	if (__atomic_load_n(&ctx->waiters, __ATOMIC_SEQ_CST) > 0)
+		mty_futex_wake(&ctx->seq, n);
+}
+
+void MTY_CondSignal(MTY_Cond *ctx)
+{
+	cond_signal(ctx, 1);
+}
+
+void MTY_CondSignalAll(MTY_Cond *ctx)
+{
+	cond_signal(ctx, INT32_MAX);
+}
+
+#else
+
 struct MTY_Cond {
 	pthread_cond_t cond;
 };
@@ -234,38 +598,63 @@ void MTY_CondSignalAll(MTY_Cond *ctx)
 		MTY_LogFatal("'pthread_cond_broadcast' failed with error %d", e);
 }
 
+#endif
+
 
 // Atomic
 
 // XXX Android will complain about the 64-bit atomics on 32-bit platforms,
 // there is probably a performance penalty but not critical enough to care
 
+// The builtins fall back to __ATOMIC_SEQ_CST when the order is not a compile time
+// constant, so each order gets its own branch
+
+#define ATOMIC_LOAD(ptr, order) \
+	((order) == MTY_MEMORY_ORDER_RELAXED ? __atomic_load_n(ptr, __ATOMIC_RELAXED) : \
+	(order) == MTY_MEMORY_ORDER_ACQUIRE ? __atomic_load_n(ptr, __ATOMIC_ACQUIRE) : \
+	__atomic_load_n(ptr, __ATOMIC_SEQ_CST))
+
+#define ATOMIC_STORE(ptr, val, order) \
+	((order) == MTY_MEMORY_ORDER_RELAXED ? __atomic_store_n(ptr, val, __ATOMIC_RELAXED) : \
+	(order) == MTY_MEMORY_ORDER_RELEASE ? __atomic_store_n(ptr, val, __ATOMIC_RELEASE) : \
+	__atomic_store_n(ptr, val, __ATOMIC_SEQ_CST))
+
+#define ATOMIC_RMW(func, ptr, val, order) \
+	((order) == MTY_MEMORY_ORDER_RELAXED ? func(ptr, val, __ATOMIC_RELAXED) : \
+	(order) == MTY_MEMORY_ORDER_ACQUIRE ? func(ptr, val, __ATOMIC_ACQUIRE) : \
+	(order) == MTY_MEMORY_ORDER_RELEASE ? func(ptr, val, __ATOMIC_RELEASE) : \
+	(order) == MTY_MEMORY_ORDER_ACQ_REL ? func(ptr, val, __ATOMIC_ACQ_REL) : \
+	func(ptr, val, __ATOMIC_SEQ_CST))
+
+#define ATOMIC_CAS(ptr, expected, val, order) \
+	((order) == MTY_MEMORY_ORDER_RELAXED ? \
+		__atomic_compare_exchange_n(ptr, expected, val, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED) : \
+	(order) == MTY_MEMORY_ORDER_ACQUIRE ? \
+		__atomic_compare_exchange_n(ptr, expected, val, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE) : \
+	(order) == MTY_MEMORY_ORDER_RELEASE ? \
+		__atomic_compare_exchange_n(ptr, expected, val, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED) : \
+	(order) == MTY_MEMORY_ORDER_ACQ_REL ? \
+		__atomic_compare_exchange_n(ptr, expected, val, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) : \
+	__atomic_compare_exchange_n(ptr, expected, val, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+
 void MTY_Atomic32Set(MTY_Atomic32 *atomic, int32_t value)
 {
-	__atomic_store(&atomic->value, &value, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&atomic->value, value, __ATOMIC_SEQ_CST);
 }
 
 void MTY_Atomic64Set(MTY_Atomic64 *atomic, int64_t value)
 {
-	__atomic_store(&atomic->value, &value, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&atomic->value, value, __ATOMIC_SEQ_CST);
 }
 
 int32_t MTY_Atomic32Get(MTY_Atomic32 *atomic)
 {
-	int32_t r;
-
-	__atomic_load(&atomic->value, &r, __ATOMIC_SEQ_CST);
-
-	return r;
+	return __atomic_load_n(&atomic->value, __ATOMIC_SEQ_CST);
 }
 
 int64_t MTY_Atomic64Get(MTY_Atomic64 *atomic)
 {
-	int64_t r;
-
-	__atomic_load(&atomic->value, &r, __ATOMIC_SEQ_CST);
-
-	return r;
+	return __atomic_load_n(&atomic->value, __ATOMIC_SEQ_CST);
 }
 
 int32_t MTY_Atomic32Add(MTY_Atomic32 *atomic, int32_t value)
@@ -289,3 +678,78 @@ bool MTY_Atomic64CAS(MTY_Atomic64 *atomic, int64_t oldValue, int64_t newValue)
 	return __atomic_compare_exchange_n(&atomic->value, &oldValue, newValue, false,
 		__ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
 }
+
+void MTY_Atomic32SetEx(MTY_Atomic32 *atomic, int32_t value, MTY_MemoryOrder order)
+{
+	ATOMIC_STORE(&atomic->value, value, order);
+}
+
+void MTY_Atomic64SetEx(MTY_Atomic64 *atomic, int64_t value, MTY_MemoryOrder order)
+{
+	ATOMIC_STORE(&atomic->value, value, order);
+}
+
+int32_t MTY_Atomic32GetEx(MTY_Atomic32 *atomic, MTY_MemoryOrder order)
+{
+	return ATOMIC_LOAD(&atomic->value, order);
+}
+
+int64_t MTY_Atomic64GetEx(MTY_Atomic64 *atomic, MTY_MemoryOrder order)
+{
+	return ATOMIC_LOAD(&atomic->value, order);
+}
+
+int32_t MTY_Atomic32AddEx(MTY_Atomic32 *atomic, int32_t value, MTY_MemoryOrder order)
+{
+	return ATOMIC_RMW(__atomic_add_fetch, &atomic->value, value, order);
+}
+
+int64_t MTY_Atomic64AddEx(MTY_Atomic64 *atomic, int64_t value, MTY_MemoryOrder order)
+{
+	return ATOMIC_RMW(__atomic_add_fetch, &atomic->value, value, order);
+}
+
+bool MTY_Atomic32CASEx(MTY_Atomic32 *atomic, int32_t oldValue, int32_t newValue,
+	MTY_MemoryOrder order)
+{
+	return ATOMIC_CAS(&atomic->value, &oldValue, newValue, order);
+}
+
+bool MTY_Atomic64CASEx(MTY_Atomic64 *atomic, int64_t oldValue, int64_t newValue,
+	MTY_MemoryOrder order)
+{
+	return ATOMIC_CAS(&atomic->value, &oldValue, newValue, order);
+}
+
+void MTY_AtomicPtrSet(MTY_AtomicPtr *atomic, void *value, MTY_MemoryOrder order)
+{
+	ATOMIC_STORE(&atomic->value, (uintptr_t) value, order);
+}
+
+void *MTY_AtomicPtrGet(MTY_AtomicPtr *atomic, MTY_MemoryOrder order)
+{
+	return (void *) ATOMIC_LOAD(&atomic->value, order);
+}
+
+void *MTY_AtomicPtrExchange(MTY_AtomicPtr *atomic, void *value, MTY_MemoryOrder order)
+{
+	return (void *) ATOMIC_RMW(__atomic_exchange_n, &atomic->value, (uintptr_t) value, order);
+}
+
+bool MTY_AtomicPtrCAS(MTY_AtomicPtr *atomic, void *oldValue, void *newValue,
+	MTY_MemoryOrder order)
+{
+	uintptr_t expected = (uintptr_t) oldValue;
+
+	return ATOMIC_CAS(&atomic->value, &expected, (uintptr_t) newValue, order);
+}
+
+void *MTY_AtomicPtrOr(MTY_AtomicPtr *atomic, uintptr_t mask, MTY_MemoryOrder order)
+{
+	return (void *) ATOMIC_RMW(__atomic_fetch_or, &atomic->value, mask, order);
+}
+
+void *MTY_AtomicPtrAnd(MTY_AtomicPtr *atomic, uintptr_t mask, MTY_MemoryOrder order)
+{
+	return (void *) ATOMIC_RMW(__atomic_fetch_and, &atomic->value, mask, order);
+}
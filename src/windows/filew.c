@@ -10,7 +10,7 @@
 #include <shlwapi.h>
 #include <shlobj_core.h>
 
-#include "tlocal.h"
+#include "fsutil.h"
 
 bool MTY_DeleteFile(const char *path)
 {
@@ -234,50 +234,49 @@ static int32_t file_compare(const void *p1, const void *p2)
 
 MTY_FileList *MTY_GetFileList(const char *path, const char *filter)
 {
-	void *tmp = MTY_Alloc(0x1000, 1);
-	mty_tlocal_set_mem(tmp, 0x1000);
+	// Keeps `path` and any other thread local results the caller holds intact
+	MTY_ThreadLocalMark mark = MTY_ThreadLocalPush();
 
-	MTY_FileList *fl = MTY_Alloc(1, sizeof(MTY_FileList));
-	char *pathd = MTY_Strdup(path);
+	struct file_list *ctx = MTY_Alloc(1, sizeof(struct file_list));
+	ctx->arena = MTY_ArenaCreate(16 * 1024);
+
+	MTY_FileList *fl = &ctx->fl;
 
 	WIN32_FIND_DATA ent;
-	const wchar_t *pathw = MTY_MultiToWideDL(MTY_JoinPath(pathd, "*"));
+	const wchar_t *pathw = MTY_MultiToWideDL(MTY_JoinPath(path, "*"));
 
 	HANDLE dir = FindFirstFile(pathw, &ent);
 	bool ok = dir != INVALID_HANDLE_VALUE;
 
 	while (ok) {
+		MTY_ThreadLocalMark entry = MTY_ThreadLocalPush();
+
 		wchar_t *namew = ent.cFileName;
-		char *name = MTY_WideToMultiD(namew);
+		const char *name = MTY_WideToMultiDL(namew);
 
 		bool is_dir = ent.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY;
 
 		if (is_dir || MTY_StrSearch(name, filter ? filter : "", "|")) {
-			fl->files = MTY_Realloc(fl->files, fl->len + 1, sizeof(MTY_FileDesc));
-
-			fl->files[fl->len].name = name;
-			fl->files[fl->len].path = MTY_Strdup(MTY_JoinPath(pathd, name));
-			fl->files[fl->len].dir = is_dir;
-			fl->files[fl->len].size = (uint64_t) ent.nFileSizeHigh << 32 | ent.nFileSizeLow;
-			fl->len++;
+			MTY_FileDesc *desc = mty_file_list_add(ctx);
 
-		} else {
-			MTY_Free(name);
+			desc->name = MTY_ArenaStrdup(ctx->arena, name);
+			desc->path = MTY_ArenaStrdup(ctx->arena, MTY_JoinPath(path, desc->name));
+			desc->dir = is_dir;
+			desc->size = (uint64_t) ent.nFileSizeHigh << 32 | ent.nFileSizeLow;
 		}
 
+		MTY_ThreadLocalPop(&entry);
+
 		ok = FindNextFile(dir, &ent);
 
 		if (!ok)
 			FindClose(dir);
 	}
 
-	MTY_Free(pathd);
-
 	if (fl->len > 0)
 		MTY_Sort(fl->files, fl->len, sizeof(MTY_FileDesc), file_compare);
 
-	mty_tlocal_set_mem(NULL, 0);
-	MTY_Free(tmp);
+	MTY_ThreadLocalPop(&mark);
 
 	return fl;
 }
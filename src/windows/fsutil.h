@@ -11,7 +11,17 @@
 
 #define FSUTIL_DELIM '\\'
 
-static FILE *fsutil_open(const char *path, const char *mode)
+// File lists are built by each platform's MTY_GetFileList and freed by MTY_FreeFileList
+
+struct file_list {
+	MTY_FileList fl;
+	MTY_Arena *arena;
+	uint32_t cap;
+};
+
+MTY_FileDesc *mty_file_list_add(struct file_list *ctx);
+
+static inline FILE *fsutil_open(const char *path, const char *mode)
 {
 	wchar_t *wpath = MTY_MultiToWideD(path);
 	wchar_t *wmode = MTY_MultiToWideD(mode);
@@ -30,7 +40,7 @@ static FILE *fsutil_open(const char *path, const char *mode)
 	return f;
 }
 
-static size_t fsutil_size(const char *path)
+static inline size_t fsutil_size(const char *path)
 {
 	wchar_t *wpath = MTY_MultiToWideD(path);
 
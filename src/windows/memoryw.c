@@ -12,6 +12,17 @@
 
 void *MTY_AllocAligned(size_t size, size_t align)
 {
+	const MTY_Allocator *hooks = MTY_GetAllocator();
+
+	if (hooks && hooks->allocAligned) {
+		void *mem = hooks->allocAligned(size, align, hooks->opaque);
+
+		if (!mem)
+			MTY_LogFatal("'allocAligned' failed");
+
+		return mem;
+	}
+
 	void *mem = _aligned_malloc(size, align);
 
 	if (!mem)
@@ -24,7 +35,14 @@ void *MTY_AllocAligned(size_t size, size_t align)
 
 void MTY_FreeAligned(void *mem)
 {
-	_aligned_free(mem);
+	const MTY_Allocator *hooks = MTY_GetAllocator();
+
+	if (hooks && hooks->allocAligned) {
+		hooks->freeAligned(mem, hooks->opaque);
+
+	} else {
+		_aligned_free(mem);
+	}
 }
 
 int32_t MTY_Strcasecmp(const char *s0, const char *s1)
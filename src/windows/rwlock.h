@@ -8,36 +8,36 @@
 
 typedef SRWLOCK mty_rwlock;
 
-static void mty_rwlock_create(mty_rwlock *rwlock)
+static inline void mty_rwlock_create(mty_rwlock *rwlock)
 {
 	InitializeSRWLock(rwlock);
 }
 
-static void mty_rwlock_reader(mty_rwlock *rwlock)
+static inline void mty_rwlock_reader(mty_rwlock *rwlock)
 {
 	AcquireSRWLockShared(rwlock);
 }
 
-static bool mty_rwlock_try_reader(mty_rwlock *rwlock)
+static inline bool mty_rwlock_try_reader(mty_rwlock *rwlock)
 {
 	return TryAcquireSRWLockShared(rwlock);
 }
 
-static void mty_rwlock_writer(mty_rwlock *rwlock)
+static inline void mty_rwlock_writer(mty_rwlock *rwlock)
 {
 	AcquireSRWLockExclusive(rwlock);
 }
 
-static void mty_rwlock_unlock_reader(mty_rwlock *rwlock)
+static inline void mty_rwlock_unlock_reader(mty_rwlock *rwlock)
 {
 	ReleaseSRWLockShared(rwlock);
 }
 
-static void mty_rwlock_unlock_writer(mty_rwlock *rwlock)
+static inline void mty_rwlock_unlock_writer(mty_rwlock *rwlock)
 {
 	ReleaseSRWLockExclusive(rwlock);
 }
 
-static void mty_rwlock_destroy(mty_rwlock *rwlock)
+static inline void mty_rwlock_destroy(mty_rwlock *rwlock)
 {
 }
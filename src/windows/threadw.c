@@ -28,6 +28,8 @@ static DWORD WINAPI thread_func(LPVOID *lpParameter)
 	if (ctx->detach)
 		MTY_Free(ctx);
 
+	MTY_ReleaseThreadCache();
+
 	return 0;
 }
 
@@ -94,6 +96,64 @@ int64_t MTY_ThreadGetID(MTY_Thread *ctx)
 	return ctx ? GetThreadId(ctx->thread) : GetCurrentThreadId();
 }
 
+uint32_t MTY_GetNumProcessors(void)
+{
+	SYSTEM_INFO si = {0};
+	GetSystemInfo(&si);
+
+	return si.dwNumberOfProcessors > 0 ? si.dwNumberOfProcessors : 1;
+}
+
+bool MTY_ThreadSetPriority(MTY_Thread *ctx, MTY_ThreadPriority priority)
+{
+	HANDLE thread = ctx ? ctx->thread : GetCurrentThread();
+
+	int32_t p = priority == MTY_THREAD_PRIORITY_LOW ? THREAD_PRIORITY_BELOW_NORMAL :
+		priority == MTY_THREAD_PRIORITY_HIGH ? THREAD_PRIORITY_HIGHEST :
+		priority == MTY_THREAD_PRIORITY_REALTIME ? THREAD_PRIORITY_TIME_CRITICAL :
+		THREAD_PRIORITY_NORMAL;
+
+	if (!SetThreadPriority(thread, p)) {
+		MTY_Log("'SetThreadPriority' failed with error 0x%X", GetLastError());
+		return false;
+	}
+
+	return true;
+}
+
+bool MTY_ThreadSetAffinity(MTY_Thread *ctx, uint64_t mask)
+{
+	HANDLE thread = ctx ? ctx->thread : GetCurrentThread();
+
+	if (!SetThreadAffinityMask(thread, (DWORD_PTR) mask)) {
+		MTY_Log("'SetThreadAffinityMask' failed with error 0x%X", GetLastError());
+		return false;
+	}
+
+	return true;
+}
+
+bool MTY_ThreadSetName(MTY_Thread *ctx, const char *name)
+{
+	// SetThreadDescription is only available on Windows 10 1607 and later
+	HRESULT (WINAPI *_SetThreadDescription)(HANDLE hThread, PCWSTR lpThreadDescription) =
+		(void *) GetProcAddress(GetModuleHandle(L"kernel32.dll"), "SetThreadDescription");
+
+	if (!_SetThreadDescription)
+		return false;
+
+	wchar_t *wname = MTY_MultiToWideD(name);
+	HRESULT e = _SetThreadDescription(ctx ? ctx->thread : GetCurrentThread(), wname);
+	MTY_Free(wname);
+
+	if (e != S_OK) {
+		MTY_Log("'SetThreadDescription' failed with HRESULT 0x%X", e);
+		return false;
+	}
+
+	return true;
+}
+
 
 // Mutex
 
@@ -238,3 +298,86 @@ bool MTY_Atomic64CAS(MTY_Atomic64 *atomic, int64_t oldValue, int64_t newValue)
 {
 	return InterlockedCompareExchange64(&atomic->value, newValue, oldValue) == oldValue;
 }
+
+// Interlocked functions are full barriers, which satisfies every MTY_MemoryOrder
+
+void MTY_Atomic32SetEx(MTY_Atomic32 *atomic, int32_t value, MTY_MemoryOrder order)
+{
+	MTY_Atomic32Set(atomic, value);
+}
+
+void MTY_Atomic64SetEx(MTY_Atomic64 *atomic, int64_t value, MTY_MemoryOrder order)
+{
+	MTY_Atomic64Set(atomic, value);
+}
+
+int32_t MTY_Atomic32GetEx(MTY_Atomic32 *atomic, MTY_MemoryOrder order)
+{
+	return MTY_Atomic32Get(atomic);
+}
+
+int64_t MTY_Atomic64GetEx(MTY_Atomic64 *atomic, MTY_MemoryOrder order)
+{
+	return MTY_Atomic64Get(atomic);
+}
+
+int32_t MTY_Atomic32AddEx(MTY_Atomic32 *atomic, int32_t value, MTY_MemoryOrder order)
+{
+	return MTY_Atomic32Add(atomic, value);
+}
+
+int64_t MTY_Atomic64AddEx(MTY_Atomic64 *atomic, int64_t value, MTY_MemoryOrder order)
+{
+	return MTY_Atomic64Add(atomic, value);
+}
+
+bool MTY_Atomic32CASEx(MTY_Atomic32 *atomic, int32_t oldValue, int32_t newValue,
+	MTY_MemoryOrder order)
+{
+	return MTY_Atomic32CAS(atomic, oldValue, newValue);
+}
+
+bool MTY_Atomic64CASEx(MTY_Atomic64 *atomic, int64_t oldValue, int64_t newValue,
+	MTY_MemoryOrder order)
+{
+	return MTY_Atomic64CAS(atomic, oldValue, newValue);
+}
+
+void MTY_AtomicPtrSet(MTY_AtomicPtr *atomic, void *value, MTY_MemoryOrder order)
+{
+	InterlockedExchangePointer((PVOID volatile *) &atomic->value, value);
+}
+
+void *MTY_AtomicPtrGet(MTY_AtomicPtr *atomic, MTY_MemoryOrder order)
+{
+	return InterlockedCompareExchangePointer((PVOID volatile *) &atomic->value, NULL, NULL);
+}
+
+void *MTY_AtomicPtrExchange(MTY_AtomicPtr *atomic, void *value, MTY_MemoryOrder order)
+{
+	return InterlockedExchangePointer((PVOID volatile *) &atomic->value, value);
+}
+
+bool MTY_AtomicPtrCAS(MTY_AtomicPtr *atomic, void *oldValue, void *newValue,
+	MTY_MemoryOrder order)
+{
+	return InterlockedCompareExchangePointer((PVOID volatile *) &atomic->value, newValue, oldValue) == oldValue;
+}
+
+void *MTY_AtomicPtrOr(MTY_AtomicPtr *atomic, uintptr_t mask, MTY_MemoryOrder order)
+{
+	#if defined(_WIN64)
+		return (void *) InterlockedOr64((volatile LONG64 *) &atomic->value, mask);
+	#else
+		return (void *) InterlockedOr((volatile LONG *) &atomic->value, mask);
+	#endif
+}
+
+void *MTY_AtomicPtrAnd(MTY_AtomicPtr *atomic, uintptr_t mask, MTY_MemoryOrder order)
+{
+	#if defined(_WIN64)
+		return (void *) InterlockedAnd64((volatile LONG64 *) &atomic->value, mask);
+	#else
+		return (void *) InterlockedAnd((volatile LONG *) &atomic->value, mask);
+	#endif
+}
@@ -8,4 +8,5 @@
 
 void *mty_tlocal(size_t size);
 char *mty_tlocal_strcpy(const char *str);
-void mty_tlocal_set_mem(void *buf, size_t size);
+char *mty_tlocal_vsprintf(const char *fmt, va_list args);
+void mty_tlocal_release(void);
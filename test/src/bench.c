@@ -0,0 +1,41 @@
+// This Source Code Form is subject to the terms of the MIT License.
+// If a copy of the MIT License was not distributed with this file,
+// You can obtain one at https://spdx.org/licenses/MIT.html.
+
+#include "matoya.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+// Framework
+#include "bench/bench.h"
+
+/// Modules
+#include "bench/thread.h"
+#include "bench/struct.h"
+#include "bench/json.h"
+
+static void main_log(const char *msg, void *opaque)
+{
+	printf("%s\n", msg);
+}
+
+int32_t main(int32_t argc, char **argv)
+{
+	MTY_SetLogFunc(main_log, NULL);
+
+	printf("Logical processors: %u\n", MTY_GetNumProcessors());
+
+	if (!thread_bench())
+		return 1;
+
+	if (!struct_bench())
+		return 1;
+
+	if (!json_bench())
+		return 1;
+
+	return 0;
+}
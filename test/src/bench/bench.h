@@ -0,0 +1,16 @@
+// This Source Code Form is subject to the terms of the MIT License.
+// If a copy of the MIT License was not distributed with this file,
+// You can obtain one at https://spdx.org/licenses/MIT.html.
+
+#pragma once
+
+static MTY_Time ___BENCH___;
+
+#define bench_begin() \
+	___BENCH___ = MTY_GetTime();
+
+#define bench_end() \
+	MTY_TimeDiff(___BENCH___, MTY_GetTime())
+
+#define bench_print(name, fmt, ...) \
+	printf("[%s] " fmt "\n", name, __VA_ARGS__);
@@ -0,0 +1,45 @@
+// This Source Code Form is subject to the terms of the MIT License.
+// If a copy of the MIT License was not distributed with this file,
+// You can obtain one at https://spdx.org/licenses/MIT.html.
+
+#define bench_json_objects 100000
+
+static bool bench_json_keys(void)
+{
+	// An array of records that all repeat the same key names, some short and some long
+	size_t size = bench_json_objects * 128 + 16;
+	char *doc = MTY_Alloc(size, 1);
+	size_t len = snprintf(doc, size, "[");
+
+	for (uint32_t x = 0; x < bench_json_objects; x++)
+		len += snprintf(doc + len, size - len, "%s{\"id\":%u,\"name\":\"n%u\",\"created_timestamp\":%u,"
+			"\"last_modified_by_user\":\"u%u\"}", x > 0 ? "," : "", x, x, x, x);
+
+	snprintf(doc + len, size - len, "]");
+
+	bench_begin();
+	MTY_JSON *j = MTY_JSONParse(doc);
+	double t_parse = bench_end();
+
+	if (!j)
+		return false;
+
+	bench_begin();
+	MTY_JSONDestroy(&j);
+	double t_destroy = bench_end();
+
+	bench_print("MTY_JSON", "%u objects with repeated keys: parse %.2f ms, destroy %.2f ms",
+		bench_json_objects, t_parse, t_destroy);
+
+	MTY_Free(doc);
+
+	return true;
+}
+
+static bool json_bench(void)
+{
+	if (!bench_json_keys())
+		return false;
+
+	return true;
+}
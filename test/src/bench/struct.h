@@ -0,0 +1,454 @@
+// This Source Code Form is subject to the terms of the MIT License.
+// If a copy of the MIT License was not distributed with this file,
+// You can obtain one at https://spdx.org/licenses/MIT.html.
+
+#define bench_handoff_iters 20000
+
+struct bench_handoff_data {
+	MTY_Queue *ping;
+	MTY_Queue *pong;
+};
+
+static void *bench_queue_handoff_thread(void *opaque)
+{
+	struct bench_handoff_data *data = (struct bench_handoff_data *) opaque;
+
+	for (uint32_t x = 0; x < bench_handoff_iters; x++) {
+		void *ptr = NULL;
+		MTY_QueuePopPtr(data->ping, -1, &ptr, NULL);
+		MTY_QueuePushPtr(data->pong, ptr, 0);
+	}
+
+	return NULL;
+}
+
+static bool bench_queue_handoff(bool spsc)
+{
+	struct bench_handoff_data data = {0};
+	data.ping = spsc ? MTY_QueueCreateSPSC(8, 0) : MTY_QueueCreate(8, 0);
+	data.pong = spsc ? MTY_QueueCreateSPSC(8, 0) : MTY_QueueCreate(8, 0);
+
+	MTY_Thread *thread = MTY_ThreadCreate(bench_queue_handoff_thread, &data);
+
+	bench_begin();
+
+	for (uint32_t x = 0; x < bench_handoff_iters; x++) {
+		void *ptr = NULL;
+		MTY_QueuePushPtr(data.ping, &data, 0);
+		MTY_QueuePopPtr(data.pong, -1, &ptr, NULL);
+	}
+
+	// Each iteration is a round trip, so two handoffs
+	double t = bench_end();
+
+	bench_print("MTY_Queue", "%s producer/consumer handoff: %.2f us", spsc ? "SPSC" : "MPSC",
+		t * 1000.0 / (bench_handoff_iters * 2));
+
+	MTY_ThreadDestroy(&thread);
+	MTY_QueueDestroy(&data.pong);
+	MTY_QueueDestroy(&data.ping);
+
+	return true;
+}
+
+static bool bench_hash(uint32_t n)
+{
+	// Lookups are sampled so the old chained version finishes at large sizes
+	uint32_t lookups = MTY_MIN(n, 100000);
+
+	char **keys = MTY_Alloc(n, sizeof(char *));
+	for (uint32_t x = 0; x < n; x++) {
+		keys[x] = MTY_Alloc(16, 1);
+		snprintf(keys[x], 16, "key-%u", x);
+	}
+
+	MTY_Hash *h = MTY_HashCreate(0);
+
+	bench_begin();
+	for (uint32_t x = 0; x < n; x++)
+		MTY_HashSet(h, keys[x], keys[x]);
+	double t_set = bench_end();
+
+	bench_begin();
+	for (uint32_t x = 0; x < lookups; x++)
+		if (MTY_HashGet(h, keys[(x * 7919) % n]) != keys[(x * 7919) % n])
+			return false;
+	double t_get = bench_end();
+
+	char miss[16];
+	bench_begin();
+	for (uint32_t x = 0; x < lookups; x++) {
+		snprintf(miss, 16, "miss-%u", x);
+		MTY_HashGet(h, miss);
+	}
+	double t_miss = bench_end();
+
+	bench_begin();
+	for (uint32_t x = 0; x < n; x++)
+		MTY_HashPop(h, keys[x]);
+	double t_pop = bench_end();
+
+	bench_print("MTY_Hash", "%u keys: set %.0f ns, get %.0f ns, miss %.0f ns, pop %.0f ns", n,
+		t_set * 1e6 / n, t_get * 1e6 / lookups, t_miss * 1e6 / lookups, t_pop * 1e6 / n);
+
+	MTY_HashDestroy(&h, NULL);
+
+	for (uint32_t x = 0; x < n; x++)
+		MTY_Free(keys[x]);
+
+	MTY_Free(keys);
+
+	return true;
+}
+
+static bool bench_hash_int(uint32_t n)
+{
+	MTY_Hash *h = MTY_HashCreate(0);
+
+	// Spread the keys out like pointers or device handles
+	bench_begin();
+	for (uint32_t x = 0; x < n; x++)
+		MTY_HashSetInt(h, (int64_t) x * 0x1000, (void *) (uintptr_t) (x + 1));
+	double t_set = bench_end();
+
+	bench_begin();
+	for (uint32_t x = 0; x < n; x++)
+		if (MTY_HashGetInt(h, (int64_t) x * 0x1000) != (void *) (uintptr_t) (x + 1))
+			return false;
+	double t_get = bench_end();
+
+	bench_begin();
+	for (uint32_t x = 0; x < n; x++)
+		MTY_HashGetInt(h, (int64_t) x * 0x1000 + 1);
+	double t_miss = bench_end();
+
+	bench_begin();
+	for (uint32_t x = 0; x < n; x++)
+		MTY_HashPopInt(h, (int64_t) x * 0x1000);
+	double t_pop = bench_end();
+
+	bench_print("MTY_Hash", "%u int keys: set %.0f ns, get %.0f ns, miss %.0f ns, pop %.0f ns", n,
+		t_set * 1e6 / n, t_get * 1e6 / n, t_miss * 1e6 / n, t_pop * 1e6 / n);
+
+	MTY_HashDestroy(&h, NULL);
+
+	return true;
+}
+
+#define bench_stream_items 1000000
+
+static void *bench_queue_stream_thread(void *opaque)
+{
+	MTY_Queue *q = (MTY_Queue *) opaque;
+
+	for (uintptr_t x = 1; x <= bench_stream_items; x++)
+		while (!MTY_QueuePushPtr(q, (void *) x, 0))
+			MTY_Sleep(0);
+
+	return NULL;
+}
+
+static bool bench_queue_stream(bool spsc)
+{
+	MTY_Queue *q = spsc ? MTY_QueueCreateSPSC(1024, 0) : MTY_QueueCreate(1024, 0);
+
+	bench_begin();
+
+	MTY_Thread *thread = MTY_ThreadCreate(bench_queue_stream_thread, q);
+
+	for (uintptr_t x = 1; x <= bench_stream_items; x++) {
+		void *ptr = NULL;
+		MTY_QueuePopPtr(q, -1, &ptr, NULL);
+
+		if (ptr != (void *) x)
+			return false;
+	}
+
+	double t = bench_end();
+
+	bench_print("MTY_Queue", "%s streaming: %.1f ns/item", spsc ? "SPSC" : "MPSC",
+		t * 1000000.0 / bench_stream_items);
+
+	MTY_ThreadDestroy(&thread);
+	MTY_QueueDestroy(&q);
+
+	return true;
+}
+
+#define bench_batch_size 16
+
+static void *bench_queue_batch_thread(void *opaque)
+{
+	MTY_Queue *q = (MTY_Queue *) opaque;
+	void *ptrs[bench_batch_size];
+
+	for (uintptr_t x = 1; x <= bench_stream_items; x += bench_batch_size) {
+		for (uint32_t y = 0; y < bench_batch_size; y++)
+			ptrs[y] = (void *) (x + y);
+
+		for (uint32_t n = 0; n < bench_batch_size;) {
+			uint32_t pushed = MTY_QueuePushPtrMany(q, ptrs + n, NULL, bench_batch_size - n);
+
+			if (pushed == 0)
+				MTY_Sleep(0);
+
+			n += pushed;
+		}
+	}
+
+	return NULL;
+}
+
+static bool bench_queue_batch(void)
+{
+	MTY_Queue *q = MTY_QueueCreate(1024, 0);
+
+	bench_begin();
+
+	MTY_Thread *thread = MTY_ThreadCreate(bench_queue_batch_thread, q);
+
+	for (uintptr_t x = 1; x <= bench_stream_items;) {
+		void *ptrs[bench_batch_size];
+		uint32_t n = MTY_QueuePopPtrMany(q, -1, ptrs, NULL, bench_batch_size);
+
+		for (uint32_t y = 0; y < n; y++, x++)
+			if (ptrs[y] != (void *) x)
+				return false;
+	}
+
+	double t = bench_end();
+
+	bench_print("MTY_Queue", "MPSC streaming, batches of %u: %.1f ns/item", bench_batch_size,
+		t * 1000000.0 / bench_stream_items);
+
+	MTY_ThreadDestroy(&thread);
+	MTY_QueueDestroy(&q);
+
+	return true;
+}
+
+#define bench_mpmc_items 400000
+
+struct bench_mpmc_data {
+	MTY_ConcurrentQueue *q;
+	uint32_t items;
+};
+
+static void *bench_mpmc_producer(void *opaque)
+{
+	struct bench_mpmc_data *data = (struct bench_mpmc_data *) opaque;
+
+	for (uintptr_t x = 1; x <= data->items; x++)
+		MTY_ConcurrentQueuePush(data->q, &x, -1);
+
+	return NULL;
+}
+
+static void *bench_mpmc_consumer(void *opaque)
+{
+	struct bench_mpmc_data *data = (struct bench_mpmc_data *) opaque;
+
+	for (uint32_t x = 0; x < data->items; x++) {
+		void *item = NULL;
+		MTY_ConcurrentQueuePop(data->q, &item, -1);
+	}
+
+	return NULL;
+}
+
+static bool bench_concurrent_queue(void)
+{
+	for (uint32_t p = 1; p <= 4; p *= 2) {
+		for (uint32_t c = 1; c <= 4; c *= 2) {
+			struct bench_mpmc_data pdata = {0};
+			pdata.q = MTY_ConcurrentQueueCreate(1024, 0);
+			pdata.items = bench_mpmc_items / p;
+
+			struct bench_mpmc_data cdata = pdata;
+			cdata.items = bench_mpmc_items / c;
+
+			MTY_Thread *threads[8] = {0};
+
+			bench_begin();
+
+			for (uint32_t x = 0; x < c; x++)
+				threads[x] = MTY_ThreadCreate(bench_mpmc_consumer, &cdata);
+
+			for (uint32_t x = 0; x < p; x++)
+				threads[c + x] = MTY_ThreadCreate(bench_mpmc_producer, &pdata);
+
+			for (uint32_t x = 0; x < c + p; x++)
+				MTY_ThreadDestroy(&threads[x]);
+
+			double t = bench_end();
+
+			bench_print("MTY_ConcurrentQueue", "%u producers x %u consumers: %.1f ns/item", p, c,
+				t * 1000000.0 / bench_mpmc_items);
+
+			MTY_ConcurrentQueueDestroy(&pdata.q);
+		}
+	}
+
+	return true;
+}
+
+#define bench_chash_ms   100
+#define bench_chash_keys 65536
+
+struct bench_chash_data {
+	MTY_ConcurrentHash *chash;
+	MTY_Hash *hash;
+	MTY_RWLock *rwlock;
+	MTY_Atomic32 seed;
+	MTY_Atomic32 run;
+	MTY_Atomic64 ops;
+	MTY_Atomic64 sum;
+};
+
+static void bench_chash_read(void *value, void *opaque)
+{
+	*(uintptr_t *) opaque += (uintptr_t) value;
+}
+
+static void *bench_chash_thread(void *opaque)
+{
+	struct bench_chash_data *data = (struct bench_chash_data *) opaque;
+
+	uint64_t r = MTY_Atomic32Add(&data->seed, 1) * 0x9E3779B97F4A7C15;
+	uintptr_t sum = 0;
+	int64_t ops = 0;
+
+	while (MTY_Atomic32Get(&data->run)) {
+		for (uint32_t x = 0; x < 1000; x++) {
+			r ^= r << 13;
+			r ^= r >> 7;
+			r ^= r << 17;
+
+			int64_t key = r % bench_chash_keys;
+			bool write = (r >> 32) % 10 == 0;
+
+			// 90% reads, 10% overwrites
+			if (data->chash) {
+				if (write) {
+					MTY_ConcurrentHashSetInt(data->chash, key, (void *) (uintptr_t) (key + 1));
+
+				} else {
+					MTY_ConcurrentHashReadInt(data->chash, key, bench_chash_read, &sum);
+				}
+
+			} else {
+				if (write) {
+					MTY_RWLockWriter(data->rwlock);
+					MTY_HashSetInt(data->hash, key, (void *) (uintptr_t) (key + 1));
+					MTY_RWLockUnlock(data->rwlock);
+
+				} else {
+					MTY_RWLockReader(data->rwlock);
+					sum += (uintptr_t) MTY_HashGetInt(data->hash, key);
+					MTY_RWLockUnlock(data->rwlock);
+				}
+			}
+		}
+
+		ops += 1000;
+	}
+
+	// Keep the reads from being optimized away
+	MTY_Atomic64Add(&data->sum, sum);
+	MTY_Atomic64Add(&data->ops, ops);
+
+	return NULL;
+}
+
+static double bench_chash_run(struct bench_chash_data *data, uint32_t num_threads)
+{
+	MTY_Atomic32Set(&data->run, 1);
+	MTY_Atomic64Set(&data->ops, 0);
+
+	MTY_Thread **threads = MTY_Alloc(num_threads, sizeof(MTY_Thread *));
+
+	for (uint32_t x = 0; x < num_threads; x++)
+		threads[x] = MTY_ThreadCreate(bench_chash_thread, data);
+
+	MTY_Sleep(bench_chash_ms);
+	MTY_Atomic32Set(&data->run, 0);
+
+	for (uint32_t x = 0; x < num_threads; x++)
+		MTY_ThreadDestroy(&threads[x]);
+
+	MTY_Free(threads);
+
+	return MTY_Atomic64Get(&data->ops) / (bench_chash_ms * 1000.0);
+}
+
+static bool bench_concurrent_hash(void)
+{
+	struct bench_chash_data locked = {0};
+	locked.hash = MTY_HashCreate(bench_chash_keys);
+	locked.rwlock = MTY_RWLockCreate();
+
+	struct bench_chash_data sharded = {0};
+	sharded.chash = MTY_ConcurrentHashCreate(bench_chash_keys);
+
+	for (int64_t x = 0; x < bench_chash_keys; x++) {
+		MTY_HashSetInt(locked.hash, x, (void *) (uintptr_t) (x + 1));
+		MTY_ConcurrentHashSetInt(sharded.chash, x, (void *) (uintptr_t) (x + 1));
+	}
+
+	for (uint32_t x = 1; x <= MTY_MAX(MTY_GetNumProcessors(), 8); x *= 2) {
+		double l = bench_chash_run(&locked, x);
+		double c = bench_chash_run(&sharded, x);
+
+		bench_print("MTY_ConcurrentHash", "%2u threads: %6.2f Mops/s, MTY_Hash + MTY_RWLock %6.2f Mops/s",
+			x, c, l);
+	}
+
+	MTY_ConcurrentHashDestroy(&sharded.chash, NULL);
+	MTY_RWLockDestroy(&locked.rwlock);
+	MTY_HashDestroy(&locked.hash, NULL);
+
+	return true;
+}
+
+static bool struct_bench(void)
+{
+	if (!bench_queue_handoff(false))
+		return false;
+
+	if (!bench_queue_handoff(true))
+		return false;
+
+	if (!bench_queue_stream(false))
+		return false;
+
+	if (!bench_queue_stream(true))
+		return false;
+
+	if (!bench_queue_batch())
+		return false;
+
+	if (!bench_concurrent_queue())
+		return false;
+
+	if (!bench_concurrent_hash())
+		return false;
+
+	// Before the string benchmarks, which leave the allocator with a million
+	// small free chunks to consolidate
+	if (!bench_hash_int(1000))
+		return false;
+
+	if (!bench_hash_int(1000000))
+		return false;
+
+	if (!bench_hash(1000))
+		return false;
+
+	if (!bench_hash(100000))
+		return false;
+
+	if (!bench_hash(1000000))
+		return false;
+
+	return true;
+}
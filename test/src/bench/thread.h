@@ -0,0 +1,190 @@
+// This Source Code Form is subject to the terms of the MIT License.
+// If a copy of the MIT License was not distributed with this file,
+// You can obtain one at https://spdx.org/licenses/MIT.html.
+
+#define bench_parallel_len   4096
+#define bench_parallel_iters 20000
+
+static void bench_parallel_for_func(int64_t begin, int64_t end, void *opaque)
+{
+	uint64_t *values = (uint64_t *) opaque;
+
+	for (int64_t x = begin; x < end; x++) {
+		uint64_t v = x + 1;
+
+		for (uint32_t y = 0; y < bench_parallel_iters; y++) {
+			v ^= v << 13;
+			v ^= v >> 7;
+			v ^= v << 17;
+		}
+
+		values[x] = v;
+	}
+}
+
+static bool bench_parallel_for(void)
+{
+	uint64_t *values = calloc(bench_parallel_len, sizeof(uint64_t));
+	uint32_t num_cpu = MTY_GetNumProcessors();
+
+	// Warm up the scheduler so thread creation is not measured
+	MTY_ParallelFor(0, bench_parallel_len, 1, bench_parallel_for_func, values);
+
+	bench_begin();
+	bench_parallel_for_func(0, bench_parallel_len, values);
+	double serial = bench_end();
+
+	bench_print("Serial", "%.2f ms", serial);
+
+	// Splitting into N equal pieces caps the parallelism at N threads
+	for (uint32_t x = 1; x < num_cpu * 2; x *= 2) {
+		int64_t grain = bench_parallel_len / x;
+
+		bench_begin();
+		MTY_ParallelFor(0, bench_parallel_len, grain, bench_parallel_for_func, values);
+		double t = bench_end();
+
+		bench_print("MTY_ParallelFor", "%2u pieces: %.2f ms (%.2fx)", x, t, serial / t);
+	}
+
+	free(values);
+
+	return true;
+}
+
+#define bench_pool_tasks  512
+#define bench_pool_rounds 100
+
+static void bench_thread_pool_func(void *opaque)
+{
+}
+
+static bool bench_thread_pool(void)
+{
+	MTY_ThreadPool *pool = MTY_ThreadPoolCreateQueued(4, bench_pool_tasks - 4);
+	uint32_t *index = calloc(bench_pool_tasks, sizeof(uint32_t));
+
+	double dispatch = 0;
+	double poll = 0;
+	uint64_t polls = 0;
+
+	for (uint32_t x = 0; x < bench_pool_rounds; x++) {
+		bench_begin();
+
+		for (uint32_t y = 0; y < bench_pool_tasks; y++)
+			index[y] = MTY_ThreadPoolDispatch(pool, bench_thread_pool_func, NULL);
+
+		dispatch += bench_end();
+
+		// Poll every outstanding task like a UI thread would each frame
+		for (uint32_t remaining = bench_pool_tasks; remaining > 0;) {
+			remaining = 0;
+
+			MTY_Time begin = MTY_GetTime();
+
+			for (uint32_t y = 0; y < bench_pool_tasks; y++) {
+				void *opaque = NULL;
+				if (MTY_ThreadPoolPoll(pool, index[y], &opaque) == MTY_ASYNC_CONTINUE)
+					remaining++;
+			}
+
+			poll += MTY_TimeDiff(begin, MTY_GetTime());
+			polls += bench_pool_tasks;
+		}
+
+		for (uint32_t y = 0; y < bench_pool_tasks; y++)
+			MTY_ThreadPoolDetach(pool, index[y], NULL);
+	}
+
+	uint32_t n = bench_pool_tasks * bench_pool_rounds;
+	bench_print("MTY_ThreadPoolDispatch", "%u tasks in flight: %.1f ns/dispatch", bench_pool_tasks,
+		dispatch * 1000000.0 / n);
+	bench_print("MTY_ThreadPoolPoll", "%u tasks in flight: %.1f ns/poll", bench_pool_tasks,
+		poll * 1000000.0 / polls);
+
+	MTY_ThreadPoolDestroy(&pool, NULL);
+	free(index);
+
+	return true;
+}
+
+#define bench_rwlock_ms 100
+
+struct bench_rwlock_data {
+	MTY_RWLock *rwlock;
+	MTY_Atomic32 run;
+	MTY_Atomic64 ops;
+};
+
+static void *bench_rwlock_reader(void *opaque)
+{
+	struct bench_rwlock_data *data = (struct bench_rwlock_data *) opaque;
+	int64_t ops = 0;
+
+	while (MTY_Atomic32Get(&data->run)) {
+		for (uint32_t x = 0; x < 1000; x++) {
+			MTY_RWLockReader(data->rwlock);
+			MTY_RWLockUnlock(data->rwlock);
+		}
+
+		ops += 1000;
+	}
+
+	MTY_Atomic64Add(&data->ops, ops);
+
+	return NULL;
+}
+
+static double bench_rwlock_run(MTY_RWLock *rwlock, uint32_t num_threads)
+{
+	struct bench_rwlock_data data = {0};
+	data.rwlock = rwlock;
+	MTY_Atomic32Set(&data.run, 1);
+
+	MTY_Thread **threads = calloc(num_threads, sizeof(MTY_Thread *));
+
+	for (uint32_t x = 0; x < num_threads; x++)
+		threads[x] = MTY_ThreadCreate(bench_rwlock_reader, &data);
+
+	MTY_Sleep(bench_rwlock_ms);
+	MTY_Atomic32Set(&data.run, 0);
+
+	for (uint32_t x = 0; x < num_threads; x++)
+		MTY_ThreadDestroy(&threads[x]);
+
+	free(threads);
+
+	return MTY_Atomic64Get(&data.ops) / (bench_rwlock_ms * 1000.0);
+}
+
+static bool bench_rwlock(void)
+{
+	MTY_RWLock *normal = MTY_RWLockCreate();
+	MTY_RWLock *biased = MTY_RWLockCreateBiased();
+
+	for (uint32_t x = 1; x <= 64; x *= 2) {
+		double n = bench_rwlock_run(normal, x);
+		double b = bench_rwlock_run(biased, x);
+
+		bench_print("MTY_RWLockReader", "%2u threads: %8.2f Mops/s, biased %8.2f Mops/s", x, n, b);
+	}
+
+	MTY_RWLockDestroy(&biased);
+	MTY_RWLockDestroy(&normal);
+
+	return true;
+}
+
+static bool thread_bench(void)
+{
+	if (!bench_parallel_for())
+		return false;
+
+	if (!bench_thread_pool())
+		return false;
+
+	if (!bench_rwlock())
+		return false;
+
+	return true;
+}
@@ -0,0 +1,34 @@
+// This Source Code Form is subject to the terms of the MIT License.
+// If a copy of the MIT License was not distributed with this file,
+// You can obtain one at https://spdx.org/licenses/MIT.html.
+
+#include "matoya.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+// Framework
+#include "test/test.h"
+
+/// Modules
+#include "test/stats.h"
+
+static void main_log(const char *msg, void *opaque)
+{
+	printf("%s\n", msg);
+}
+
+int32_t main(int32_t argc, char **argv)
+{
+	// Every allocation must go through the statistics layer, so this comes first
+	MTY_EnableMemoryStats();
+
+	MTY_SetLogFunc(main_log, NULL);
+
+	if (!stats_main())
+		return 1;
+
+	return 0;
+}
@@ -101,6 +101,51 @@ static bool memory_printf(void)
 	return true;
 }
 
+struct memory_counts {
+	uint32_t allocs;
+	uint32_t frees;
+};
+
+static void *memory_count_alloc(size_t size, bool zero, void *opaque)
+{
+	((struct memory_counts *) opaque)->allocs++;
+
+	return zero ? calloc(1, size) : malloc(size > 0 ? size : 1);
+}
+
+static void *memory_count_realloc(void *mem, size_t size, void *opaque)
+{
+	return realloc(mem, size);
+}
+
+static void memory_count_free(void *mem, void *opaque)
+{
+	if (mem)
+		((struct memory_counts *) opaque)->frees++;
+
+	free(mem);
+}
+
+#define MEMORY_POOL_OBJS 200
+
+static void *memory_pool_thread(void *opaque)
+{
+	MTY_Pool *pool = opaque;
+	void *objs[MEMORY_POOL_OBJS];
+
+	for (uint32_t x = 0; x < MEMORY_POOL_OBJS; x++) {
+		objs[x] = MTY_PoolAlloc(pool);
+		memset(objs[x], 0xAA, 24);
+	}
+
+	// Half are handed back to the creating thread, the rest stay cached here until
+	// the thread exits
+	for (uint32_t x = 0; x < MEMORY_POOL_OBJS / 2; x++)
+		MTY_PoolFree(pool, objs[x]);
+
+	return objs[MEMORY_POOL_OBJS / 2];
+}
+
 static bool memory_main(void)
 {
 	bool failed = false;
@@ -148,6 +193,170 @@ static bool memory_main(void)
 		test_cmp("MTY_AllocAligned", !failed);
 	}
 
+	uint8_t *ubuf = MTY_AllocUninit(1024 * 1024, 1);
+	ubuf[1024 * 1024 - 1] = 1;
+	test_cmp("MTY_AllocUninit", ubuf != NULL);
+	MTY_Free(ubuf);
+
+	// Counting hooks that still use the C library, so memory allocated before
+	// they are set can still be freed through them
+	struct memory_counts counts = {0};
+	MTY_Allocator counter = {0};
+	counter.alloc = memory_count_alloc;
+	counter.realloc = memory_count_realloc;
+	counter.free = memory_count_free;
+	counter.opaque = &counts;
+
+	MTY_SetAllocator(&counter);
+	test_cmp("MTY_GetAllocator", MTY_GetAllocator() && MTY_GetAllocator()->opaque == &counts);
+
+	MTY_Free(MTY_Alloc(1, 100));
+	MTY_Free(MTY_Strdup("hooked"));
+	MTY_FreeAligned(MTY_AllocAligned(64, 64));
+
+	MTY_SetAllocator(NULL);
+	test_cmp("MTY_SetAllocator", counts.allocs == 2 && counts.frees == 2 && !MTY_GetAllocator());
+
+	// Statistics must be enabled before anything else, see the stats target
+	test_cmp("MTY_SetMemoryTag (Disabled)", !MTY_SetMemoryTag("test") && !MTY_GetMemoryStatsJSON());
+
+	const MTY_Allocator *tcache = MTY_GetThreadCacheAllocator();
+	uint8_t *tc0 = tcache->alloc(100, true, tcache->opaque);
+	tc0[99] = 0xAB;
+	tcache->free(tc0, tcache->opaque);
+
+	uint8_t *tc1 = tcache->alloc(120, true, tcache->opaque);
+	test_cmp("MTY_GetThreadCacheAllocator (Reuse)", tc1 == tc0 && tc1[99] == 0);
+
+	tc1[0] = 0xCD;
+	tc1 = tcache->realloc(tc1, 128, tcache->opaque);
+	test_cmp("MTY_GetThreadCacheAllocator (Realloc)", tc1 == tc0 && tc1[0] == 0xCD);
+
+	tc1 = tcache->realloc(tc1, 100000, tcache->opaque);
+	tc1[99999] = 0xEF;
+	test_cmp("MTY_GetThreadCacheAllocator (Large)", tc1 != tc0 && tc1[0] == 0xCD);
+
+	tc1 = tcache->realloc(tc1, 200000, tcache->opaque);
+	test_cmp("MTY_GetThreadCacheAllocator (Large Realloc)", tc1[0] == 0xCD && tc1[99999] == 0xEF);
+	tcache->free(tc1, tcache->opaque);
+
+	MTY_ReleaseThreadCache();
+	tc1 = tcache->alloc(100, false, tcache->opaque);
+	test_cmp("MTY_ReleaseThreadCache", tc1 != NULL);
+	tcache->free(tc1, tcache->opaque);
+	MTY_ReleaseThreadCache();
+
+	MTY_Arena *arena = MTY_ArenaCreate(1024);
+	test_cmp("MTY_ArenaCreate", arena != NULL);
+
+	uint8_t *abuf = MTY_ArenaAlloc(arena, 100, 1);
+	uint8_t *abuf2 = MTY_ArenaAlloc(arena, 100, 1);
+	test_cmp("MTY_ArenaAlloc", abuf && abuf2 > abuf && (uintptr_t) abuf2 % 16 == 0 && abuf2[99] == 0);
+
+	uint8_t *aaligned = MTY_ArenaAllocAligned(arena, 10, 256);
+	test_cmp("MTY_ArenaAllocAligned", (uintptr_t) aaligned % 256 == 0);
+
+	MTY_ArenaMark amark = MTY_ArenaGetMark(arena);
+
+	char *astr = MTY_ArenaStrdup(arena, "arena");
+	test_cmp("MTY_ArenaStrdup", !strcmp(astr, "arena"));
+
+	bool azeroed = true;
+	uint8_t *alarge = MTY_ArenaAlloc(arena, 4096, 1);
+	for (size_t x = 0; x < 4096; x++)
+		azeroed = azeroed && alarge[x] == 0;
+
+	test_cmp("MTY_ArenaAlloc (Large)", azeroed);
+
+	memset(alarge, 0xFF, 4096);
+	MTY_ArenaReset(arena, &amark);
+	test_cmp("MTY_ArenaReset (Mark)", MTY_ArenaStrdup(arena, "arena") == astr);
+
+	MTY_ArenaReset(arena, NULL);
+	test_cmp("MTY_ArenaReset", MTY_ArenaAlloc(arena, 100, 1) == abuf && abuf[0] == 0);
+
+	alarge = MTY_ArenaAlloc(arena, 4096, 1);
+	azeroed = true;
+	for (size_t x = 0; x < 4096; x++)
+		azeroed = azeroed && alarge[x] == 0;
+
+	test_cmp("MTY_ArenaAlloc (Reused)", azeroed);
+
+	MTY_ArenaDestroy(&arena);
+	test_cmp("MTY_ArenaDestroy", arena == NULL);
+
+	const char *tl_outer = MTY_SprintfDL("outer %d", 1);
+	MTY_ThreadLocalMark tl_mark = MTY_ThreadLocalPush();
+
+	bool tl_stable = true;
+	const char *tl_strs[1000];
+	for (int32_t x = 0; x < 1000; x++)
+		tl_strs[x] = MTY_SprintfDL("scoped string number %d", x);
+
+	for (int32_t x = 0; x < 1000; x++)
+		tl_stable = tl_stable && !strcmp(tl_strs[x], MTY_SprintfDL("scoped string number %d", x));
+
+	test_cmp("MTY_ThreadLocalPush", tl_stable && !strcmp(tl_outer, "outer 1"));
+
+	MTY_ThreadLocalMark tl_inner = MTY_ThreadLocalPush();
+	const char *tl_small = MTY_SprintfDL("%s", "small");
+	const char *tl_large = MTY_SprintfDL("%0100000d", 7);
+	test_cmp("MTY_ThreadLocalPush (Large)", strlen(tl_large) == 100000 && tl_large[99999] == '7');
+
+	MTY_ThreadLocalPop(&tl_inner);
+	test_cmp("MTY_ThreadLocalPop (Nested)", MTY_SprintfDL("%s", "x") == tl_small &&
+		!strcmp(tl_strs[999], "scoped string number 999"));
+
+	MTY_ThreadLocalPop(&tl_mark);
+	test_cmp("MTY_ThreadLocalPop", MTY_SprintfDL("%s", "y") == tl_strs[0] && !strcmp(tl_outer, "outer 1"));
+
+	// Outside of a scope results chained into the next call survive the stack wrapping
+	bool tl_wrapped = true;
+	for (int32_t x = 0; x < 100; x++) {
+		const char *tl_path = MTY_JoinPath(MTY_SprintfDL("%0500d", x), "name");
+		tl_wrapped = tl_wrapped && strlen(tl_path) == 505 && !strcmp(tl_path + 501, "name");
+	}
+
+	test_cmp("MTY_SprintfDL (Wrap)", tl_wrapped && strlen(MTY_SprintfDL("%020000d", 1)) == 20000);
+
+	MTY_Pool *pool = MTY_PoolCreate(24);
+	test_cmp("MTY_PoolCreate", pool != NULL);
+
+	uint8_t *pobj = MTY_PoolAlloc(pool);
+	uint8_t *pobj2 = MTY_PoolAlloc(pool);
+	test_cmp("MTY_PoolAlloc", pobj != pobj2 && (uintptr_t) pobj % 16 == 0 && (uintptr_t) pobj2 % 16 == 0);
+
+	memset(pobj, 0xFF, 24);
+	MTY_PoolFree(pool, pobj);
+	MTY_PoolFree(pool, NULL);
+
+	bool pzeroed = true;
+	uint8_t *pobj3 = MTY_PoolAlloc(pool);
+	for (size_t x = 0; x < 24; x++)
+		pzeroed = pzeroed && pobj3[x] == 0;
+
+	test_cmp("MTY_PoolFree", pobj3 == pobj && pzeroed);
+
+	MTY_Thread *pthread = MTY_ThreadCreate(memory_pool_thread, pool);
+	uint8_t *pthread_obj = MTY_ThreadDestroy(&pthread);
+	test_cmp("MTY_PoolAlloc (Thread)", pthread_obj && pthread_obj[23] == 0xAA);
+
+	MTY_PoolFree(pool, pthread_obj);
+
+	bool pdistinct = true;
+	uint8_t *pobjs[MEMORY_POOL_OBJS * 2];
+	for (uint32_t x = 0; x < MEMORY_POOL_OBJS * 2; x++) {
+		pobjs[x] = MTY_PoolAlloc(pool);
+		pdistinct = pdistinct && pobjs[x] != pobj2 && pobjs[x] != pobj3 && pobjs[x][23] == 0;
+		pobjs[x][23] = 1;
+	}
+
+	test_cmp("MTY_PoolAlloc (Reuse)", pdistinct);
+
+	// Objects still allocated are released along with the pool
+	MTY_PoolDestroy(&pool);
+	test_cmp("MTY_PoolDestroy", pool == NULL);
+
 	uint8_t *test_buf = (uint8_t *) MTY_Alloc(1,128);
 	for (size_t x = 0; x < 128; x++) {
 		test_buf[x] = (uint8_t) x;
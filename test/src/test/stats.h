@@ -0,0 +1,80 @@
+// This Source Code Form is subject to the terms of the MIT License.
+// If a copy of the MIT License was not distributed with this file,
+// You can obtain one at https://spdx.org/licenses/MIT.html.
+
+// MTY_EnableMemoryStats must have been called before anything else in the process
+
+static bool stats_main(void)
+{
+	MTY_MemoryStats stats0 = {0};
+	test_cmp("MTY_EnableMemoryStats", MTY_GetMemoryStats(NULL, &stats0));
+
+	const char *prev = MTY_SetMemoryTag("test");
+	test_cmp("MTY_SetMemoryTag", prev == NULL);
+
+	void *buf = MTY_Alloc(1, 1000);
+	void *buf2 = MTY_Realloc(MTY_AllocUninit(1, 10), 1, 3000);
+	MTY_SetMemoryTag(prev);
+
+	MTY_MemoryStats stats1 = {0};
+	MTY_GetMemoryStats(NULL, &stats1);
+	test_cmp("MTY_GetMemoryStats", stats1.liveBytes - stats0.liveBytes == 4000 &&
+		stats1.allocCount - stats0.allocCount == 2);
+
+	MTY_MemoryStats tag = {0};
+	test_cmp("MTY_GetMemoryStats (Tag)", MTY_GetMemoryStats("test", &tag) &&
+		tag.liveCount == 2 && tag.liveBytes == 4000);
+	test_cmp("MTY_GetMemoryStats (Histogram)", tag.histogram[6] == 1 && tag.histogram[0] == 1);
+	test_cmp("MTY_GetMemoryStats (Unknown)", !MTY_GetMemoryStats("unknown", &tag));
+
+	MTY_Free(buf);
+	MTY_Free(buf2);
+
+	MTY_GetMemoryStats("test", &tag);
+	test_cmp("MTY_GetMemoryStats (Freed)", tag.liveBytes == 0 && tag.freeCount == 2 &&
+		tag.peakBytes == 4000);
+
+	MTY_JSON *parsed = MTY_JSONParse("{\"a\": [1, 2, 3], \"b\": \"str\"}");
+
+	MTY_MemoryStats json = {0};
+	test_cmp("MTY_GetMemoryStats (Module)", MTY_GetMemoryStats("json", &json) && json.liveBytes > 0);
+
+	MTY_JSONDestroy(&parsed);
+
+	// Slabs go back to the system once their objects are freed, apart from one kept for reuse
+	MTY_SetMemoryTag("pool");
+	MTY_Pool *pool = MTY_PoolCreate(64);
+	void **pobjs = MTY_Alloc(10000, sizeof(void *));
+
+	for (uint32_t x = 0; x < 10000; x++)
+		pobjs[x] = MTY_PoolAlloc(pool);
+
+	MTY_MemoryStats pstats = {0};
+	MTY_GetMemoryStats("pool", &pstats);
+	bool grown = pstats.liveBytes > 10000 * 64;
+
+	for (uint32_t x = 0; x < 10000; x++)
+		MTY_PoolFree(pool, pobjs[x]);
+
+	MTY_Free(pobjs);
+	MTY_ReleaseThreadCache();
+	MTY_SetMemoryTag(prev);
+
+	MTY_GetMemoryStats("pool", &pstats);
+	test_cmp("MTY_PoolFree (Slabs)", grown && pstats.liveBytes < 1024 * 64 + 4096);
+
+	MTY_PoolDestroy(&pool);
+	MTY_GetMemoryStats("pool", &pstats);
+	test_cmp("MTY_PoolDestroy", pstats.liveBytes == 0);
+
+	MTY_JSON *dump = MTY_GetMemoryStatsJSON();
+	const MTY_JSON *jtag = MTY_JSONObjGetItem(MTY_JSONObjGetItem(dump, "tags"), "test");
+
+	double peak = 0;
+	MTY_JSONNumber(MTY_JSONObjGetItem(jtag, "peakBytes"), &peak);
+	test_cmp("MTY_GetMemoryStatsJSON", peak == 4000 && MTY_JSONObjGetItem(dump, "total"));
+
+	MTY_JSONDestroy(&dump);
+
+	return true;
+}
@@ -19,6 +19,140 @@ static void* struct_thread(void* opaque)
 };
 */
 
+#define struct_chash_threads 4
+#define struct_chash_keys    1000
+
+struct struct_chash_data {
+	MTY_ConcurrentHash *chash;
+	MTY_Atomic32 index;
+	MTY_Atomic32 errors;
+};
+
+static void struct_chash_read(void *value, void *opaque)
+{
+	*(void **) opaque = value;
+}
+
+static void *struct_chash_thread(void *opaque)
+{
+	struct struct_chash_data *data = (struct struct_chash_data *) opaque;
+	int64_t base = (MTY_Atomic32Add(&data->index, 1) - 1) * struct_chash_keys;
+
+	for (int64_t x = base; x < base + struct_chash_keys; x++)
+		MTY_ConcurrentHashSetInt(data->chash, x, (void *) (intptr_t) (x + 1));
+
+	for (int64_t x = base; x < base + struct_chash_keys; x++) {
+		void *value = NULL;
+
+		if (!MTY_ConcurrentHashReadInt(data->chash, x, struct_chash_read, &value) ||
+			value != (void *) (intptr_t) (x + 1))
+			MTY_Atomic32Add(&data->errors, 1);
+	}
+
+	// Remove the odd keys
+	for (int64_t x = base + 1; x < base + struct_chash_keys; x += 2)
+		if (MTY_ConcurrentHashPopInt(data->chash, x) != (void *) (intptr_t) (x + 1))
+			MTY_Atomic32Add(&data->errors, 1);
+
+	return NULL;
+}
+
+#define struct_spsc_items 100000
+
+static void *struct_spsc_thread(void *opaque)
+{
+	MTY_Queue *q = (MTY_Queue *) opaque;
+
+	for (uintptr_t x = 1; x <= struct_spsc_items; x++)
+		while (!MTY_QueuePushPtr(q, (void *) x, x & 0xFF))
+			MTY_Sleep(0);
+
+	return NULL;
+}
+
+#define struct_ring_items 20000
+
+static void *struct_ring_thread(void *opaque)
+{
+	MTY_Queue *q = (MTY_Queue *) opaque;
+
+	for (uint32_t x = 0; x < struct_ring_items; x++) {
+		size_t size = x % 500 + 1;
+		uint8_t *buf = NULL;
+
+		while (!(buf = MTY_QueueReserveInputBuffer(q, size)))
+			MTY_Sleep(0);
+
+		memset(buf, x & 0xFF, size);
+		MTY_QueuePush(q, size);
+	}
+
+	return NULL;
+}
+
+#define struct_triple_items 100000
+
+static void *struct_triple_thread(void *opaque)
+{
+	MTY_TripleBuffer *tb = (MTY_TripleBuffer *) opaque;
+
+	for (uint32_t x = 1; x <= struct_triple_items; x++) {
+		uint32_t *buf = MTY_TripleBufferGetInputBuffer(tb);
+		buf[0] = x;
+		buf[1] = ~x;
+		MTY_TripleBufferPush(tb, x & 0xFF);
+	}
+
+	return NULL;
+}
+
+#define struct_mpmc_threads 4
+#define struct_mpmc_items   20000
+
+struct struct_mpmc_data {
+	MTY_ConcurrentQueue *q;
+	MTY_Atomic32 index;
+	MTY_Atomic64 sum;
+};
+
+static void *struct_mpmc_producer(void *opaque)
+{
+	struct struct_mpmc_data *data = (struct struct_mpmc_data *) opaque;
+	int64_t base = (MTY_Atomic32Add(&data->index, 1) - 1) * struct_mpmc_items;
+
+	for (int64_t x = base + 1; x <= base + struct_mpmc_items; x++)
+		MTY_ConcurrentQueuePush(data->q, &x, -1);
+
+	return NULL;
+}
+
+static void *struct_mpmc_consumer(void *opaque)
+{
+	struct struct_mpmc_data *data = (struct struct_mpmc_data *) opaque;
+	int64_t sum = 0;
+
+	for (uint32_t x = 0; x < struct_mpmc_items; x++) {
+		int64_t item = 0;
+		MTY_ConcurrentQueuePop(data->q, &item, -1);
+		sum += item;
+	}
+
+	MTY_Atomic64Add(&data->sum, sum);
+
+	return NULL;
+}
+
+static bool struct_list_order(MTY_List *list, const char *order)
+{
+	MTY_ListNode *n = MTY_ListGetFirst(list);
+
+	for (; *order; order++, n = n->next)
+		if (!n || (uintptr_t) n->value != (uintptr_t) (*order - '0') || (n->next && n->next->prev != n))
+			return false;
+
+	return !n;
+}
+
 static bool struct_main(void)
 {
 	char stringkey[] = "I'm a test string key!";
@@ -70,6 +204,102 @@ static bool struct_main(void)
 	MTY_HashDestroy(&hashctx, NULL);
 	test_cmp("MTY_HashDestroy", hashctx == NULL);
 
+	// Growth, and removing keys while iterating
+	hashctx = MTY_HashCreate(0);
+
+	for (intptr_t x = 1; x <= 10000; x++)
+		MTY_HashSetInt(hashctx, x, (void *) x);
+
+	bool found = true;
+	for (intptr_t x = 1; x <= 10000; x++)
+		found = found && MTY_HashGetInt(hashctx, x) == (void *) x;
+
+	test_cmp("MTY_HashGetInt (Grow)", found);
+
+	uint32_t popped = 0;
+	iter = 0;
+	for (int64_t key = 0; MTY_HashGetNextKeyInt(hashctx, &iter, &key);)
+		popped += MTY_HashPopInt(hashctx, key) == (void *) (intptr_t) key;
+
+	test_cmp("MTY_HashPopInt (Iter)", popped == 10000);
+	test_cmp("MTY_HashGetInt (Popped)", MTY_HashGetInt(hashctx, 5000) == NULL);
+
+	MTY_HashDestroy(&hashctx, NULL);
+
+	// Integer keys are distinct from strings and cover the full int64 range
+	hashctx = MTY_HashCreate(0);
+
+	MTY_HashSetInt(hashctx, INT64_MIN, stringkey);
+	MTY_HashSetInt(hashctx, -1, intvalue);
+	MTY_HashSet(hashctx, "#1", stringkey);
+	MTY_HashSetInt(hashctx, 1, intvalue);
+
+	test_cmp("MTY_HashGetInt (Min)", MTY_HashGetInt(hashctx, INT64_MIN) == stringkey);
+	test_cmp("MTY_HashGetInt (Neg)", MTY_HashGetInt(hashctx, -1) == intvalue);
+	test_cmp("MTY_HashGet (Int Str)", MTY_HashGet(hashctx, "#1") == stringkey);
+	test_cmp("MTY_HashPopInt (Int Str)", MTY_HashPopInt(hashctx, 1) == intvalue);
+	test_cmp("MTY_HashGet (Int Str Popped)", MTY_HashGet(hashctx, "#1") == stringkey);
+
+	MTY_HashDestroy(&hashctx, NULL);
+
+	// Inline keys on either side of the size limit, and interned keys shared by two hashes
+	hashctx = MTY_HashCreateInterned(0);
+	MTY_Hash *hashctx2 = MTY_HashCreateInterned(0);
+
+	MTY_HashSet(hashctx, "fourteen_chars", intvalue);
+	MTY_HashSet(hashctx, "fifteen_chars__", intvalue);
+	MTY_HashSet(hashctx, stringkey, stringkey);
+	MTY_HashSet(hashctx2, stringkey, intvalue);
+
+	test_cmp("MTY_HashGet (Inline)", MTY_HashGet(hashctx, "fourteen_chars") == intvalue);
+	test_cmp("MTY_HashGet (Interned)", MTY_HashGet(hashctx, "fifteen_chars__") == intvalue);
+
+	const char *ikey1 = NULL;
+	const char *ikey2 = NULL;
+
+	iter = 0;
+	while (MTY_HashGetNextKey(hashctx, &iter, &ikey1) && strcmp(ikey1, stringkey));
+
+	iter = 0;
+	MTY_HashGetNextKey(hashctx2, &iter, &ikey2);
+
+	test_cmp("MTY_HashGetNextKey (Interned)", ikey1 && ikey1 == ikey2);
+
+	MTY_HashDestroy(&hashctx, NULL);
+	test_cmp("MTY_HashGet (Interned Shared)", MTY_HashGet(hashctx2, stringkey) == intvalue);
+	test_cmp("MTY_HashPop (Interned Shared)", MTY_HashPop(hashctx2, stringkey) == intvalue);
+
+	MTY_HashDestroy(&hashctx2, NULL);
+
+	// Concurrent hash shared by several threads
+	struct struct_chash_data cdata = {0};
+	cdata.chash = MTY_ConcurrentHashCreate(0);
+
+	MTY_Thread *cthreads[struct_chash_threads];
+
+	for (uint32_t x = 0; x < struct_chash_threads; x++)
+		cthreads[x] = MTY_ThreadCreate(struct_chash_thread, &cdata);
+
+	for (uint32_t x = 0; x < struct_chash_threads; x++)
+		MTY_ThreadDestroy(&cthreads[x]);
+
+	test_cmp("MTY_ConcurrentHashSetInt", MTY_Atomic32Get(&cdata.errors) == 0);
+
+	bool cfound = true;
+	for (int64_t x = 0; x < struct_chash_threads * struct_chash_keys; x++)
+		cfound = cfound && MTY_ConcurrentHashReadInt(cdata.chash, x, NULL, NULL) == (x % 2 == 0);
+
+	test_cmp("MTY_ConcurrentHashPopInt", cfound);
+
+	MTY_ConcurrentHashSet(cdata.chash, stringkey, intvalue);
+	value = NULL;
+	MTY_ConcurrentHashRead(cdata.chash, stringkey, struct_chash_read, &value);
+	test_cmp("MTY_ConcurrentHashRead", value == intvalue);
+	test_cmp("MTY_ConcurrentHashPop", MTY_ConcurrentHashPop(cdata.chash, stringkey) == intvalue);
+
+	MTY_ConcurrentHashDestroy(&cdata.chash, NULL);
+	test_cmp("MTY_ConcurrentHashDestroy", cdata.chash == NULL);
+
 	MTY_Queue* queuectx = MTY_QueueCreate(2, 4);
 	test_cmp("MTY_QueueCreate", queuectx != NULL);
 
@@ -112,6 +342,222 @@ static bool struct_main(void)
 	MTY_QueueDestroy(&queuectx);
 	test_cmp("MTY_QueueDestroy", queuectx == NULL);
 
+	// Single producer, single consumer ordering across threads
+	queuectx = MTY_QueueCreateSPSC(16, 0);
+	test_cmp("MTY_QueueCreateSPSC", queuectx != NULL);
+
+	MTY_Thread *qthread = MTY_ThreadCreate(struct_spsc_thread, queuectx);
+
+	bool qordered = true;
+	for (uintptr_t x = 1; x <= struct_spsc_items && qordered; x++) {
+		void *ptr = NULL;
+		size_t size = 0;
+
+		qordered = MTY_QueuePopPtr(queuectx, -1, &ptr, &size) && ptr == (void *) x && size == (x & 0xFF);
+	}
+
+	test_cmp("MTY_QueuePopPtr (SPSC)", qordered);
+	test_cmp("MTY_QueuePopPtr (SPSC Empty)", !MTY_QueuePopPtr(queuectx, 1, &value, NULL));
+
+	MTY_ThreadDestroy(&qthread);
+	MTY_QueueDestroy(&queuectx);
+
+	// Batches
+	queuectx = MTY_QueueCreate(8, sizeof(uint32_t));
+
+	uint32_t bvalues[10] = {0};
+	const void *bitems[10] = {0};
+	size_t bsizes[10] = {0};
+
+	for (uint32_t x = 0; x < 10; x++) {
+		bvalues[x] = x + 1;
+		bitems[x] = &bvalues[x];
+		bsizes[x] = sizeof(uint32_t);
+	}
+
+	test_cmp("MTY_QueuePushMany", MTY_QueuePushMany(queuectx, bitems, bsizes, 5) == 5);
+	test_cmp("MTY_QueuePushMany (Full)", MTY_QueuePushMany(queuectx, bitems + 5, bsizes + 5, 5) == 3);
+
+	void *bbufs[8] = {0};
+	size_t bbufsizes[8] = {0};
+	uint32_t bcount = MTY_QueueGetOutputBuffers(queuectx, 0, bbufs, bbufsizes, 6);
+
+	bool bordered = bcount == 6;
+	for (uint32_t x = 0; x < bcount && bordered; x++)
+		bordered = bbufsizes[x] == sizeof(uint32_t) && *(uint32_t *) bbufs[x] == x + 1;
+
+	test_cmp("MTY_QueueGetOutputBuffers", bordered);
+
+	MTY_QueuePopMany(queuectx, bcount);
+	test_cmp("MTY_QueuePopMany", MTY_QueueGetLength(queuectx) == 2);
+
+	bcount = MTY_QueueGetOutputBuffers(queuectx, 0, bbufs, NULL, 8);
+	test_cmp("MTY_QueueGetOutputBuffers (Partial)", bcount == 2 && *(uint32_t *) bbufs[1] == 8);
+
+	MTY_QueuePopMany(queuectx, bcount);
+	test_cmp("MTY_QueueGetOutputBuffers (Empty)", MTY_QueueGetOutputBuffers(queuectx, 1, bbufs, NULL, 8) == 0);
+
+	bsizes[1] = 0;
+	bsizes[3] = 64;
+	test_cmp("MTY_QueuePushMany (Empty Item)", MTY_QueuePushMany(queuectx, bitems, bsizes, 3) == 1);
+	test_cmp("MTY_QueuePushMany (Oversized Item)", MTY_QueuePushMany(queuectx, bitems + 3, bsizes + 3, 2) == 0 &&
+		MTY_QueueGetLength(queuectx) == 1);
+
+	MTY_QueuePopMany(queuectx, MTY_QueueGetOutputBuffers(queuectx, 0, bbufs, NULL, 8));
+
+	void *bptrs[3] = {(void *) 1, (void *) 2, (void *) 3};
+	size_t bptrsizes[3] = {10, 20, 30};
+	test_cmp("MTY_QueuePushPtrMany", MTY_QueuePushPtrMany(queuectx, bptrs, bptrsizes, 3) == 3);
+
+	memset(bptrs, 0, sizeof(bptrs));
+	memset(bptrsizes, 0, sizeof(bptrsizes));
+	bcount = MTY_QueuePopPtrMany(queuectx, 0, bptrs, bptrsizes, 3);
+	test_cmp("MTY_QueuePopPtrMany", bcount == 3 && bptrs[2] == (void *) 3 && bptrsizes[2] == 30);
+
+	MTY_QueueDestroy(&queuectx);
+
+	// Variable length messages sharing one ring
+	queuectx = MTY_QueueCreateRing(16, 512, 1024);
+	test_cmp("MTY_QueueCreateRing", queuectx != NULL);
+
+	uint8_t *rbuf0 = MTY_QueueGetInputBuffer(queuectx);
+	test_cmp("MTY_QueueGetInputBuffer (Ring)", rbuf0 != NULL);
+	memset(rbuf0, 1, 100);
+	MTY_QueuePush(queuectx, 100);
+
+	uint8_t *rbuf = MTY_QueueReserveInputBuffer(queuectx, 400);
+	test_cmp("MTY_QueueReserveInputBuffer", rbuf == rbuf0 + 112);
+	memset(rbuf, 2, 400);
+	MTY_QueuePush(queuectx, 400);
+
+	rbuf = MTY_QueueGetInputBuffer(queuectx);
+	test_cmp("MTY_QueueGetInputBuffer (Ring)", rbuf == rbuf0 + 512);
+	memset(rbuf, 3, 300);
+	MTY_QueuePush(queuectx, 300);
+
+	test_cmp("MTY_QueueReserveInputBuffer (Too Large)", !MTY_QueueReserveInputBuffer(queuectx, 1025));
+	test_cmp("MTY_QueueReserveInputBuffer (Full)", !MTY_QueueReserveInputBuffer(queuectx, 300));
+
+	void *rout = NULL;
+	size_t rsize = 0;
+	MTY_QueueGetOutputBuffer(queuectx, 0, &rout, &rsize);
+	test_cmp("MTY_QueueGetOutputBuffer (Ring)", rout == rbuf0 && rsize == 100);
+	MTY_QueuePop(queuectx);
+
+	test_cmp("MTY_QueueReserveInputBuffer (Full)", !MTY_QueueReserveInputBuffer(queuectx, 300));
+
+	MTY_QueueGetOutputBuffer(queuectx, 0, &rout, &rsize);
+	test_cmp("MTY_QueueGetOutputBuffer (Ring)", rsize == 400 && ((uint8_t *) rout)[399] == 2);
+	MTY_QueuePop(queuectx);
+
+	rbuf = MTY_QueueReserveInputBuffer(queuectx, 300);
+	test_cmp("MTY_QueueReserveInputBuffer (Wrap)", rbuf == rbuf0);
+	memset(rbuf, 4, 300);
+	MTY_QueuePush(queuectx, 300);
+
+	MTY_QueueGetOutputBuffer(queuectx, 0, &rout, &rsize);
+	test_cmp("MTY_QueueGetOutputBuffer (Ring)", rsize == 300 && ((uint8_t *) rout)[299] == 3);
+	MTY_QueuePop(queuectx);
+
+	MTY_QueueGetOutputBuffer(queuectx, 0, &rout, &rsize);
+	test_cmp("MTY_QueueGetOutputBuffer (Wrap)", rsize == 300 && ((uint8_t *) rout)[299] == 4);
+	MTY_QueuePop(queuectx);
+
+	// Only the ring limits a reserved message, `bufSize` is what MTY_QueueGetInputBuffer takes
+	rbuf = MTY_QueueReserveInputBuffer(queuectx, 1000);
+	test_cmp("MTY_QueueReserveInputBuffer (Larger)", rbuf != NULL);
+	memset(rbuf, 5, 1000);
+	MTY_QueuePush(queuectx, 1000);
+
+	MTY_QueueGetOutputBuffer(queuectx, 0, &rout, &rsize);
+	test_cmp("MTY_QueueGetOutputBuffer (Larger)", rsize == 1000 && ((uint8_t *) rout)[999] == 5);
+	MTY_QueuePop(queuectx);
+
+	qthread = MTY_ThreadCreate(struct_ring_thread, queuectx);
+
+	bool rvalid = true;
+	for (uint32_t x = 0; x < struct_ring_items && rvalid; x++) {
+		rvalid = MTY_QueueGetOutputBuffer(queuectx, -1, &rout, &rsize) && rsize == x % 500 + 1;
+
+		for (size_t y = 0; y < rsize && rvalid; y++)
+			rvalid = ((uint8_t *) rout)[y] == (x & 0xFF);
+
+		MTY_QueuePop(queuectx);
+	}
+
+	test_cmp("MTY_QueueGetOutputBuffer (Ring Stream)", rvalid);
+
+	MTY_ThreadDestroy(&qthread);
+	MTY_QueueDestroy(&queuectx);
+
+	// Latest value mailbox
+	MTY_TripleBuffer *tb = MTY_TripleBufferCreate(2 * sizeof(uint32_t));
+	test_cmp("MTY_TripleBufferCreate", tb != NULL);
+
+	uint32_t *tbuf = NULL;
+	size_t tsize = 0;
+	test_cmp("MTY_TripleBufferGetOutputBuffer (Empty)", !MTY_TripleBufferGetOutputBuffer(tb, (void **) &tbuf, &tsize) && !tbuf);
+
+	for (uint32_t x = 1; x <= 3; x++) {
+		tbuf = MTY_TripleBufferGetInputBuffer(tb);
+		tbuf[0] = x;
+		MTY_TripleBufferPush(tb, x);
+	}
+
+	test_cmp("MTY_TripleBufferGetOutputBuffer", MTY_TripleBufferGetOutputBuffer(tb, (void **) &tbuf, &tsize) && tbuf[0] == 3 && tsize == 3);
+	test_cmp("MTY_TripleBufferGetOutputBuffer (Stale)", !MTY_TripleBufferGetOutputBuffer(tb, (void **) &tbuf, &tsize) && tbuf[0] == 3);
+
+	qthread = MTY_ThreadCreate(struct_triple_thread, tb);
+
+	bool tvalid = true;
+	for (uint32_t last = 0; last < struct_triple_items && tvalid;) {
+		if (MTY_TripleBufferGetOutputBuffer(tb, (void **) &tbuf, &tsize)) {
+			tvalid = tbuf[0] > last && tbuf[1] == ~tbuf[0] && tsize == (tbuf[0] & 0xFF);
+			last = tbuf[0];
+		}
+	}
+
+	test_cmp("MTY_TripleBufferPush", tvalid);
+
+	MTY_ThreadDestroy(&qthread);
+	MTY_TripleBufferDestroy(&tb);
+	test_cmp("MTY_TripleBufferDestroy", tb == NULL);
+
+	// Many producers and many consumers
+	struct struct_mpmc_data mdata = {0};
+	mdata.q = MTY_ConcurrentQueueCreate(60, sizeof(int64_t));
+	test_cmp("MTY_ConcurrentQueueCreate", mdata.q != NULL);
+
+	int64_t mitem = 1;
+	bool mfull = true;
+	for (uint32_t x = 0; x < 64; x++)
+		mfull = mfull && MTY_ConcurrentQueuePush(mdata.q, &mitem, 0);
+
+	test_cmp("MTY_ConcurrentQueuePush (Full)", mfull && !MTY_ConcurrentQueuePush(mdata.q, &mitem, 0));
+	test_cmp("MTY_ConcurrentQueuePush (Timeout)", !MTY_ConcurrentQueuePush(mdata.q, &mitem, 5));
+	test_cmp("MTY_ConcurrentQueueGetLength", MTY_ConcurrentQueueGetLength(mdata.q) == 64);
+
+	while (MTY_ConcurrentQueuePop(mdata.q, &mitem, 0))
+		continue;
+
+	test_cmp("MTY_ConcurrentQueuePop (Timeout)", !MTY_ConcurrentQueuePop(mdata.q, &mitem, 5));
+
+	MTY_Thread *mthreads[struct_mpmc_threads * 2];
+
+	for (uint32_t x = 0; x < struct_mpmc_threads; x++) {
+		mthreads[x * 2] = MTY_ThreadCreate(struct_mpmc_consumer, &mdata);
+		mthreads[x * 2 + 1] = MTY_ThreadCreate(struct_mpmc_producer, &mdata);
+	}
+
+	for (uint32_t x = 0; x < struct_mpmc_threads * 2; x++)
+		MTY_ThreadDestroy(&mthreads[x]);
+
+	int64_t mtotal = (int64_t) struct_mpmc_threads * struct_mpmc_items;
+	test_cmp("MTY_ConcurrentQueuePop", MTY_Atomic64Get(&mdata.sum) == mtotal * (mtotal + 1) / 2);
+
+	MTY_ConcurrentQueueDestroy(&mdata.q);
+	test_cmp("MTY_ConcurrentQueueDestroy", mdata.q == NULL);
+
 	MTY_List* listctx = MTY_ListCreate();
 	test_cmp("MTY_ListCreate", listctx != NULL);
 
@@ -122,10 +568,47 @@ static bool struct_main(void)
 	node = MTY_ListGetFirst(listctx);
 	test_cmp("MTY_ListAppend", node != NULL);
 
+	MTY_ListNode *lfreed = node;
 	value = MTY_ListRemove(listctx, node);
 	node = MTY_ListGetFirst(listctx);
 	test_cmp("MTY_ListRemove", value && value == intvalue);
 
+	MTY_ListNode *l2 = MTY_ListAppend(listctx, (void *) 2);
+	test_cmp("MTY_ListAppend (Recycled)", l2 == lfreed);
+	MTY_ListPrepend(listctx, (void *) 1);
+	MTY_ListNode *l4 = MTY_ListAppend(listctx, (void *) 4);
+	MTY_ListInsertBefore(listctx, l4, (void *) 3);
+	MTY_ListInsertAfter(listctx, l4, (void *) 5);
+	test_cmp("MTY_ListInsertBefore", struct_list_order(listctx, "12345"));
+	test_cmp("MTY_ListGetLast", MTY_ListGetLast(listctx)->value == (void *) 5);
+
+	MTY_ListMove(listctx, l4, MTY_ListGetFirst(listctx));
+	test_cmp("MTY_ListMove (Front)", struct_list_order(listctx, "41235"));
+	MTY_ListMove(listctx, l4, NULL);
+	test_cmp("MTY_ListMove (Back)", struct_list_order(listctx, "12354"));
+
+	MTY_List *listctx2 = MTY_ListCreate();
+	MTY_ListAppend(listctx2, (void *) 7);
+	MTY_ListAppend(listctx2, (void *) 8);
+	MTY_ListSplice(listctx, l2, listctx2);
+	test_cmp("MTY_ListSplice", struct_list_order(listctx, "1782354") && !MTY_ListGetFirst(listctx2));
+
+	MTY_ListAppend(listctx2, (void *) 9);
+	MTY_ListSplice(listctx, NULL, listctx2);
+	test_cmp("MTY_ListSplice (End)", struct_list_order(listctx, "17823549"));
+
+	MTY_ListSplice(listctx, NULL, listctx);
+	test_cmp("MTY_ListSplice (Self)", struct_list_order(listctx, "17823549"));
+	MTY_ListDestroy(&listctx2, NULL);
+
+	for (uint32_t x = 0; x < 5000; x++)
+		MTY_ListAppend(listctx, (void *) 0);
+
+	while (MTY_ListGetLast(listctx)->value == (void *) 0)
+		MTY_ListRemove(listctx, MTY_ListGetLast(listctx));
+
+	test_cmp("MTY_ListRemove (Many)", struct_list_order(listctx, "17823549"));
+
 	MTY_ListDestroy(&listctx, NULL);
 	test_cmp("MTY_ListDestroy", listctx == NULL);
 
@@ -3,6 +3,10 @@
 // If a copy of the MIT License was not distributed with this file,
 // You can obtain one at https://spdx.org/licenses/MIT.html.
 
+#if defined(__linux__)
+	#include <poll.h>
+#endif
+
 #define test_thread_count 100
 
 struct test_threadpool_data {
@@ -59,6 +63,118 @@ static bool test_threadpools()
 	return true;
 }
 
+static bool test_threadpools_queued()
+{
+	struct test_threadpool_data data = {0};
+	data.cond = MTY_CondCreate();
+	data.mutex = MTY_MutexCreate();
+	data.pool = MTY_ThreadPoolCreateQueued(2, 8);
+
+	test_cmp("MTY_ThreadPoolCreateQueued", data.pool != NULL);
+
+	uint32_t index[10] = {0};
+	bool dispatched = true;
+
+	for (int32_t i = 0; i < 10; i++) {
+		index[i] = MTY_ThreadPoolDispatch(data.pool, test_threadpools_thread, &data);
+		dispatched = dispatched && index[i] != 0;
+	}
+
+	test_cmp("MTY_ThreadPoolDispatch (Queued)", dispatched);
+	test_cmp("MTY_ThreadPoolDispatch (Full)", MTY_ThreadPoolDispatch(data.pool, test_threadpools_thread, &data) == 0);
+
+	for (int32_t i = 0; i < 10; i++) {
+		void *opaque = NULL;
+
+		while (MTY_ThreadPoolPoll(data.pool, index[i], &opaque) == MTY_ASYNC_CONTINUE) {
+			MTY_MutexLock(data.mutex);
+			MTY_CondSignalAll(data.cond);
+			MTY_MutexUnlock(data.mutex);
+			MTY_Sleep(1);
+		}
+
+		MTY_ThreadPoolDetach(data.pool, index[i], NULL);
+	}
+
+	test_cmp("MTY_ThreadPoolPoll", MTY_Atomic32Get(&data.atomic_32) == 10);
+
+	MTY_ThreadPoolDestroy(&data.pool, test_threadpools_detach);
+	test_cmp("MTY_ThreadPoolDestroy", data.pool == NULL);
+	test_cmp("MTY_Atomic32Get", MTY_Atomic32Get(&data.atomic_32_detach) == 0);
+
+	MTY_CondDestroy(&data.cond);
+	MTY_MutexDestroy(&data.mutex);
+
+	return true;
+}
+
+#define test_parallel_count 10000
+
+static void test_parallel_for_func(int64_t begin, int64_t end, void *opaque)
+{
+	int64_t *values = (int64_t *) opaque;
+
+	for (int64_t x = begin; x < end; x++)
+		values[x] += x;
+}
+
+static void test_task_group_func(void *opaque)
+{
+	MTY_Atomic32Add((MTY_Atomic32 *) opaque, 1);
+}
+
+static void test_task_group_nested(void *opaque)
+{
+	MTY_ParallelFor(0, test_parallel_count, 64, test_parallel_for_func, opaque);
+}
+
+static void test_parallel_for_width(int64_t begin, int64_t end, void *opaque)
+{
+	MTY_Atomic64Add((MTY_Atomic64 *) opaque, (int64_t) ((uint64_t) end - (uint64_t) begin));
+}
+
+static bool test_task_groups()
+{
+	int64_t *values = calloc(test_parallel_count, sizeof(int64_t));
+
+	MTY_ParallelFor(0, test_parallel_count, 16, test_parallel_for_func, values);
+
+	bool ok = true;
+	for (int64_t x = 0; x < test_parallel_count; x++)
+		ok = ok && values[x] == x;
+
+	test_cmp("MTY_ParallelFor", ok);
+
+	// Every chunk of a range wider than INT64_MAX adds up to UINT64_MAX, or -1
+	MTY_Atomic64 width = {0};
+	MTY_ParallelFor(INT64_MIN, INT64_MAX, INT64_MAX / 8, test_parallel_for_width, &width);
+	test_cmp("MTY_ParallelFor (Full Range)", MTY_Atomic64Get(&width) == -1);
+
+	MTY_Atomic32 counter = {0};
+	MTY_TaskGroup *group = MTY_TaskGroupCreate();
+	test_cmp("MTY_TaskGroupCreate", group != NULL);
+
+	for (int32_t i = 0; i < test_thread_count; i++)
+		MTY_TaskGroupRun(group, test_task_group_func, &counter);
+
+	MTY_TaskGroupWait(group);
+	test_cmp("MTY_TaskGroupWait", MTY_Atomic32Get(&counter) == test_thread_count);
+
+	MTY_TaskGroupRun(group, test_task_group_nested, values);
+	MTY_TaskGroupDestroy(&group);
+	test_cmp("MTY_TaskGroupDestroy", group == NULL);
+
+	ok = true;
+	for (int64_t x = 0; x < test_parallel_count; x++)
+		ok = ok && values[x] == x * 2;
+
+	test_cmp("MTY_ParallelFor (Nested)", ok);
+
+	free(values);
+
+	return true;
+}
+
 struct test_rw_lock_data {
 	int32_t counter;
 	MTY_Cond *cond;
@@ -161,12 +277,213 @@ static bool test_rw_locks()
 	MTY_RWLockDestroy(&data.rw_lock);
 	test_cmp("MTY_RWLockDestroy", data.rw_lock == NULL);
 
+	// More instances than the old fixed table allowed, several held at once
+	MTY_RWLock **many = calloc(1000, sizeof(MTY_RWLock *));
+	bool ok = true;
+
+	for (int32_t i = 0; i < 1000; i++) {
+		many[i] = MTY_RWLockCreate();
+		MTY_RWLockReader(many[i]);
+
+		if (i > 0) {
+			MTY_RWLockWriter(many[i - 1]);
+			ok = ok && MTY_RWTryLockReader(many[i]);
+			MTY_RWLockUnlock(many[i]);
+			MTY_RWLockUnlock(many[i - 1]);
+			MTY_RWLockUnlock(many[i - 1]);
+		}
+	}
+
+	MTY_RWLockUnlock(many[999]);
+
+	for (int32_t i = 0; i < 1000; i++)
+		MTY_RWLockDestroy(&many[i]);
+
+	test_cmp("MTY_RWLockCreate (Many)", ok);
+	free(many);
+
 	MTY_CondDestroy(&data.cond);
 	MTY_MutexDestroy(&data.mutex);
 
 	return true;
 }
 
+struct test_rw_bias_data {
+	MTY_RWLock *rw_lock;
+	int32_t value;
+	MTY_Atomic32 torn;
+};
+
+static void *test_thread_rw_bias(void *opaque)
+{
+	struct test_rw_bias_data *data = (struct test_rw_bias_data *) opaque;
+
+	for (int32_t i = 0; i < 1000; i++) {
+		if (i % 50 == 0) {
+			MTY_RWLockWriter(data->rw_lock);
+			data->value++;
+			MTY_RWLockUnlock(data->rw_lock);
+
+		} else {
+			MTY_RWLockReader(data->rw_lock);
+			int32_t v = data->value;
+			MTY_RWLockReader(data->rw_lock);
+			if (data->value != v)
+				MTY_Atomic32Add(&data->torn, 1);
+			MTY_RWLockUnlock(data->rw_lock);
+			MTY_RWLockUnlock(data->rw_lock);
+		}
+	}
+
+	return NULL;
+}
+
+static bool test_rw_locks_biased()
+{
+	struct test_rw_bias_data data = {0};
+	data.rw_lock = MTY_RWLockCreateBiased();
+	test_cmp("MTY_RWLockCreateBiased", data.rw_lock != NULL);
+
+	MTY_Thread *t_test[8] = {0};
+	for (int32_t i = 0; i < 8; i++)
+		t_test[i] = MTY_ThreadCreate(test_thread_rw_bias, &data);
+
+	for (int32_t i = 0; i < 8; i++)
+		MTY_ThreadDestroy(&t_test[i]);
+
+	test_cmp("MTY_RWLock biased counter", data.value == 8 * 20);
+	test_cmp("MTY_RWLock biased readers", MTY_Atomic32Get(&data.torn) == 0);
+
+	MTY_RWLockDestroy(&data.rw_lock);
+
+	return true;
+}
+
+struct test_atomic_data {
+	MTY_Atomic32 counter;
+	MTY_AtomicPtr ptr;
+	int32_t payload;
+};
+
+static void *test_thread_atomic(void *opaque)
+{
+	struct test_atomic_data *data = (struct test_atomic_data *) opaque;
+
+	for (int32_t x = 0; x < 10000; x++)
+		MTY_Atomic32AddEx(&data->counter, 1, MTY_MEMORY_ORDER_RELAXED);
+
+	return NULL;
+}
+
+static void *test_thread_atomic_publish(void *opaque)
+{
+	struct test_atomic_data *data = (struct test_atomic_data *) opaque;
+
+	data->payload = 42;
+	MTY_AtomicPtrSet(&data->ptr, &data->payload, MTY_MEMORY_ORDER_RELEASE);
+
+	return NULL;
+}
+
+static bool test_atomics()
+{
+	struct test_atomic_data data = {0};
+
+	MTY_Atomic32SetEx(&data.counter, 5, MTY_MEMORY_ORDER_RELEASE);
+	test_cmp("MTY_Atomic32GetEx", MTY_Atomic32GetEx(&data.counter, MTY_MEMORY_ORDER_ACQUIRE) == 5);
+	test_cmp("MTY_Atomic32CASEx", !MTY_Atomic32CASEx(&data.counter, 4, 6, MTY_MEMORY_ORDER_ACQ_REL));
+	test_cmp("MTY_Atomic32CASEx", MTY_Atomic32CASEx(&data.counter, 5, 0, MTY_MEMORY_ORDER_ACQ_REL));
+
+	MTY_Atomic64 a64 = {0};
+	MTY_Atomic64SetEx(&a64, INT64_MAX - 1, MTY_MEMORY_ORDER_RELAXED);
+	test_cmp("MTY_Atomic64AddEx", MTY_Atomic64AddEx(&a64, 1, MTY_MEMORY_ORDER_RELAXED) == INT64_MAX);
+	test_cmp("MTY_Atomic64CASEx", MTY_Atomic64CASEx(&a64, INT64_MAX, 7, MTY_MEMORY_ORDER_RELEASE));
+	test_cmp("MTY_Atomic64GetEx", MTY_Atomic64GetEx(&a64, MTY_MEMORY_ORDER_SEQ_CST) == 7);
+
+	int32_t a = 0;
+	int32_t b = 0;
+	MTY_AtomicPtrSet(&data.ptr, &a, MTY_MEMORY_ORDER_RELAXED);
+	test_cmp("MTY_AtomicPtrGet", MTY_AtomicPtrGet(&data.ptr, MTY_MEMORY_ORDER_ACQUIRE) == &a);
+	test_cmp("MTY_AtomicPtrExchange", MTY_AtomicPtrExchange(&data.ptr, &b, MTY_MEMORY_ORDER_ACQ_REL) == &a);
+	test_cmp("MTY_AtomicPtrCAS", !MTY_AtomicPtrCAS(&data.ptr, &a, NULL, MTY_MEMORY_ORDER_ACQ_REL));
+	test_cmp("MTY_AtomicPtrCAS", MTY_AtomicPtrCAS(&data.ptr, &b, &a, MTY_MEMORY_ORDER_ACQ_REL));
+
+	// Tag the low bit of an aligned pointer
+	test_cmp("MTY_AtomicPtrOr", MTY_AtomicPtrOr(&data.ptr, 1, MTY_MEMORY_ORDER_RELAXED) == &a);
+	test_cmp("MTY_AtomicPtrOr", (uintptr_t) MTY_AtomicPtrGet(&data.ptr, MTY_MEMORY_ORDER_RELAXED) == ((uintptr_t) &a | 1));
+	test_cmp("MTY_AtomicPtrAnd", (uintptr_t) MTY_AtomicPtrAnd(&data.ptr, ~(uintptr_t) 1, MTY_MEMORY_ORDER_RELAXED) == ((uintptr_t) &a | 1));
+	test_cmp("MTY_AtomicPtrAnd", MTY_AtomicPtrGet(&data.ptr, MTY_MEMORY_ORDER_RELAXED) == &a);
+
+	MTY_Thread *threads[4] = {0};
+	for (uint32_t x = 0; x < 4; x++)
+		threads[x] = MTY_ThreadCreate(test_thread_atomic, &data);
+
+	for (uint32_t x = 0; x < 4; x++)
+		MTY_ThreadDestroy(&threads[x]);
+
+	test_cmp("MTY_Atomic32AddEx", MTY_Atomic32GetEx(&data.counter, MTY_MEMORY_ORDER_RELAXED) == 40000);
+
+	MTY_AtomicPtrSet(&data.ptr, NULL, MTY_MEMORY_ORDER_RELAXED);
+	MTY_Thread *t = MTY_ThreadCreate(test_thread_atomic_publish, &data);
+
+	int32_t *payload = NULL;
+	while (!(payload = MTY_AtomicPtrGet(&data.ptr, MTY_MEMORY_ORDER_ACQUIRE)))
+		MTY_Sleep(0);
+
+	test_cmp("MTY_AtomicPtrGet", *payload == 42);
+	MTY_ThreadDestroy(&t);
+
+	return true;
+}
+
+static MTY_Once test_once;
+static int32_t test_once_value;
+
+static void test_once_func(void *opaque)
+{
+	// Slow enough that the other threads arrive while this is running
+	MTY_Sleep(50);
+	test_once_value++;
+}
+
+static void *test_thread_once(void *opaque)
+{
+	MTY_CallOnce(&test_once, test_once_func, NULL);
+
+	MTY_Atomic32Add((MTY_Atomic32 *) opaque, test_once_value);
+
+	return NULL;
+}
+
+static bool test_call_once()
+{
+	MTY_Atomic32 seen = {0};
+	MTY_Thread *threads[8] = {0};
+
+	for (uint32_t x = 0; x < 8; x++)
+		threads[x] = MTY_ThreadCreate(test_thread_once, &seen);
+
+	for (uint32_t x = 0; x < 8; x++)
+		MTY_ThreadDestroy(&threads[x]);
+
+	test_cmp("MTY_CallOnce", test_once_value == 1);
+	test_cmp("MTY_CallOnce", MTY_Atomic32Get(&seen) == 8);
+
+	MTY_CallOnce(&test_once, test_once_func, NULL);
+	test_cmp("MTY_CallOnce", test_once_value == 1);
+
+	// More global locks than the previous fixed table could hold
+	static MTY_Atomic32 glocks[300];
+	for (uint32_t x = 0; x < 300; x++) {
+		MTY_GlobalLock(&glocks[x]);
+		MTY_GlobalUnlock(&glocks[x]);
+	}
+
+	test_cmp("MTY_GlobalLock", MTY_Atomic32Get(&glocks[299]) > 1);
+
+	return true;
+}
+
 struct test_waitable_data {
 	MTY_Waitable *wait;
 	MTY_Atomic32 atomic_32;
@@ -245,6 +562,55 @@ static bool test_waitables()
 	return true;
 }
 
+static void *test_thread_waitable_pollable(void *opaque)
+{
+	MTY_Sleep(20);
+	MTY_WaitableSignal((MTY_Waitable *) opaque);
+
+	return NULL;
+}
+
+static bool test_waitables_pollable()
+{
+	MTY_Waitable *wait = MTY_WaitableCreatePollable();
+	test_cmp("MTY_WaitableCreatePollable", wait != NULL);
+
+	MTY_Waitable *plain = MTY_WaitableCreate();
+	test_cmp("MTY_WaitableGetFD", MTY_WaitableGetFD(plain) == -1);
+	MTY_WaitableDestroy(&plain);
+
+	test_cmp("MTY_WaitableWait", !MTY_WaitableWait(wait, 0));
+
+	// Multiple signals collapse into a single wakeup
+	MTY_WaitableSignal(wait);
+	MTY_WaitableSignal(wait);
+	test_cmp("MTY_WaitableWait", MTY_WaitableWait(wait, 0));
+	test_cmp("MTY_WaitableWait", !MTY_WaitableWait(wait, 10));
+
+	#if defined(__linux__)
+		struct pollfd fd = {0};
+		fd.fd = MTY_WaitableGetFD(wait);
+		fd.events = POLLIN;
+		test_cmp("MTY_WaitableGetFD", fd.fd >= 0);
+		test_cmp("poll", poll(&fd, 1, 0) == 0);
+
+		MTY_Thread *t = MTY_ThreadCreate(test_thread_waitable_pollable, wait);
+		test_cmp("poll", poll(&fd, 1, 5000) == 1 && (fd.revents & POLLIN));
+		test_cmp("MTY_WaitableWait", MTY_WaitableWait(wait, 0));
+		test_cmp("poll", poll(&fd, 1, 0) == 0);
+		MTY_ThreadDestroy(&t);
+	#endif
+
+	MTY_Thread *t2 = MTY_ThreadCreate(test_thread_waitable_pollable, wait);
+	test_cmp("MTY_WaitableWait", MTY_WaitableWait(wait, 5000));
+	MTY_ThreadDestroy(&t2);
+
+	MTY_WaitableDestroy(&wait);
+	test_cmp("MTY_WaitableDestroy", wait == NULL);
+
+	return true;
+}
+
 struct test_cond_data {
 	int32_t counter;
 	MTY_Mutex *mutex;
@@ -438,6 +804,36 @@ static bool test_thread_creation()
 	return true;
 }
 
+static bool test_thread_attributes()
+{
+	struct test_thread_data data = {0};
+	MTY_Thread *t_test = MTY_ThreadCreate(test_thread_1, &data);
+
+	uint32_t num_cpu = MTY_GetNumProcessors();
+	uint64_t mask = num_cpu >= 64 ? UINT64_MAX : (1ull << num_cpu) - 1;
+
+	// Lowering priority never requires elevated privileges
+	bool priority = MTY_ThreadSetPriority(t_test, MTY_THREAD_PRIORITY_LOW);
+	bool affinity = MTY_ThreadSetAffinity(t_test, mask);
+	bool name = MTY_ThreadSetName(t_test, "test_thread_attributes");
+
+	#if defined(__linux__) || defined(_WIN32)
+		test_cmp("MTY_ThreadSetPriority", priority);
+		test_cmp("MTY_ThreadSetAffinity", affinity);
+		test_cmp("MTY_ThreadSetAffinity", MTY_ThreadSetAffinity(NULL, mask));
+		test_cmp("MTY_ThreadSetName", MTY_ThreadSetName(NULL, "MTY_Test"));
+	#endif
+
+	#if defined(__linux__)
+		test_cmp("MTY_ThreadSetName", name);
+	#endif
+
+	MTY_ThreadDestroy(&t_test);
+	test_cmp("MTY_Thread executed", data.executed);
+
+	return true;
+}
+
 static bool thread_main()
 {
 	MTY_SetTimerResolution(1);
@@ -450,15 +846,36 @@ static bool thread_main()
 	if (!test_thread_creation())
 		return false;
 
+	if (!test_thread_attributes())
+		return false;
+
 	if (!test_threadpools())
 		return false;
 
+	if (!test_threadpools_queued())
+		return false;
+
+	if (!test_task_groups())
+		return false;
+
 	if (!test_rw_locks())
 		return false;
 
+	if (!test_rw_locks_biased())
+		return false;
+
+	if (!test_atomics())
+		return false;
+
+	if (!test_call_once())
+		return false;
+
 	if (!test_waitables())
 		return false;
 
+	if (!test_waitables_pollable())
+		return false;
+
 	MTY_RevertTimerResolution(1);
 
 	return true;